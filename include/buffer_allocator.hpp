@@ -0,0 +1,78 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <vector>
+
+#define TLSF_SL_LOG2 5
+#define TLSF_SL_COUNT (1 << TLSF_SL_LOG2)
+#define TLSF_GRANULARITY_LOG2 4
+#define TLSF_FL_SHIFT (TLSF_SL_LOG2 + TLSF_GRANULARITY_LOG2)
+#define TLSF_FL_COUNT (32 - TLSF_FL_SHIFT + 1)
+
+struct BufferAllocation {
+    SDL_GPUBuffer* buffer;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t block;
+};
+
+// Ranges of a page's buffer, linked in address order and, when free, into their size class list.
+// They live outside the buffer since GPU memory can't hold the bookkeeping.
+struct TlsfBlock {
+    uint32_t offset;
+    uint32_t size;
+    uint32_t page;
+    uint32_t previousPhysical;
+    uint32_t nextPhysical;
+    uint32_t previousFree;
+    uint32_t nextFree;
+    bool free;
+};
+
+struct BufferPage {
+    SDL_GPUBuffer* buffer;
+    uint32_t size;
+    uint32_t firstLevelBitmap;
+    uint32_t secondLevelBitmaps[TLSF_FL_COUNT];
+    uint32_t freeLists[TLSF_FL_COUNT][TLSF_SL_COUNT];
+};
+
+struct BufferAllocatorStats {
+    uint32_t pageCount;
+    uint32_t allocationCount;
+    uint64_t capacity;
+    uint64_t usedBytes;
+    uint64_t freeBytes;
+    uint32_t freeBlockCount;
+    uint32_t largestFreeBlock;
+    // 0 when all free space is one block, approaching 1 as it splinters
+    float fragmentation;
+};
+
+// Two-level segregated fit allocator handing out ranges of a few large SDL_GPUBuffers.
+// Allocation and free are O(1); a new page is only created when no existing page fits.
+struct GPUBufferAllocator {
+    SDL_GPUBufferUsageFlags usage;
+    uint32_t pageSize;
+    std::vector<BufferPage> pages;
+    std::vector<TlsfBlock> blocks;
+    uint32_t unusedBlocks;
+    uint32_t allocationCount;
+    uint64_t usedBytes;
+};
+
+void CreateBufferAllocator(GPUBufferAllocator* allocator, SDL_GPUBufferUsageFlags usage, uint32_t pageSize);
+void DestroyBufferAllocator(SDL_GPUDevice* GPUDevice, GPUBufferAllocator* allocator);
+
+// alignment must be a power of two; sizes are rounded up to 16 bytes
+bool BufferAlloc(
+    SDL_GPUDevice* GPUDevice,
+    GPUBufferAllocator* allocator,
+    uint32_t size,
+    uint32_t alignment,
+    BufferAllocation* allocation
+);
+void BufferFree(GPUBufferAllocator* allocator, BufferAllocation* allocation);
+
+BufferAllocatorStats GetBufferAllocatorStats(const GPUBufferAllocator* allocator);
+void LogBufferAllocatorStats(const char* name, const GPUBufferAllocator* allocator);
@@ -0,0 +1,93 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+#include <cstdint>
+
+#define MAX_RECORDING_WORKERS 16
+#define MAX_RECORDING_JOBS 64
+
+// Records into a command buffer acquired on the thread it runs on. The job must not touch
+// the swapchain texture, see RecordFrame.
+typedef void (*RecordCommands)(SDL_GPUCommandBuffer* commandBuffer, void* userData);
+
+struct RecordingJob {
+    const char* name;
+    RecordCommands record;
+    void* userData;
+
+    // Filled in by RecordFrame
+    bool succeeded;
+    int workerIndex;
+    Uint64 durationNS;
+};
+
+struct CommandRecorder;
+
+struct RecordingWorker {
+    CommandRecorder* recorder;
+    int index;
+};
+
+struct CommandRecorderStats {
+    // Of the last frame. Recording is the sum over jobs; wall time is RecordFrame's, so their
+    // ratio is how many cores recording effectively used.
+    uint32_t frameJobs;
+    Uint64 frameRecordNS;
+    Uint64 frameWallNS;
+    // Time workers spent holding a recorded command buffer until the ones before it were submitted
+    Uint64 frameSubmitWaitNS;
+
+    uint64_t totalFrames;
+    uint64_t totalJobs;
+    uint64_t failedJobs;
+};
+
+// Persistent worker threads that record disjoint parts of a frame (shadow passes, the main
+// pass, post) into command buffers of their own. SDL command buffers may only be used on the
+// thread that acquired them, so each job's thread also submits its buffer, waiting until every
+// job added before it has been submitted: the GPU sees the jobs in the order they were added,
+// however the recording was spread. The calling thread records too. Workers point back at
+// the recorder, so it must not move after CreateCommandRecorder.
+struct CommandRecorder {
+    SDL_GPUDevice* GPUDevice;
+    int workerCount;
+    SDL_Thread* threads[MAX_RECORDING_WORKERS];
+    RecordingWorker workers[MAX_RECORDING_WORKERS];
+
+    SDL_Mutex* mutex;
+    // Wakes the workers for a new frame or to quit
+    SDL_Condition* frameReady;
+    // Signalled after every submission and when a worker is done with the frame
+    SDL_Condition* submitted;
+    uint64_t frame;
+    bool quitting;
+    // Worker threads done with the frame; RecordFrame waits for all of them so none can
+    // still be looking at the jobs when the next frame's are added
+    int finishedWorkers;
+
+    RecordingJob jobs[MAX_RECORDING_JOBS];
+    uint32_t jobCount;
+    SDL_AtomicInt nextJob;
+    // Guarded by mutex: the job whose command buffer is submitted next
+    uint32_t nextSubmit;
+    Uint64 submitWaitNS;
+
+    CommandRecorderStats stats;
+};
+
+// workerCount 0 uses one worker per logical core, the calling thread included
+bool CreateCommandRecorder(SDL_GPUDevice* GPUDevice, CommandRecorder* recorder, int workerCount);
+void DestroyCommandRecorder(CommandRecorder* recorder);
+
+void BeginRecording(CommandRecorder* recorder);
+// Jobs are submitted in the order they are added. Returns false when the frame is full.
+bool AddRecordingJob(CommandRecorder* recorder, const char* name, RecordCommands record, void* userData);
+// Records and submits every job, returning once all are submitted. Work the jobs depend on,
+// like FlushUploads, must be submitted before. The swapchain texture is tied to the command
+// buffer that acquired it, so jobs render offscreen and that command buffer, submitted after
+// RecordFrame, does the final pass onto the swapchain. Returns false if a job failed to record.
+bool RecordFrame(CommandRecorder* recorder);
+
+const CommandRecorderStats* GetCommandRecorderStats(const CommandRecorder* recorder);
+void LogCommandRecorderStats(const CommandRecorder* recorder);
@@ -23,20 +23,21 @@ void GeneralQuit(Context* context);
 void InitAssetLoader();
 SDL_Surface* LoadImage(const std::string& imageFileName, int channels);
 
-SDL_GPUShader* LoadShader(
+// Fills everything but the code of a shader create-info from the reflection metadata
+// and writes where the shader's .spv lives to fullPath
+bool GetShaderCreateInfo(
     SDL_GPUDevice* GPUDevice,
     const std::string& fileName,
-    uint32_t samplerCount,
-    uint32_t uniformBufferCount,
-    uint32_t storageBufferCount,
-    uint32_t storageTextureCount
+    SDL_GPUShaderCreateInfo* createInfo,
+    char* fullPath,
+    size_t fullPathSize
 );
 
-SDL_GPUComputePipeline* CreateComputePipelineFromShader(
-    SDL_GPUDevice* GPUDevice,
-    const std::string& shaderFileName,
-    SDL_GPUComputePipelineCreateInfo* createInfo
-);
+// Stage and resource counts come from the build-time reflection table (shader_metadata.hpp).
+// Shaders are shared through the shader cache: drop them with ReleaseShader, not SDL_ReleaseGPUShader
+SDL_GPUShader* LoadShader(SDL_GPUDevice* GPUDevice, const std::string& fileName);
+
+SDL_GPUComputePipeline* CreateComputePipelineFromShader(SDL_GPUDevice* GPUDevice, const std::string& shaderFileName);
 
 struct PositionVertex {
     float x, y, z;
@@ -69,6 +70,10 @@ Matrix4x4 Matrix4x4_CreateRotationZ(float radians);
 Matrix4x4 Matrix4x4_CreateTranslation(float x, float y, float z);
 Matrix4x4 Matrix4x4_CreateOrthographicOffCenter(float left, float right, float bottom, float top, float zNearPlane, float zFarPlane);
 Matrix4x4 Matrix4x4_CreatePerspectiveFieldOfView(float fieldOfView, float aspectRatio, float nearPlaneDistance, float farPlaneDistance);
+// Reversed-Z: depth 1 at the near plane, 0 at the far plane (or at infinity). Clear depth to 0
+// and test with GREATER_OR_EQUAL, see depth_buffer.hpp.
+Matrix4x4 Matrix4x4_CreatePerspectiveFieldOfViewReversedZ(float fieldOfView, float aspectRatio, float nearPlaneDistance, float farPlaneDistance);
+Matrix4x4 Matrix4x4_CreatePerspectiveFieldOfViewInfiniteReversedZ(float fieldOfView, float aspectRatio, float nearPlaneDistance);
 Matrix4x4 Matrix4x4_CreateLookAt(Vector3 cameraPosition, Vector3 cameraTarget, Vector3 cameraUpVector);
 Vector3 Vector3_Normalize(Vector3 vec);
 float Vector3_Dot(Vector3 vecA, Vector3 vecB);
@@ -0,0 +1,27 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+
+// Reversed-Z clears to the far plane, 0, and nearer fragments have greater depth
+#define REVERSED_Z_CLEAR_DEPTH 0.0f
+
+enum DepthMode {
+    DEPTH_MODE_NONE,
+    // Reversed-Z test and write in the one pass
+    DEPTH_MODE_TEST,
+    // A depth-only pass lays down the nearest depth first, then the main pass tests EQUAL
+    // without writing, so its fragment shader runs once per pixel
+    DEPTH_MODE_PRE_PASS,
+};
+
+// D32_FLOAT when the device has it, reversed-Z only pays off with a float depth buffer
+SDL_GPUTextureFormat ChooseDepthFormat(SDL_GPUDevice* GPUDevice);
+
+// Reversed-Z depth state for a pipeline drawn in the main pass of mode
+SDL_GPUDepthStencilState DepthTestState(DepthMode mode);
+// Adds the depth target and test of mode to a pipeline; DEPTH_MODE_NONE leaves it untouched
+void SetPipelineDepth(SDL_GPUGraphicsPipelineCreateInfo* createInfo, SDL_GPUTextureFormat depthFormat, DepthMode mode);
+// The pre-pass pipeline for a main pass pipeline: same vertex input and rasterizer state, no
+// color targets, writing depth. The fragment shader must be replaced by depthOnly.frag, which
+// InitGraphicsPipelineVariants does given the name. The vertex shader must be the main pass's
+// so both passes compute the same depth.
+SDL_GPUGraphicsPipelineCreateInfo DepthPrePassCreateInfo(const SDL_GPUGraphicsPipelineCreateInfo* createInfo, SDL_GPUTextureFormat depthFormat);
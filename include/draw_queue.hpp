@@ -0,0 +1,145 @@
+#pragma once
+#include "mesh_pool.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Bit layout of a draw's sort key, most significant first. Pipelines, textures and materials
+// are keyed by small ids; past the field width ids wrap, which only costs sorting quality.
+#define DRAW_KEY_PASS_BITS 4
+#define DRAW_KEY_PIPELINE_BITS 12
+#define DRAW_KEY_TEXTURE_BITS 14
+#define DRAW_KEY_MATERIAL_BITS 14
+#define DRAW_KEY_DEPTH_BITS 20
+static_assert(DRAW_KEY_PASS_BITS + DRAW_KEY_PIPELINE_BITS + DRAW_KEY_TEXTURE_BITS + DRAW_KEY_MATERIAL_BITS + DRAW_KEY_DEPTH_BITS == 64);
+
+#define DRAW_QUEUE_MAX_PASSES (1u << DRAW_KEY_PASS_BITS)
+#define DRAW_MATERIAL_NONE 0xFFFFFFFFu
+
+enum DrawOrder {
+    // State first, then near to far within the same state: fewest binds, early depth rejection
+    DRAW_ORDER_STATE,
+    // Depth above state in the key, far to near, for blended draws that must be ordered
+    DRAW_ORDER_BACK_TO_FRONT,
+};
+
+struct DrawDesc {
+    uint32_t pass;
+    SDL_GPUGraphicsPipeline* pipeline;
+    // Bound to fragment sampler slot 0, nothing is bound when NULL
+    SDL_GPUTexture* texture;
+    SDL_GPUSampler* sampler;
+    // From AddDrawMaterial, or DRAW_MATERIAL_NONE
+    uint32_t material;
+    MeshHandle mesh;
+    uint32_t instanceCount;
+    uint32_t firstInstance;
+    // View space distance, negative counts as 0
+    float depth;
+    // Copied, pushed to vertex uniform slot 0 before the draw when not NULL
+    const void* vertexUniforms;
+    uint32_t vertexUniformsSize;
+};
+
+struct DrawPacket {
+    SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUTexture* texture;
+    SDL_GPUSampler* sampler;
+    uint32_t material;
+    MeshHandle mesh;
+    uint32_t instanceCount;
+    uint32_t firstInstance;
+    uint32_t vertexUniformsOffset;
+    uint32_t vertexUniformsSize;
+};
+
+struct DrawMaterial {
+    uint32_t offset;
+    uint32_t size;
+};
+
+// Written only by the pass's own RenderDraws, so passes of one queue can be recorded on
+// different threads
+struct DrawPassStats {
+    uint32_t draws;
+    uint32_t pipelineBinds;
+    uint32_t samplerBinds;
+    uint32_t materialPushes;
+    uint32_t bufferBinds;
+    // SDL_BindGPU* calls and uniform pushes that were filtered out because the state was bound
+    uint32_t skippedBinds;
+};
+
+struct DrawQueueStats {
+    // Of the last frame. State changes counts pipeline, texture and material switches between
+    // consecutive draws, in submission order and in sorted order.
+    uint32_t frameDraws;
+    uint32_t unsortedStateChanges;
+    uint32_t sortedStateChanges;
+    // Key bytes the radix sort skipped because every draw had the same value there
+    uint32_t skippedSortPasses;
+
+    // Pass stats are added in by BeginDraws
+    uint64_t totalDraws;
+    uint64_t totalBinds;
+    uint64_t totalSkippedBinds;
+    uint64_t sortNS;
+};
+
+// Collects a frame's draws as packets with a 64-bit sort key packing pass, pipeline, texture,
+// material and depth, sorts them with an LSD radix sort and records each pass in one go,
+// skipping binds of state that is already bound. Draws with equal keys keep submission order.
+struct DrawQueue {
+    DrawOrder passOrder[DRAW_QUEUE_MAX_PASSES];
+    std::unordered_map<SDL_GPUGraphicsPipeline*, uint32_t> pipelineIds;
+    std::unordered_map<SDL_GPUTexture*, uint32_t> textureIds;
+    std::vector<DrawMaterial> materials;
+    std::vector<uint8_t> materialData;
+
+    std::vector<DrawPacket> packets;
+    std::vector<uint64_t> keys;
+    std::vector<uint8_t> vertexUniforms;
+    // Packet indices in draw order and the radix sort's scratch
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> orderScratch;
+    std::vector<uint64_t> keyScratch;
+    // Range of order per pass
+    uint32_t passStart[DRAW_QUEUE_MAX_PASSES + 1];
+    bool sorted;
+    DrawPassStats passStats[DRAW_QUEUE_MAX_PASSES];
+    DrawQueueStats stats;
+};
+
+void CreateDrawQueue(DrawQueue* queue);
+void DestroyDrawQueue(DrawQueue* queue);
+// Every pass is DRAW_ORDER_STATE until set otherwise
+void SetDrawPassOrder(DrawQueue* queue, uint32_t pass, DrawOrder order);
+
+// Fragment uniform data for slot 0, copied. Returns the material's id.
+uint32_t AddDrawMaterial(DrawQueue* queue, const void* fragmentUniforms, uint32_t size);
+void UpdateDrawMaterial(DrawQueue* queue, uint32_t material, const void* fragmentUniforms);
+
+void BeginDraws(DrawQueue* queue);
+void SubmitDraw(DrawQueue* queue, const DrawDesc* draw);
+// Sorts the frame's draws, after the last SubmitDraw
+void SortDraws(DrawQueue* queue);
+// Records one pass's draws, binding the pool's buffers only when they change. Only reads the
+// pool, so different passes may be recorded at the same time on different threads.
+void RenderDraws(DrawQueue* queue, const MeshPool* pool, SDL_GPUCommandBuffer* commandBuffer, SDL_GPURenderPass* renderPass, uint32_t pass);
+
+uint64_t MakeDrawKey(uint32_t pass, DrawOrder order, uint32_t pipelineId, uint32_t textureId, uint32_t materialId, float depth);
+// Sorts keys and carries values along, stable; scratch buffers are resized as needed.
+// Returns the number of byte passes skipped.
+uint32_t RadixSortKeys(
+    uint64_t* keys,
+    uint32_t* values,
+    uint32_t count,
+    std::vector<uint64_t>* keyScratch,
+    std::vector<uint32_t>* valueScratch
+);
+
+const DrawQueueStats* GetDrawQueueStats(const DrawQueue* queue);
+// All passes of the last frame
+DrawPassStats SumDrawPassStats(const DrawQueue* queue);
+void LogDrawQueueStats(const DrawQueue* queue);
@@ -0,0 +1,57 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+
+// Weight of the newest frame time in the running average
+#define DYNAMIC_RESOLUTION_SMOOTHING 0.1f
+// Frames a new scale is left alone, so it reaches the average through the frames in flight
+#define DYNAMIC_RESOLUTION_SETTLE_FRAMES 8
+// Largest scale change per adjustment
+#define DYNAMIC_RESOLUTION_MAX_STEP 0.1f
+// The scale only goes up again when frames are this far under the target, so it does not
+// oscillate around it
+#define DYNAMIC_RESOLUTION_HEADROOM 0.85f
+
+struct DynamicResolutionStats {
+    uint64_t scaleChanges;
+    uint64_t framesBelowFull;
+    uint64_t frames;
+    float lowestScale;
+};
+
+// Scales the scene's resolution, as a fraction of the output's width and height, to hold a
+// target frame time. The pixel count goes with the square of the scale, so a frame that takes
+// k times the target asks for 1 / sqrt(k) of the scale, limited per step.
+struct DynamicResolution {
+    float targetFrameMS;
+    float minScale;
+    float maxScale;
+    float scale;
+    float averageFrameMS;
+    uint32_t framesSinceChange;
+    DynamicResolutionStats stats;
+};
+
+void InitDynamicResolution(DynamicResolution* resolution, float targetFrameMS, float minScale, float maxScale);
+// Feeds what the last frame cost and returns the scale for the next one. Pass the longer of
+// the CPU's work and the GPU's busy time (see StagingRingStats::gpuBusyNS); a GPU-bound frame
+// only shows up in the latter. Time the CPU spends blocked on the swapchain or presentation
+// must stay out: with vsync it stretches every frame to at least the refresh interval, so a
+// frame that fits would still look over the target and the scale would only ever go down.
+float UpdateDynamicResolution(DynamicResolution* resolution, Uint64 frameNS);
+// The scaled size of a width x height output, even and at least 2 pixels
+void GetScaledResolution(const DynamicResolution* resolution, uint32_t width, uint32_t height, uint32_t* scaledWidth, uint32_t* scaledHeight);
+
+// Stretches the top left sourceWidth x sourceHeight of source over all of destination, filtered
+void UpscaleTexture(
+    SDL_GPUCommandBuffer* commandBuffer,
+    SDL_GPUTexture* source,
+    uint32_t sourceWidth,
+    uint32_t sourceHeight,
+    SDL_GPUTexture* destination,
+    uint32_t destinationWidth,
+    uint32_t destinationHeight
+);
+
+const DynamicResolutionStats* GetDynamicResolutionStats(const DynamicResolution* resolution);
+void LogDynamicResolutionStats(const DynamicResolution* resolution);
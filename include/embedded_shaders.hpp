@@ -0,0 +1,17 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Compiled shaders built into the executable when configured with -DEMBED_SHADERS=ON.
+// The table is generated by tools/shader_embed.cpp and sorted by name.
+struct EmbeddedShader {
+    const char* name;
+    const uint8_t* code;
+    size_t codeSize;
+};
+
+extern const EmbeddedShader embeddedShaders[];
+extern const size_t embeddedShaderCount;
+
+// name is the shader file name without the .spv extension, e.g. "solidColor.frag"
+const EmbeddedShader* FindEmbeddedShader(const char* name);
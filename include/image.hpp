@@ -0,0 +1,33 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <cstddef>
+#include <cstdint>
+
+// All decoders return an SDL_PIXELFORMAT_RGBA32 surface, or NULL with SDL_GetError() set.
+bool IsQOI(const uint8_t* data, size_t size);
+bool IsPNG(const uint8_t* data, size_t size);
+
+SDL_Surface* DecodeQOI(const uint8_t* data, size_t size);
+SDL_Surface* DecodePNG(const uint8_t* data, size_t size);
+
+// Picks the decoder from the file magic (falls back to BMP) and records decode stats
+SDL_Surface* DecodeImage(const uint8_t* data, size_t size);
+
+enum ImageFormat {
+    IMAGE_FORMAT_BMP,
+    IMAGE_FORMAT_QOI,
+    IMAGE_FORMAT_PNG,
+    IMAGE_FORMAT_COUNT
+};
+
+struct ImageDecodeStats {
+    uint32_t imageCount;
+    uint64_t inputBytes;
+    uint64_t outputBytes;
+    uint64_t decodeNS;
+};
+
+// Accumulated by LoadImage, one entry per ImageFormat
+const ImageDecodeStats* GetImageDecodeStats(ImageFormat format);
+double ImageDecodeThroughputMBs(const ImageDecodeStats* stats);
+void LogImageDecodeStats();
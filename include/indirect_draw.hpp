@@ -0,0 +1,87 @@
+#pragma once
+#include "common.hpp"
+#include "mesh_pool.hpp"
+#include "upload_queue.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <vector>
+
+// Mirrors DrawObject in cullDraws.comp.hlsl (std430)
+struct IndirectDrawObject {
+    // World space bounding sphere
+    float center[3];
+    float radius;
+    // Absolute in the mesh pool's buffers, like PooledMesh
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t vertexOffset;
+    // Passed to the draw, lets the vertex shader find the object's per-instance data
+    uint32_t firstInstance;
+};
+
+// Objects whose meshes share a pool page, drawn by one indirect call
+struct IndirectDrawRun {
+    SDL_GPUBuffer* vertexBuffer;
+    SDL_GPUBuffer* indexBuffer;
+    SDL_GPUIndexElementSize indexElementSize;
+    uint32_t firstObject;
+    uint32_t objectCount;
+};
+
+struct IndirectDrawStats {
+    // Reset by PrepareIndirectDraws
+    uint32_t frameObjects;
+    uint32_t frameIndirectDraws;
+
+    uint64_t objectUploads;
+    uint64_t totalDispatches;
+    uint64_t totalIndirectDraws;
+};
+
+// Draws a set of pooled meshes without deciding anything per object on the CPU: a compute pass
+// tests each object's bounds against the frustum and writes its SDL_GPUIndexedIndirectDrawCommand
+// (zero instances when culled) and bumps a visible count, then each run of objects sharing a pool
+// page is one SDL_DrawGPUIndexedPrimitivesIndirect. CPU cost per frame grows with the number of
+// pages, not objects. SDL has no draw count buffer, so culled objects stay as empty draws.
+struct IndirectDrawList {
+    SDL_GPUComputePipeline* cullPipeline;
+    SDL_GPUBuffer* objectBuffer;
+    SDL_GPUBuffer* indirectBuffer;
+    SDL_GPUBuffer* countBuffer;
+    uint32_t capacity;
+
+    // In the order they were added; uploaded grouped by page
+    std::vector<IndirectDrawObject> objects;
+    std::vector<MeshHandle> objectMeshes;
+    std::vector<IndirectDrawRun> runs;
+    bool dirty;
+    IndirectDrawStats stats;
+};
+
+bool CreateIndirectDrawList(SDL_GPUDevice* GPUDevice, IndirectDrawList* list, uint32_t capacity);
+void DestroyIndirectDrawList(SDL_GPUDevice* GPUDevice, IndirectDrawList* list);
+
+// Returns the object's index, or UINT32_MAX when the list is full or the mesh is not in the pool
+uint32_t AddIndirectDrawObject(
+    IndirectDrawList* list,
+    const MeshPool* pool,
+    MeshHandle mesh,
+    const float center[3],
+    float radius,
+    uint32_t firstInstance
+);
+void MoveIndirectDrawObject(IndirectDrawList* list, uint32_t object, const float center[3], float radius);
+void ClearIndirectDrawObjects(IndirectDrawList* list);
+
+// Uploads changed objects and resets the visible count; call before FlushUploads
+bool PrepareIndirectDraws(SDL_GPUDevice* GPUDevice, IndirectDrawList* list, const MeshPool* pool, UploadQueue* uploadQueue);
+// Records the culling compute pass, after FlushUploads and outside any render pass
+void CullIndirectDraws(IndirectDrawList* list, SDL_GPUCommandBuffer* commandBuffer, const Matrix4x4* viewProjection);
+// The pipeline bound on renderPass must take the pool's vertex layout
+void DrawIndirect(IndirectDrawList* list, MeshPool* pool, SDL_GPURenderPass* renderPass);
+
+// Number of objects that passed culling, as a uint32 at offset 0, for readback or later passes
+SDL_GPUBuffer* GetIndirectDrawCountBuffer(const IndirectDrawList* list);
+
+const IndirectDrawStats* GetIndirectDrawStats(const IndirectDrawList* list);
+void LogIndirectDrawStats(const IndirectDrawList* list);
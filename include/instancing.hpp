@@ -0,0 +1,74 @@
+#pragma once
+#include "common.hpp"
+#include "uniform_arena.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+
+#define VERTEX_LAYOUT_MAX_BUFFERS 4
+#define VERTEX_LAYOUT_MAX_ATTRIBUTES 16
+
+// Builds the buffer descriptions and attribute array of a SDL_GPUVertexInputState. Attributes
+// get consecutive locations and are packed in the order they are added.
+struct VertexLayout {
+    SDL_GPUVertexBufferDescription buffers[VERTEX_LAYOUT_MAX_BUFFERS];
+    SDL_GPUVertexAttribute attributes[VERTEX_LAYOUT_MAX_ATTRIBUTES];
+    uint32_t bufferCount;
+    uint32_t attributeCount;
+};
+
+uint32_t VertexElementSize(SDL_GPUVertexElementFormat format);
+
+// Returns the new buffer's slot
+uint32_t AddVertexBuffer(VertexLayout* layout, SDL_GPUVertexInputRate inputRate);
+// Returns the attribute's location
+uint32_t AddVertexAttribute(VertexLayout* layout, uint32_t slot, SDL_GPUVertexElementFormat format);
+// Points into layout, which has to outlive the pipeline create call
+SDL_GPUVertexInputState GetVertexInputState(const VertexLayout* layout);
+
+// Per-instance data of instanced.vert: an affine transform as three rows (world = row * position)
+// and a color, read from an instance rate buffer
+struct InstanceTransform {
+    float row0[4];
+    float row1[4];
+    float row2[4];
+    float color[4];
+};
+
+// cbuffer InstancedUniforms in instanced.vert.hlsl, vertex uniform slot 0
+struct InstancedUniforms {
+    Matrix4x4 viewProjection;
+};
+
+// Adds an instance rate slot carrying InstanceTransform, returns the slot
+uint32_t AddInstanceTransformBuffer(VertexLayout* layout);
+// Takes the affine part of a model matrix; the last column is ignored
+InstanceTransform MakeInstanceTransform(const Matrix4x4* model, float r, float g, float b, float a);
+
+// A vertex buffer for instance rate slots, refilled every frame through the upload queue.
+// Instances are allocated as runs; bind the stream at offset 0 and pass a run's first
+// instance to the draw, the instance rate attributes start there.
+struct InstanceStream {
+    UniformArena arena;
+    uint32_t instancePitch;
+};
+
+bool CreateInstanceStream(
+    SDL_GPUDevice* GPUDevice,
+    InstanceStream* stream,
+    uint32_t instancePitch,
+    uint32_t maxInstances,
+    uint32_t framesInFlight
+);
+void DestroyInstanceStream(SDL_GPUDevice* GPUDevice, InstanceStream* stream);
+
+// Call with BeginUploadFrame
+void BeginInstanceFrame(InstanceStream* stream);
+// Returns staging memory for count instances, to be written before FlushUploads
+void* StreamInstances(
+    SDL_GPUDevice* GPUDevice,
+    InstanceStream* stream,
+    UploadQueue* uploadQueue,
+    uint32_t count,
+    uint32_t* firstInstance
+);
+void BindInstanceStream(SDL_GPURenderPass* renderPass, const InstanceStream* stream, uint32_t slot);
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file
+struct MappedFile {
+    const uint8_t* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+bool MapFile(const char* path, MappedFile* file);
+void UnmapFile(MappedFile* file);
@@ -0,0 +1,51 @@
+#pragma once
+#include "mesh_optimize.hpp"
+#include "mesh_pool.hpp"
+#include "meshlet.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bump whenever the file layout or anything the importer does to a mesh changes
+#define MESH_CACHE_VERSION 2
+
+struct MeshCacheStats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t writes;
+    uint64_t bytesLoaded;
+    uint64_t hashNS;
+    uint64_t loadNS;
+};
+
+// Content hash of the source file, mixed with everything else that changes the imported result
+uint64_t MeshCacheKey(const uint8_t* source, size_t size, uint32_t vertexPitch, const MeshImportOptions* options);
+
+// Maps <base>/cache/meshes/<key>.mesh and copies its streams straight into the pool's staging
+// memory, and its meshlets into *meshlets unless that is NULL. Returns false when there is no
+// usable entry; on a hit *mesh may still be MESH_HANDLE_INVALID if the pool is out of space.
+bool LoadCachedMesh(
+    SDL_GPUDevice* GPUDevice,
+    MeshPool* pool,
+    UploadQueue* uploadQueue,
+    uint64_t key,
+    MeshHandle* mesh,
+    std::vector<Meshlet>* meshlets
+);
+
+// Writes the final (optimized, packed) streams and their meshlets. The file is written under a
+// temporary name and renamed, so a crash never leaves a truncated entry behind.
+bool WriteCachedMesh(
+    uint64_t key,
+    uint32_t vertexPitch,
+    const void* vertices,
+    uint32_t vertexCount,
+    const void* indices,
+    uint32_t indexCount,
+    SDL_GPUIndexElementSize indexElementSize,
+    const std::vector<Meshlet>* meshlets
+);
+
+const MeshCacheStats* GetMeshCacheStats();
+void LogMeshCacheStats();
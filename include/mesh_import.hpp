@@ -0,0 +1,59 @@
+#pragma once
+#include "mesh_optimize.hpp"
+#include "mesh_pool.hpp"
+#include "meshlet.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum MeshFileFormat {
+    MESH_FILE_OBJ,
+    MESH_FILE_GLB,
+    MESH_FILE_FORMAT_COUNT
+};
+
+// PositionTextureVertex or PositionColorVertex
+enum MeshVertexLayout {
+    MESH_VERTEX_POSITION_TEXTURE,
+    MESH_VERTEX_POSITION_COLOR,
+};
+
+struct MeshParseStats {
+    uint32_t fileCount;
+    uint64_t inputBytes;
+    uint64_t parseNS;
+    uint64_t sourceVertices;
+    uint64_t weldedVertices;
+};
+
+uint32_t MeshVertexPitch(MeshVertexLayout layout);
+
+// Maps the file, parses it (format from the file magic: glTF binary, otherwise OBJ) and welds
+// identical vertices. Every mesh and primitive in the file ends up in one triangle list.
+bool ParseMeshFile(
+    const char* path,
+    MeshVertexLayout layout,
+    std::vector<uint8_t>* vertices,
+    uint32_t* vertexCount,
+    std::vector<uint32_t>* indices
+);
+
+// Loads assets/<meshFileName>: ParseMeshFile, OptimizeMesh, then writes the vertex and index
+// streams straight into the pool's staging memory. The pool's pitch must match the layout.
+// The result is stored in the mesh cache, later launches copy it from there without parsing.
+// Meshlets are built at import and kept in the cache too; pass NULL if they aren't needed.
+MeshHandle LoadMesh(
+    SDL_GPUDevice* GPUDevice,
+    MeshPool* pool,
+    UploadQueue* uploadQueue,
+    const std::string& meshFileName,
+    MeshVertexLayout layout,
+    const MeshImportOptions* options,
+    std::vector<Meshlet>* meshlets
+);
+
+// Accumulated by ParseMeshFile, one entry per MeshFileFormat
+const MeshParseStats* GetMeshParseStats(MeshFileFormat format);
+double MeshParseThroughputMBs(const MeshParseStats* stats);
+void LogMeshParseStats();
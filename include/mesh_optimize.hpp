@@ -0,0 +1,84 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct VertexCacheStats {
+    // Average cache miss ratio: transformed vertices per triangle, 0.5 is ideal for large grids, 3 is worst
+    float ACMR;
+    // Average transform to vertex ratio: 1 is ideal
+    float ATVR;
+};
+
+// FIFO simulation of a post-transform cache with cacheSize entries
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize);
+
+// Reorders triangles for the post-transform cache (Forsyth's linear-speed optimizer), in place
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// Reorders clusters of cache-optimized triangles so outward facing ones draw first.
+// Positions are float3 at the start of each vertex. threshold is the ACMR a cluster may lose
+// relative to its neighbourhood, 1.05 keeps nearly all of the cache optimization.
+void OptimizeOverdraw(
+    uint32_t* indices,
+    size_t indexCount,
+    const void* vertices,
+    size_t vertexCount,
+    size_t vertexPitch,
+    float threshold
+);
+
+// Reorders vertices by first use and drops unreferenced ones, rewriting indices.
+// Returns the new vertex count.
+size_t OptimizeVertexFetch(
+    void* vertices,
+    size_t vertexCount,
+    size_t vertexPitch,
+    uint32_t* indices,
+    size_t indexCount
+);
+
+SDL_GPUIndexElementSize ChooseIndexElementSize(size_t vertexCount);
+void PackIndices(const uint32_t* indices, size_t indexCount, SDL_GPUIndexElementSize indexElementSize, void* destination);
+
+struct MeshImportOptions {
+    bool optimizeOverdraw;
+    float overdrawThreshold;
+};
+
+struct ImportedMesh {
+    std::vector<uint8_t> vertices;
+    uint32_t vertexCount;
+    uint32_t vertexPitch;
+    std::vector<uint8_t> indices;
+    uint32_t indexCount;
+    SDL_GPUIndexElementSize indexElementSize;
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+// Runs the cache, overdraw and fetch optimizations in place and logs ACMR before and after.
+// vertices shrinks to the referenced vertices.
+bool OptimizeMesh(
+    const char* name,
+    std::vector<uint8_t>* vertices,
+    uint32_t* vertexCount,
+    uint32_t vertexPitch,
+    std::vector<uint32_t>* indices,
+    const MeshImportOptions* options,
+    VertexCacheStats* before,
+    VertexCacheStats* after
+);
+
+// OptimizeMesh on a copy of the mesh, with indices packed to the smallest index size
+bool ImportMesh(
+    const char* name,
+    const void* vertices,
+    uint32_t vertexCount,
+    uint32_t vertexPitch,
+    const uint32_t* indices,
+    uint32_t indexCount,
+    const MeshImportOptions* options,
+    ImportedMesh* mesh
+);
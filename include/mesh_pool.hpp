@@ -0,0 +1,86 @@
+#pragma once
+#include "buffer_allocator.hpp"
+#include "upload_queue.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <vector>
+
+typedef uint32_t MeshHandle;
+#define MESH_HANDLE_INVALID 0xFFFFFFFFu
+
+struct PooledMesh {
+    BufferAllocation vertices;
+    BufferAllocation indices;
+    // Passed straight to SDL_DrawGPUIndexedPrimitives
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t indexCount;
+    uint32_t vertexCount;
+    SDL_GPUIndexElementSize indexElementSize;
+    bool live;
+};
+
+struct MeshPoolStats {
+    uint32_t meshCount;
+    uint32_t passDraws;
+    uint32_t passBufferBinds;
+};
+
+// Static meshes of one vertex layout share a few large vertex and index buffers.
+// Draws use base vertex and first index offsets, so buffers are only rebound when a
+// mesh lives on a different page than the previous one (or switches index size).
+struct MeshPool {
+    uint32_t vertexPitch;
+    GPUBufferAllocator vertexBuffers;
+    GPUBufferAllocator indexBuffers;
+    std::vector<PooledMesh> meshes;
+    std::vector<MeshHandle> freeHandles;
+
+    SDL_GPUBuffer* boundVertexBuffer;
+    SDL_GPUBuffer* boundIndexBuffer;
+    SDL_GPUIndexElementSize boundIndexElementSize;
+    MeshPoolStats stats;
+};
+
+void CreateMeshPool(MeshPool* pool, uint32_t vertexPitch, uint32_t vertexPageSize, uint32_t indexPageSize);
+void DestroyMeshPool(SDL_GPUDevice* GPUDevice, MeshPool* pool);
+
+// Allocates the mesh and returns staging memory for its vertices and indices, which must be
+// written before the upload queue is flushed. Indices are relative to the mesh's own vertices.
+MeshHandle AllocateMesh(
+    SDL_GPUDevice* GPUDevice,
+    MeshPool* pool,
+    UploadQueue* uploadQueue,
+    uint32_t vertexCount,
+    uint32_t indexCount,
+    SDL_GPUIndexElementSize indexElementSize,
+    void** vertices,
+    void** indices
+);
+// AllocateMesh and copy
+MeshHandle AddMesh(
+    SDL_GPUDevice* GPUDevice,
+    MeshPool* pool,
+    UploadQueue* uploadQueue,
+    const void* vertices,
+    uint32_t vertexCount,
+    const void* indices,
+    uint32_t indexCount,
+    SDL_GPUIndexElementSize indexElementSize
+);
+void RemoveMesh(MeshPool* pool, MeshHandle mesh);
+const PooledMesh* GetMesh(const MeshPool* pool, MeshHandle mesh);
+
+// Forgets the bindings of the previous render pass
+void BeginMeshPass(MeshPool* pool);
+void DrawMesh(MeshPool* pool, SDL_GPURenderPass* renderPass, MeshHandle mesh, uint32_t instanceCount, uint32_t firstInstance);
+// Draws part of a mesh, firstIndex is relative to the mesh's own indices (e.g. a MeshletRange)
+void DrawMeshRange(
+    MeshPool* pool,
+    SDL_GPURenderPass* renderPass,
+    MeshHandle mesh,
+    uint32_t firstIndex,
+    uint32_t indexCount,
+    uint32_t instanceCount,
+    uint32_t firstInstance
+);
@@ -0,0 +1,69 @@
+#pragma once
+#include "common.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// A run of triangles in the mesh's index buffer, with bounds for culling. Positions are
+// the first three floats of a vertex; triangles are counter-clockwise when front facing.
+struct Meshlet {
+    // Relative to the mesh's own indices, see DrawMeshRange
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float center[3];
+    float radius;
+    // Every triangle faces away from a viewer for which
+    // dot(normalize(coneApex - viewer), coneAxis) >= coneCutoff
+    float coneApex[3];
+    float coneAxis[3];
+    float coneCutoff;
+};
+
+struct MeshletRange {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+struct MeshletCullStats {
+    uint32_t tested;
+    uint32_t frustumCulled;
+    uint32_t coneCulled;
+    uint32_t ranges;
+};
+
+// Splits the (already vertex cache optimized) triangle list into consecutive clusters of at
+// most MESHLET_MAX_VERTICES unique vertices and MESHLET_MAX_TRIANGLES triangles, so the
+// index buffer itself needs no reordering.
+void BuildMeshlets(
+    const uint32_t* indices,
+    size_t indexCount,
+    const void* vertices,
+    uint32_t vertexCount,
+    uint32_t vertexPitch,
+    std::vector<Meshlet>* meshlets
+);
+
+// Both in the mesh's object space: the model-view-projection matrix and the camera position
+// transformed into the mesh's space. Depth is [0, 1] like Matrix4x4_CreatePerspectiveFieldOfView.
+struct MeshletCullParams {
+    Matrix4x4 modelViewProjection;
+    Vector3 cameraPosition;
+};
+
+// Left, right, bottom, top, near and far planes as (normal, distance), normalized so the
+// signed distance of a sphere's center compares against its radius. The last two entries are
+// padding that never culls, to make two groups of four for SSE.
+void ExtractFrustumPlanes(const Matrix4x4* matrix, float planes[8][4]);
+
+// Writes the surviving meshlets as index ranges, merging neighbours that stay adjacent in the
+// index buffer. ranges needs room for meshletCount entries. Returns the range count.
+uint32_t CullMeshlets(
+    const Meshlet* meshlets,
+    uint32_t meshletCount,
+    const MeshletCullParams* params,
+    MeshletRange* ranges,
+    MeshletCullStats* stats
+);
@@ -0,0 +1,152 @@
+#pragma once
+#include "common.hpp"
+#include "upload_queue.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <vector>
+
+// numthreads of the particle compute shaders
+#define PARTICLE_GROUP_SIZE 64
+
+// Mirrors Particle in the particle shaders (std430)
+struct Particle {
+    float position[3];
+    float age;
+    float velocity[3];
+    float lifetime;
+};
+
+// Spawns particles in a box of half size radius around position, with velocity randomized by up
+// to velocitySpread per axis. Spawn randomness is a hash of the spawn index, the same on both
+// simulators, so a particle's start state does not depend on where it was simulated.
+struct ParticleEmitter {
+    float position[3];
+    float radius;
+    float velocity[3];
+    float velocitySpread;
+    float minLifetime;
+    float maxLifetime;
+    // Particles per second
+    float rate;
+};
+
+struct ParticleSimulationParams {
+    float gravity[3];
+    // Fraction of the velocity lost per second
+    float drag;
+};
+
+// The CPU simulator, structure of arrays so SSE2 steps four particles at a time. It is the
+// fallback when the compute pipelines are unavailable and the reference the GPU is validated
+// against. Arrays hold capacity rounded up to four.
+struct ParticleSimulationCPU {
+    uint32_t capacity;
+    uint32_t count;
+    float* positionX;
+    float* positionY;
+    float* positionZ;
+    float* velocityX;
+    float* velocityY;
+    float* velocityZ;
+    float* age;
+    float* lifetime;
+};
+
+bool CreateParticleSimulationCPU(ParticleSimulationCPU* simulation, uint32_t capacity);
+void DestroyParticleSimulationCPU(ParticleSimulationCPU* simulation);
+// Integrates every particle and removes the ones past their lifetime, keeping the order
+void SimulateParticlesCPU(ParticleSimulationCPU* simulation, const ParticleSimulationParams* params, float deltaTime);
+// Appends count particles with spawn indices firstSpawn onwards, returns how many fit
+uint32_t EmitParticlesCPU(ParticleSimulationCPU* simulation, const ParticleEmitter* emitter, uint32_t firstSpawn, uint32_t count);
+void ReadParticlesCPU(const ParticleSimulationCPU* simulation, Particle* particles);
+
+enum ParticleMode {
+    PARTICLE_MODE_GPU,
+    // Simulated on the CPU and uploaded every frame
+    PARTICLE_MODE_CPU,
+    // GPU simulation with the CPU simulator running alongside for ValidateParticles
+    PARTICLE_MODE_VALIDATE,
+};
+
+struct ParticleStats {
+    // Set by UpdateParticles
+    uint32_t frameEmitted;
+    uint32_t cpuParticles;
+
+    uint64_t totalEmitted;
+    uint64_t gpuFrames;
+    uint64_t cpuFrames;
+    uint64_t cpuSimulateNS;
+};
+
+// Emission, simulation and compaction run in compute passes over two storage buffers that swap
+// roles every frame: live particles of the previous frame are integrated and appended to the
+// other buffer, new ones are appended after them, and a last single-thread pass turns the count
+// into the next frame's dispatch size and this frame's instanced draw. The CPU never sees the
+// count, so its cost is the same for any number of particles.
+struct ParticleSystem {
+    ParticleMode mode;
+    uint32_t capacity;
+    ParticleEmitter emitter;
+    ParticleSimulationParams params;
+    // Faded from start to end over a particle's lifetime
+    float startColor[4];
+    float endColor[4];
+
+    SDL_GPUComputePipeline* emitPipeline;
+    SDL_GPUComputePipeline* simulatePipeline;
+    SDL_GPUComputePipeline* argsPipeline;
+    SDL_GPUGraphicsPipeline* renderPipeline;
+
+    SDL_GPUBuffer* particleBuffers[2];
+    // uint32 count per particle buffer
+    SDL_GPUBuffer* countBuffer;
+    // The simulate dispatch and the draw, see ParticleArgs in particles.cpp
+    SDL_GPUBuffer* argsBuffer;
+    // The buffer holding the latest particles
+    uint32_t current;
+
+    // Emission is decided on the CPU so both simulators spawn the same particles
+    float emitAccumulator;
+    uint32_t nextSpawn;
+    uint32_t frameFirstSpawn;
+    uint32_t frameEmit;
+    float frameDeltaTime;
+
+    ParticleSimulationCPU reference;
+    ParticleStats stats;
+};
+
+// Falls back to PARTICLE_MODE_CPU when the compute pipelines cannot be created. Initial counts
+// are written through the upload queue.
+bool CreateParticleSystem(
+    SDL_GPUDevice* GPUDevice,
+    ParticleSystem* system,
+    UploadQueue* uploadQueue,
+    uint32_t capacity,
+    ParticleMode mode,
+    SDL_GPUTextureFormat colorTargetFormat
+);
+void DestroyParticleSystem(SDL_GPUDevice* GPUDevice, ParticleSystem* system);
+
+// Decides the frame's emission, and runs the CPU simulator when it is used. Call before FlushUploads.
+bool UpdateParticles(SDL_GPUDevice* GPUDevice, ParticleSystem* system, UploadQueue* uploadQueue, float deltaTime);
+// Records the compute passes, after FlushUploads and outside any render pass
+void SimulateParticles(ParticleSystem* system, SDL_GPUCommandBuffer* commandBuffer);
+// Camera facing quads, additively blended; view orients them and viewProjection places them
+void RenderParticles(
+    ParticleSystem* system,
+    SDL_GPUCommandBuffer* commandBuffer,
+    SDL_GPURenderPass* renderPass,
+    const Matrix4x4* view,
+    const Matrix4x4* viewProjection,
+    float size
+);
+
+// Waits for the GPU and copies the latest particles back, in no particular order. For debugging.
+bool ReadbackParticles(SDL_GPUDevice* GPUDevice, ParticleSystem* system, std::vector<Particle>* particles);
+// PARTICLE_MODE_VALIDATE only: compares the GPU particles with the CPU simulator's, order independent
+bool ValidateParticles(SDL_GPUDevice* GPUDevice, ParticleSystem* system, float tolerance);
+
+const ParticleStats* GetParticleStats(const ParticleSystem* system);
+void LogParticleStats(const ParticleSystem* system);
@@ -0,0 +1,24 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+
+struct PipelineCacheStats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t livePipelines;
+    uint64_t creationNS;
+};
+
+// Returns a shared pipeline for createInfo. The key covers every field of the create-info,
+// including the vertex input, blend and target arrays it points to; shaders are compared by
+// handle, which the shader cache makes content-unique. Every successful call takes one
+// reference, and the pipeline holds a reference on both of its shaders while it lives.
+SDL_GPUGraphicsPipeline* AcquireGraphicsPipeline(
+    SDL_GPUDevice* GPUDevice,
+    const SDL_GPUGraphicsPipelineCreateInfo* createInfo
+);
+void ReleaseGraphicsPipeline(SDL_GPUDevice* GPUDevice, SDL_GPUGraphicsPipeline* pipeline);
+
+void DestroyPipelineCache(SDL_GPUDevice* GPUDevice);
+const PipelineCacheStats* GetPipelineCacheStats();
+void LogPipelineCacheStats();
@@ -0,0 +1,41 @@
+#pragma once
+#include "shader_variants.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+
+enum PipelineJobKind {
+    PIPELINE_JOB_GRAPHICS,
+    PIPELINE_JOB_COMPUTE,
+};
+
+struct PipelineJob {
+    const char* name;
+    PipelineJobKind kind;
+
+    // PIPELINE_JOB_GRAPHICS: the variant is created and stored into variants
+    GraphicsPipelineVariants* variants;
+    uint16_t vertexMask;
+    uint16_t fragmentMask;
+
+    // PIPELINE_JOB_COMPUTE: the pipeline is written to *computePipeline
+    const char* computeShader;
+    SDL_GPUComputePipeline** computePipeline;
+
+    // Filled in by BuildPipelines
+    SDL_GPUGraphicsPipeline* graphicsPipeline;
+    bool succeeded;
+    int workerIndex;
+    Uint64 durationNS;
+};
+
+PipelineJob GraphicsPipelineJob(
+    const char* name,
+    GraphicsPipelineVariants* variants,
+    uint16_t vertexMask,
+    uint16_t fragmentMask
+);
+PipelineJob ComputePipelineJob(const char* name, const char* computeShader, SDL_GPUComputePipeline** computePipeline);
+
+// Spreads shader loading and pipeline creation over worker threads and returns once every
+// job has finished, logging how long each pipeline took. The calling thread works too.
+bool BuildPipelines(SDL_GPUDevice* GPUDevice, PipelineJob* jobs, uint32_t jobCount);
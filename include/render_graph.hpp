@@ -0,0 +1,171 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <vector>
+
+#define RENDER_GRAPH_MAX_COLOR_TARGETS 4
+// Pooled transient textures unused for this many frames are released, e.g. after a resize
+#define RENDER_GRAPH_IDLE_FRAMES 3
+
+typedef uint32_t RenderResource;
+#define RENDER_RESOURCE_INVALID 0xFFFFFFFFu
+
+enum RenderGraphPassKind {
+    // Begins a render pass on the declared color and depth targets
+    RENDER_GRAPH_PASS_GRAPHICS,
+    // Begins a compute pass with the declared writes bound read-write
+    RENDER_GRAPH_PASS_COMPUTE,
+    RENDER_GRAPH_PASS_COPY,
+    // Gets only the command buffer and records its own passes, e.g. SimulateParticles
+    RENDER_GRAPH_PASS_COMMANDS,
+};
+
+enum RenderGraphAccessKind {
+    // Sampled textures, storage or vertex buffers
+    RENDER_GRAPH_ACCESS_READ,
+    // Storage writes, which may be partial
+    RENDER_GRAPH_ACCESS_WRITE,
+    RENDER_GRAPH_ACCESS_COLOR_TARGET,
+    RENDER_GRAPH_ACCESS_DEPTH_TARGET,
+};
+
+struct RenderGraphAccess {
+    RenderResource resource;
+    RenderGraphAccessKind kind;
+    // Targets only: cleared, otherwise the previous contents are kept if there are any
+    bool clear;
+    SDL_FColor clearColor;
+    float clearDepth;
+    // Derived by CompileRenderGraph
+    SDL_GPULoadOp loadOp;
+    SDL_GPUStoreOp storeOp;
+};
+
+struct RenderGraph;
+
+struct RenderGraphContext {
+    RenderGraph* graph;
+    SDL_GPUCommandBuffer* commandBuffer;
+    // The one matching the pass kind, NULL for the others
+    SDL_GPURenderPass* renderPass;
+    SDL_GPUComputePass* computePass;
+    SDL_GPUCopyPass* copyPass;
+};
+
+typedef void (*RenderGraphExecute)(RenderGraphContext* context, void* userData);
+
+struct RenderGraphPass {
+    const char* name;
+    RenderGraphPassKind kind;
+    RenderGraphExecute execute;
+    void* userData;
+    std::vector<RenderGraphAccess> accesses;
+    // Kept even when nothing reads what it writes
+    bool sideEffect;
+    bool alive;
+};
+
+struct RenderGraphResource {
+    const char* name;
+    bool isTexture;
+    bool imported;
+    // Resources whose contents are needed after the graph, like the swapchain, or a transient
+    // texture another graph reads later in the frame; an output transient is not aliased
+    bool output;
+    SDL_GPUTexture* texture;
+    SDL_GPUBuffer* buffer;
+    SDL_GPUTextureFormat format;
+    uint32_t width;
+    uint32_t height;
+
+    // Derived by CompileRenderGraph: the usage of every alive access, the range of positions
+    // in the execution order it is used in (-1 when unused) and the pooled texture backing it
+    SDL_GPUTextureUsageFlags usage;
+    int32_t firstUse;
+    int32_t lastUse;
+    uint32_t physicalTexture;
+    // The first resource to hold its pooled texture this frame; only it may cycle the texture,
+    // and only on its first target use. Later holders take the texture over in the same
+    // command buffer, cycling there would give them a separate backing texture.
+    bool cycleOnFirstUse;
+};
+
+// A texture the graph owns, shared by transient resources whose lifetimes do not overlap
+struct RenderGraphTexture {
+    SDL_GPUTexture* texture;
+    SDL_GPUTextureFormat format;
+    uint32_t width;
+    uint32_t height;
+    SDL_GPUTextureUsageFlags usage;
+    uint64_t lastUsedFrame;
+    // Last position in this frame's execution order it is taken until
+    int32_t busyUntil;
+};
+
+struct RenderGraphStats {
+    // Of the last compile
+    uint32_t passes;
+    uint32_t culledPasses;
+    uint32_t transientTextures;
+    uint32_t physicalTextures;
+    uint64_t transientBytes;
+    uint64_t physicalBytes;
+    // Loads turned into DONT_CARE because there was nothing to keep, stores because nothing reads them
+    uint32_t skippedLoads;
+    uint32_t skippedStores;
+
+    uint64_t texturesCreated;
+};
+
+// Passes and resources are declared again every frame, between BeginRenderGraph and
+// CompileRenderGraph. A pass that reads a resource runs after every pass that writes it, and
+// writers of one resource run in the order they were declared; anything else may run in any
+// order, declaration order is only the tie break. Passes that contribute nothing to an output
+// or a side effect are culled.
+struct RenderGraph {
+    std::vector<RenderGraphResource> resources;
+    std::vector<RenderGraphPass> passes;
+    std::vector<uint32_t> order;
+    std::vector<RenderGraphTexture> textures;
+    uint64_t frame;
+    bool compiled;
+    RenderGraphStats stats;
+};
+
+void BeginRenderGraph(RenderGraph* graph);
+// Release the graph's pooled textures
+void DestroyRenderGraph(SDL_GPUDevice* GPUDevice, RenderGraph* graph);
+
+RenderResource ImportRenderTexture(
+    RenderGraph* graph,
+    const char* name,
+    SDL_GPUTexture* texture,
+    SDL_GPUTextureFormat format,
+    uint32_t width,
+    uint32_t height
+);
+RenderResource ImportRenderBuffer(RenderGraph* graph, const char* name, SDL_GPUBuffer* buffer);
+// A texture that only lives inside the frame; its usage flags follow from how passes use it
+RenderResource CreateRenderTexture(RenderGraph* graph, const char* name, SDL_GPUTextureFormat format, uint32_t width, uint32_t height);
+void MarkRenderGraphOutput(RenderGraph* graph, RenderResource resource);
+
+// Returns the pass index. name and userData must outlive ExecuteRenderGraph.
+uint32_t AddRenderGraphPass(RenderGraph* graph, const char* name, RenderGraphPassKind kind, RenderGraphExecute execute, void* userData);
+void SetRenderGraphSideEffect(RenderGraph* graph, uint32_t pass);
+void PassRead(RenderGraph* graph, uint32_t pass, RenderResource resource);
+void PassWrite(RenderGraph* graph, uint32_t pass, RenderResource resource);
+// clearColor / clearDepth NULL keeps the previous contents
+void PassColorTarget(RenderGraph* graph, uint32_t pass, RenderResource resource, const SDL_FColor* clearColor);
+void PassDepthTarget(RenderGraph* graph, uint32_t pass, RenderResource resource, const float* clearDepth);
+
+// Orders and culls the passes, derives load and store ops and assigns pooled textures.
+// Returns false on a dependency cycle or when a texture cannot be created.
+bool CompileRenderGraph(SDL_GPUDevice* GPUDevice, RenderGraph* graph);
+void ExecuteRenderGraph(RenderGraph* graph, SDL_GPUCommandBuffer* commandBuffer);
+
+// The texture or buffer behind a resource, valid after CompileRenderGraph
+SDL_GPUTexture* GetRenderGraphTexture(const RenderGraph* graph, RenderResource resource);
+SDL_GPUBuffer* GetRenderGraphBuffer(const RenderGraph* graph, RenderResource resource);
+
+const RenderGraphStats* GetRenderGraphStats(const RenderGraph* graph);
+void LogRenderGraphStats(const RenderGraph* graph);
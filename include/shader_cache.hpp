@@ -0,0 +1,35 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <string>
+
+struct ShaderCacheStats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t fileReads;
+    uint32_t liveShaders;
+};
+
+// Returns a shared shader for the .spv at filePath with the stage and resource counts in
+// createInfo (code fields are filled in here). Every successful call takes one reference.
+SDL_GPUShader* AcquireShader(
+    SDL_GPUDevice* GPUDevice,
+    const char* filePath,
+    const SDL_GPUShaderCreateInfo* createInfo
+);
+
+// Same as AcquireShader but for code that does not come straight from a file,
+// e.g. specialized variants. The code is hashed on every call.
+SDL_GPUShader* AcquireShaderFromCode(SDL_GPUDevice* GPUDevice, const SDL_GPUShaderCreateInfo* createInfo);
+
+// Contents of a .spv, read from disk once and kept until the cache is destroyed.
+// With EMBED_SHADERS this returns the copy built into the executable instead.
+const uint8_t* LoadShaderCode(const char* filePath, size_t* codeSize);
+
+// Pipelines that keep using a shader after creation hold a reference to it;
+// the SDL_GPUShader is released when the last reference is dropped.
+void RetainShader(SDL_GPUShader* shader);
+void ReleaseShader(SDL_GPUDevice* GPUDevice, SDL_GPUShader* shader);
+
+void DestroyShaderCache(SDL_GPUDevice* GPUDevice);
+const ShaderCacheStats* GetShaderCacheStats();
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+enum ShaderKind {
+    SHADER_KIND_VERTEX,
+    SHADER_KIND_FRAGMENT,
+    SHADER_KIND_COMPUTE,
+};
+
+// Resource counts as SDL_gpu wants them. For compute shaders the storage counts are the
+// read-only ones and the readWrite counts are separate; graphics shaders only use the former.
+struct ShaderMetadata {
+    const char* name;
+    ShaderKind kind;
+    uint32_t samplerCount;
+    uint32_t storageTextureCount;
+    uint32_t storageBufferCount;
+    uint32_t uniformBufferCount;
+    uint32_t readWriteStorageTextureCount;
+    uint32_t readWriteStorageBufferCount;
+    uint32_t threadCount[3];
+};
+
+// A uniform block's layout: members in declaration order, sizes up to the end of their last
+// component (HLSL packing, arrays and matrices without their trailing padding)
+struct UniformMemberMetadata {
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct UniformBlockMetadata {
+    const char* shaderName;
+    uint32_t slot;
+    uint32_t size;
+    uint32_t firstMember;
+    uint32_t memberCount;
+};
+
+// Generated at build time by tools/shader_reflect.cpp from shaders/compiled/*.spv and the
+// shaders built into generated/shaders
+#include "shader_metadata.generated.hpp"
+
+constexpr const ShaderMetadata* FindShaderMetadata(std::string_view name) {
+    for (const ShaderMetadata& metadata : shaderMetadataTable) {
+        if (name == metadata.name) {
+            return &metadata;
+        }
+    }
+    return NULL;
+}
+
+constexpr const UniformBlockMetadata* FindUniformBlockMetadata(std::string_view shaderName, uint32_t slot) {
+    for (const UniformBlockMetadata& block : uniformBlockTable) {
+        if (shaderName == block.shaderName && slot == block.slot) {
+            return &block;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Permutation options of one shader, declared with add_shader_permutations() in CMakeLists.txt.
+// In a variant mask the low defineCount bits pick a build-time variant compiled with
+// -D<OPTION>=1, the bits above them set boolean specialization constants (SpecId 0, 1, ...)
+// which are patched into the SPIR-V when the variant is loaded.
+struct ShaderVariantInfo {
+    const char* name;
+    uint32_t defineCount;
+    uint32_t specConstantCount;
+    const char* const* options;
+};
+
+// Generated by CMake from the add_shader_permutations() calls
+#include "shader_variants.generated.hpp"
+
+constexpr const ShaderVariantInfo* FindShaderVariantInfo(std::string_view name) {
+    for (const ShaderVariantInfo& info : shaderVariantTable) {
+        if (name == info.name) {
+            return &info;
+        }
+    }
+    return NULL;
+}
+
+// Mask bit of a named option, 0 if the shader has no such option
+constexpr uint32_t ShaderOptionBit(std::string_view shader, std::string_view option) {
+    const ShaderVariantInfo* info = FindShaderVariantInfo(shader);
+    if (info == NULL) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < info->defineCount + info->specConstantCount; ++i) {
+        if (option == info->options[i]) {
+            return 1u << i;
+        }
+    }
+    return 0;
+}
+
+// Sets every boolean specialization constant whose SpecId is below specConstantCount to the
+// matching bit of specBits. Returns how many constants were patched.
+uint32_t SpecializeSPIRV(uint32_t* words, size_t wordCount, uint32_t specBits, uint32_t specConstantCount);
+
+// Shared like LoadShader, drop with ReleaseShader
+SDL_GPUShader* LoadShaderVariant(SDL_GPUDevice* GPUDevice, const std::string& fileName, uint32_t variantMask);
+
+// One pipeline description whose shaders come in variants. Pipelines are created the first
+// time a variant is asked for and kept until ReleaseGraphicsPipelineVariants.
+struct GraphicsPipelineVariants {
+    std::string vertexShader;
+    std::string fragmentShader;
+    SDL_GPUGraphicsPipelineCreateInfo createInfo;
+    std::vector<SDL_GPUVertexBufferDescription> vertexBuffers;
+    std::vector<SDL_GPUVertexAttribute> vertexAttributes;
+    std::vector<SDL_GPUColorTargetDescription> colorTargets;
+    std::unordered_map<uint32_t, SDL_GPUGraphicsPipeline*> pipelines;
+};
+
+// Copies createInfo (and the arrays it points to); its shader fields are ignored
+void InitGraphicsPipelineVariants(
+    GraphicsPipelineVariants* variants,
+    const std::string& vertexShader,
+    const std::string& fragmentShader,
+    const SDL_GPUGraphicsPipelineCreateInfo* createInfo
+);
+
+SDL_GPUGraphicsPipeline* GetGraphicsPipelineVariant(
+    SDL_GPUDevice* GPUDevice,
+    GraphicsPipelineVariants* variants,
+    uint16_t vertexMask,
+    uint16_t fragmentMask
+);
+
+// Builds the pipeline for a variant without touching the variant map, so it can run on any
+// thread. Returns a pipeline cache reference that SetGraphicsPipelineVariant takes over.
+SDL_GPUGraphicsPipeline* CreateGraphicsPipelineVariant(
+    SDL_GPUDevice* GPUDevice,
+    const GraphicsPipelineVariants* variants,
+    uint16_t vertexMask,
+    uint16_t fragmentMask
+);
+
+void SetGraphicsPipelineVariant(
+    SDL_GPUDevice* GPUDevice,
+    GraphicsPipelineVariants* variants,
+    uint16_t vertexMask,
+    uint16_t fragmentMask,
+    SDL_GPUGraphicsPipeline* pipeline
+);
+
+void ReleaseGraphicsPipelineVariants(SDL_GPUDevice* GPUDevice, GraphicsPipelineVariants* variants);
@@ -0,0 +1,74 @@
+#pragma once
+#include "common.hpp"
+#include "uniform_arena.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <vector>
+
+// Mirrors SpriteInstance in sprite.vert.hlsl (std430)
+struct SpriteInstance {
+    float x, y, z;
+    float rotation;
+    float width, height;
+    float padding[2];
+    float u, v, uvWidth, uvHeight;
+    float r, g, b, a;
+};
+
+struct SpriteBatchStats {
+    // Reset by BeginSprites
+    uint32_t frameSprites;
+    uint32_t frameDraws;
+
+    uint32_t peakFrameSprites;
+    uint64_t totalSprites;
+    uint64_t totalDraws;
+};
+
+struct SpriteDraw {
+    SDL_GPUTexture* texture;
+    uint32_t firstSprite;
+    uint32_t spriteCount;
+};
+
+// Collects a frame's sprites, sorts them by (z, texture) and writes them to the uniform arena,
+// then draws each run of one texture with one instanced call. Lower z is drawn first, so
+// painter's order holds across layers; within a layer, sprites are grouped by texture in
+// order of first use and sprites sharing a texture keep the order they were added in.
+struct SpriteBatch {
+    SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUSampler* sampler;
+    UniformArena* arena;
+
+    std::vector<SpriteInstance> sprites;
+    std::vector<SDL_GPUTexture*> spriteTextures;
+    std::vector<SpriteDraw> draws;
+    SpriteBatchStats stats;
+};
+
+// The arena must have been created with SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
+bool CreateSpriteBatch(
+    SDL_GPUDevice* GPUDevice,
+    SpriteBatch* batch,
+    UniformArena* arena,
+    SDL_GPUTextureFormat colorTargetFormat
+);
+void DestroySpriteBatch(SDL_GPUDevice* GPUDevice, SpriteBatch* batch);
+
+void BeginSprites(SpriteBatch* batch);
+void DrawSprite(SpriteBatch* batch, SDL_GPUTexture* texture, const SpriteInstance* sprite);
+
+// Writes the frame's sprites into the arena in draw order. Call before FlushUploads.
+bool UploadSprites(SDL_GPUDevice* GPUDevice, SpriteBatch* batch, UploadQueue* uploadQueue);
+
+// Records the batch's draws into a render pass on a target of colorTargetFormat
+void RenderSprites(
+    SpriteBatch* batch,
+    SDL_GPUCommandBuffer* commandBuffer,
+    SDL_GPURenderPass* renderPass,
+    const Matrix4x4* viewProjection
+);
+
+const SpriteBatchStats* GetSpriteBatchStats(const SpriteBatch* batch);
+float SpritesPerDraw(const SpriteBatchStats* stats);
+void LogSpriteBatchStats(const SpriteBatch* batch);
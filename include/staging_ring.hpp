@@ -0,0 +1,65 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+
+#define STAGING_RING_MAX_FRAMES 3
+
+struct StagingAllocation {
+    void* data;
+    SDL_GPUTransferBuffer* transferBuffer;
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct StagingRingStats {
+    uint32_t frameBytes;
+    uint32_t peakFrameBytes;
+    uint32_t failedAllocations;
+    uint32_t fenceWaits;
+    uint64_t fenceWaitNS;
+    // Estimated time the GPU spent on the ring's submissions. There are no GPU timestamps, so a
+    // submission counts from when it was submitted, or when the one before it completed if that
+    // was later, until its fence is seen signaled; BeginStagingFrame looks once per frame.
+    uint64_t gpuBusyNS;
+};
+
+// One persistent upload transfer buffer split into a region per frame in flight.
+// Each frame allocates linearly from its own region; a region is only reused once the
+// fence of the command buffer that last read from it has signaled.
+struct StagingRing {
+    SDL_GPUTransferBuffer* transferBuffer;
+    uint8_t* mapped;
+    uint32_t regionSize;
+    uint32_t framesInFlight;
+    uint32_t frameIndex;
+    uint32_t head;
+    SDL_GPUFence* fences[STAGING_RING_MAX_FRAMES];
+    // When each region's submission was made, 0 once its completion has been counted
+    Uint64 submitNS[STAGING_RING_MAX_FRAMES];
+    Uint64 lastCompleteNS;
+    StagingRingStats stats;
+};
+
+bool CreateStagingRing(SDL_GPUDevice* GPUDevice, StagingRing* ring, uint32_t regionSize, uint32_t framesInFlight);
+void DestroyStagingRing(SDL_GPUDevice* GPUDevice, StagingRing* ring);
+
+// Moves to the next region, waiting for the GPU if it is still reading from it, and adds the
+// submissions that completed since the last call to stats.gpuBusyNS
+bool BeginStagingFrame(SDL_GPUDevice* GPUDevice, StagingRing* ring);
+
+// alignment must be a power of two. Fails when the frame's region is full.
+bool StagingAlloc(
+    SDL_GPUDevice* GPUDevice,
+    StagingRing* ring,
+    uint32_t size,
+    uint32_t alignment,
+    StagingAllocation* allocation
+);
+
+// Unmaps the buffer, call after the last StagingAlloc and before recording the uploads
+void EndStagingWrites(SDL_GPUDevice* GPUDevice, StagingRing* ring);
+
+// Submits the command buffer holding this frame's uploads and keeps its fence for the region
+bool SubmitStagingFrame(SDL_GPUDevice* GPUDevice, StagingRing* ring, SDL_GPUCommandBuffer* commandBuffer);
+
+SDL_GPUTransferBufferLocation StagingLocation(const StagingAllocation* allocation);
@@ -0,0 +1,70 @@
+#pragma once
+#include "uniform_block.hpp"
+#include "upload_queue.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+
+// Staging is requested from the upload queue in runs of this size, so a frame's blocks
+// reach the GPU as a handful of merged copies instead of one upload each
+#define UNIFORM_ARENA_CHUNK_SIZE (16 * 1024)
+
+struct UniformArenaStats {
+    // Reset by BeginUniformFrame
+    uint32_t frameBlocks;
+    uint32_t frameBytes;
+
+    uint32_t peakFrameBytes;
+    uint32_t failedAllocations;
+};
+
+// Per-object constants for a frame, packed into a storage buffer that shaders index (a
+// StructuredBuffer read with the draw's first instance, for example) instead of receiving a
+// uniform push per draw. There is one buffer per frame in flight so writing the next frame's
+// blocks never waits on draws still reading the previous ones.
+struct UniformArena {
+    SDL_GPUBuffer* buffers[STAGING_RING_MAX_FRAMES];
+    uint32_t framesInFlight;
+    uint32_t frameIndex;
+    uint32_t capacity;
+    uint32_t head;
+
+    // The staging run currently being filled, in buffer offsets
+    uint8_t* chunk;
+    uint32_t chunkStart;
+    uint32_t chunkEnd;
+    UniformArenaStats stats;
+};
+
+// usage is the storage read flag of the stages that index the arena
+bool CreateUniformArena(
+    SDL_GPUDevice* GPUDevice,
+    UniformArena* arena,
+    uint32_t capacity,
+    uint32_t framesInFlight,
+    SDL_GPUBufferUsageFlags usage
+);
+void DestroyUniformArena(SDL_GPUDevice* GPUDevice, UniformArena* arena);
+
+// Switches to the next frame's buffer; call with BeginUploadFrame
+void BeginUniformFrame(UniformArena* arena);
+
+// Returns memory for one element of an array of size-byte elements, and its index in that
+// array, or NULL when the frame's capacity is used up. Must be written before FlushUploads.
+void* UniformArenaAlloc(SDL_GPUDevice* GPUDevice, UniformArena* arena, UploadQueue* uploadQueue, uint32_t size, uint32_t* index);
+// count consecutive elements, *firstIndex is the first one's index
+void* UniformArenaAllocArray(
+    SDL_GPUDevice* GPUDevice,
+    UniformArena* arena,
+    UploadQueue* uploadQueue,
+    uint32_t elementSize,
+    uint32_t count,
+    uint32_t* firstIndex
+);
+
+template <UniformBlock T>
+T* PushUniformArenaBlock(SDL_GPUDevice* GPUDevice, UniformArena* arena, UploadQueue* uploadQueue, uint32_t* index) {
+    return static_cast<T*>(UniformArenaAlloc(GPUDevice, arena, uploadQueue, sizeof(T), index));
+}
+
+// The buffer this frame's blocks live in, bind it as a storage buffer for the draws
+SDL_GPUBuffer* GetUniformArenaBuffer(const UniformArena* arena);
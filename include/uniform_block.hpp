@@ -0,0 +1,63 @@
+#pragma once
+#include "shader_metadata.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+
+// C++ mirror of a cbuffer: plain data, padded to whole 16-byte registers so arrays of it
+// (in the uniform arena) keep every element register aligned.
+template <typename T>
+concept UniformBlock = std::is_standard_layout_v<T> && std::is_trivially_copyable_v<T> && sizeof(T) % 16 == 0;
+
+struct UniformMemberLayout {
+    size_t offset;
+    size_t size;
+};
+
+#define UNIFORM_MEMBER(Type, member) UniformMemberLayout{ offsetof(Type, member), sizeof(Type::member) }
+
+// True when the members, listed in declaration order, sit exactly where the reflected block
+// in shaderName's uniform slot has them. Meant for static_assert, see CHECK_UNIFORM_BLOCK.
+template <UniformBlock T>
+constexpr bool UniformBlockMatches(std::string_view shaderName, uint32_t slot, std::initializer_list<UniformMemberLayout> members) {
+    const UniformBlockMetadata* block = FindUniformBlockMetadata(shaderName, slot);
+    if (block == NULL || block->memberCount != members.size() || sizeof(T) < block->size) {
+        return false;
+    }
+    const UniformMemberMetadata* reflected = &uniformMemberTable[block->firstMember];
+    for (const UniformMemberLayout& member : members) {
+        if (member.offset != reflected->offset || member.size != reflected->size) {
+            return false;
+        }
+        reflected++;
+    }
+    return true;
+}
+
+// CHECK_UNIFORM_BLOCK(GradientUniforms, "solidColor.frag", 0, UNIFORM_MEMBER(GradientUniforms, time))
+#define CHECK_UNIFORM_BLOCK(Type, shaderName, slot, ...)                                     \
+    static_assert(                                                                             \
+        UniformBlockMatches<Type>(shaderName, slot, { __VA_ARGS__ }),                          \
+        #Type " does not match the layout of uniform slot " #slot " in " shaderName            \
+    )
+
+// For shaders built by add_shader(), which only exist when dxc was found at configure time.
+// Without dxc there is no metadata to check against, so the check passes.
+#define CHECK_UNIFORM_BLOCK_IF_BUILT(Type, shaderName, slot, ...)                            \
+    static_assert(                                                                             \
+        FindUniformBlockMetadata(shaderName, slot) == NULL ||                                  \
+        UniformBlockMatches<Type>(shaderName, slot, { __VA_ARGS__ }),                          \
+        #Type " does not match the layout of uniform slot " #slot " in " shaderName            \
+    )
+
+template <UniformBlock T>
+void PushVertexUniformBlock(SDL_GPUCommandBuffer* commandBuffer, uint32_t slot, const T& block) {
+    SDL_PushGPUVertexUniformData(commandBuffer, slot, &block, sizeof(T));
+}
+
+template <UniformBlock T>
+void PushFragmentUniformBlock(SDL_GPUCommandBuffer* commandBuffer, uint32_t slot, const T& block) {
+    SDL_PushGPUFragmentUniformData(commandBuffer, slot, &block, sizeof(T));
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "staging_ring.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <vector>
+
+struct BufferUpload {
+    SDL_GPUTransferBuffer* transferBuffer;
+    uint32_t transferOffset;
+    SDL_GPUBuffer* buffer;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t sequence;
+};
+
+struct TextureUpload {
+    SDL_GPUTransferBuffer* transferBuffer;
+    uint32_t transferOffset;
+    uint32_t size;
+    SDL_GPUTextureRegion region;
+};
+
+struct UploadQueueStats {
+    // Reset by BeginUploadFrame
+    uint32_t frameUploads;
+    uint32_t frameCopyCommands;
+    uint32_t frameCopyPasses;
+    uint32_t frameBytes;
+
+    uint64_t totalUploads;
+    uint64_t totalCopyCommands;
+    uint64_t totalCopyPasses;
+};
+
+// Collects a frame's buffer and texture uploads in the staging ring and records them
+// all in one copy pass, merging uploads that land next to each other.
+struct UploadQueue {
+    StagingRing* ring;
+    std::vector<BufferUpload> bufferUploads;
+    std::vector<TextureUpload> textureUploads;
+    bool flushed;
+    UploadQueueStats stats;
+};
+
+void InitUploadQueue(UploadQueue* queue, StagingRing* ring);
+
+// Starts the ring's next frame, see BeginStagingFrame
+bool BeginUploadFrame(SDL_GPUDevice* GPUDevice, UploadQueue* queue);
+
+// Returns staging memory for size bytes to be written to buffer at offset, or NULL.
+// The contents must be written before FlushUploads.
+void* QueueBufferWrite(SDL_GPUDevice* GPUDevice, UploadQueue* queue, SDL_GPUBuffer* buffer, uint32_t offset, uint32_t size);
+bool QueueBufferUpload(
+    SDL_GPUDevice* GPUDevice,
+    UploadQueue* queue,
+    SDL_GPUBuffer* buffer,
+    uint32_t offset,
+    const void* data,
+    uint32_t size
+);
+
+// pixels are region->w * region->h * region->d texels of bytesPerPixel, rows pitch bytes apart
+bool QueueTextureUpload(
+    SDL_GPUDevice* GPUDevice,
+    UploadQueue* queue,
+    const SDL_GPUTextureRegion* region,
+    const void* pixels,
+    uint32_t bytesPerPixel,
+    uint32_t pitch
+);
+
+// Records everything queued this frame in a single copy pass; call right after acquiring
+// the frame's command buffer so the uploads land before any render pass reads them.
+// Nothing is recorded when the queue is empty. Submit with SubmitStagingFrame.
+void FlushUploads(SDL_GPUDevice* GPUDevice, UploadQueue* queue, SDL_GPUCommandBuffer* commandBuffer);
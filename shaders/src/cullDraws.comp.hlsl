@@ -0,0 +1,60 @@
+// One thread per object: frustum test of its bounding sphere, then its indexed indirect draw
+// command (IndirectDrawObject and IndirectDrawList in indirect_draw.hpp)
+struct DrawObject
+{
+    float4 sphere;  // xyz center, w radius
+    uint firstIndex;
+    uint indexCount;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+// SDL_GPUIndexedIndirectDrawCommand
+struct DrawCommand
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;
+};
+
+[[vk::binding(0, 0)]] StructuredBuffer<DrawObject> Objects : register(t0, space0);
+[[vk::binding(0, 1)]] RWStructuredBuffer<DrawCommand> Commands : register(u0, space1);
+[[vk::binding(1, 1)]] RWByteAddressBuffer VisibleCount : register(u1, space1);
+
+[[vk::binding(0, 2)]] cbuffer CullUniforms : register(b0, space2)
+{
+    float4 planes[6] : packoffset(c0);  // Normalized, see ExtractFrustumPlanes
+    uint objectCount : packoffset(c6);
+};
+
+[numthreads(64, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    if (id.x >= objectCount)
+    {
+        return;
+    }
+
+    DrawObject object = Objects[id.x];
+    bool visible = true;
+    [unroll]
+    for (int i = 0; i < 6; ++i)
+    {
+        visible = visible && dot(planes[i].xyz, object.sphere.xyz) + planes[i].w >= -object.sphere.w;
+    }
+
+    DrawCommand command;
+    command.indexCount = object.indexCount;
+    command.instanceCount = visible ? 1 : 0;
+    command.firstIndex = object.firstIndex;
+    command.vertexOffset = object.vertexOffset;
+    command.firstInstance = object.firstInstance;
+    Commands[id.x] = command;
+
+    if (visible)
+    {
+        VisibleCount.InterlockedAdd(0, 1);
+    }
+}
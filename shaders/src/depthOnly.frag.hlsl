@@ -0,0 +1,5 @@
+// Fragment stage of depth pre-pass pipelines, which have no color targets: depth comes from
+// the rasterizer, there is nothing to shade
+void main()
+{
+}
@@ -0,0 +1,34 @@
+// Per-vertex position in slot 0, per-instance transform and color in an instance rate slot
+// (InstanceTransform in instancing.hpp)
+struct Input
+{
+    float3 Position : TEXCOORD0;
+    float4 Row0 : TEXCOORD1;
+    float4 Row1 : TEXCOORD2;
+    float4 Row2 : TEXCOORD3;
+    float4 Color : TEXCOORD4;
+};
+
+[[vk::binding(0, 1)]] cbuffer InstancedUniforms : register(b0, space1)
+{
+    float4x4 viewProjection : packoffset(c0);
+};
+
+struct Output
+{
+    float2 UV : TEXCOORD0;
+    float4 Color : TEXCOORD1;
+    float4 Position : SV_Position;
+};
+
+Output main(Input input)
+{
+    float4 position = float4(input.Position, 1.0f);
+    float3 world = float3(dot(input.Row0, position), dot(input.Row1, position), dot(input.Row2, position));
+
+    Output output;
+    output.Position = mul(viewProjection, float4(world, 1.0f));
+    output.UV = input.Position.xy * 0.5f + 0.5f;
+    output.Color = input.Color;
+    return output;
+}
@@ -0,0 +1,13 @@
+// Round soft particle, premultiplied for additive blending
+struct Input
+{
+    float2 UV : TEXCOORD0;
+    float4 Color : TEXCOORD1;
+};
+
+float4 main(Input input) : SV_Target0
+{
+    float falloff = saturate(1.0f - length(input.UV * 2.0f - 1.0f));
+    float alpha = input.Color.a * falloff;
+    return float4(input.Color.rgb * alpha, alpha);
+}
@@ -0,0 +1,25 @@
+// Shared by the particle shaders, Particle and the spawn hash mirror particles.cpp
+struct Particle
+{
+    float3 position;
+    float age;
+    float3 velocity;
+    float lifetime;
+};
+
+uint HashSpawn(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// [0, 1) from the top 24 bits
+float NextRandom(inout uint state)
+{
+    state = HashSpawn(state);
+    return float(state >> 8) * (1.0f / 16777216.0f);
+}
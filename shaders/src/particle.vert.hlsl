@@ -0,0 +1,39 @@
+// One camera facing quad per particle, six vertices per instance
+#include "particle.hlsli"
+
+[[vk::binding(0, 0)]] StructuredBuffer<Particle> Particles : register(t0, space0);
+
+[[vk::binding(0, 1)]] cbuffer ParticleUniforms : register(b0, space1)
+{
+    float4x4 viewProjection : packoffset(c0);
+    float3 cameraRight : packoffset(c4);
+    float size : packoffset(c4.w);
+    float3 cameraUp : packoffset(c5);
+    float4 startColor : packoffset(c6);
+    float4 endColor : packoffset(c7);
+};
+
+struct Output
+{
+    float2 UV : TEXCOORD0;
+    float4 Color : TEXCOORD1;
+    float4 Position : SV_Position;
+};
+
+static const float2 corners[6] = {
+    float2(0.0f, 0.0f), float2(1.0f, 0.0f), float2(0.0f, 1.0f),
+    float2(0.0f, 1.0f), float2(1.0f, 0.0f), float2(1.0f, 1.0f),
+};
+
+Output main(uint vertexID : SV_VertexID, uint instanceID : SV_InstanceID)
+{
+    Particle particle = Particles[instanceID];
+    float2 corner = corners[vertexID];
+    float3 world = particle.position + (cameraRight * (corner.x - 0.5f) + cameraUp * (corner.y - 0.5f)) * size;
+
+    Output output;
+    output.Position = mul(viewProjection, float4(world, 1.0f));
+    output.UV = corner;
+    output.Color = lerp(startColor, endColor, saturate(particle.age / particle.lifetime));
+    return output;
+}
@@ -0,0 +1,21 @@
+// Clamps the new count, clears the old buffer's for the next frame and writes the next
+// simulate dispatch and this frame's draw (ParticleArgs in particles.cpp)
+[[vk::binding(0, 1)]] RWByteAddressBuffer Counts : register(u0, space1);
+[[vk::binding(1, 1)]] RWByteAddressBuffer Args : register(u1, space1);
+
+[[vk::binding(0, 2)]] cbuffer ArgsUniforms : register(b0, space2)
+{
+    uint sourceCountOffset : packoffset(c0.x);
+    uint targetCountOffset : packoffset(c0.y);
+    uint capacity : packoffset(c0.z);
+};
+
+[numthreads(1, 1, 1)]
+void main()
+{
+    uint count = min(Counts.Load(targetCountOffset), capacity);
+    Counts.Store(targetCountOffset, count);
+    Counts.Store(sourceCountOffset, 0);
+    Args.Store4(0, uint4((count + 63) / 64, 1, 1, 0));
+    Args.Store4(16, uint4(6, count, 0, 0));
+}
@@ -0,0 +1,47 @@
+// Appends emitCount new particles after the ones the simulate pass kept
+#include "particle.hlsli"
+
+[[vk::binding(0, 1)]] RWStructuredBuffer<Particle> Particles : register(u0, space1);
+[[vk::binding(1, 1)]] RWByteAddressBuffer Counts : register(u1, space1);
+
+[[vk::binding(0, 2)]] cbuffer EmitUniforms : register(b0, space2)
+{
+    float3 emitterPosition : packoffset(c0);
+    float radius : packoffset(c0.w);
+    float3 emitterVelocity : packoffset(c1);
+    float velocitySpread : packoffset(c1.w);
+    float minLifetime : packoffset(c2.x);
+    float maxLifetime : packoffset(c2.y);
+    uint firstSpawn : packoffset(c2.z);
+    uint emitCount : packoffset(c2.w);
+    uint countOffset : packoffset(c3.x);  // Byte offset of Particles' count in Counts
+    uint capacity : packoffset(c3.y);
+};
+
+[numthreads(64, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    if (id.x >= emitCount)
+    {
+        return;
+    }
+
+    uint index;
+    Counts.InterlockedAdd(countOffset, 1, index);
+    if (index >= capacity)
+    {
+        return;
+    }
+
+    uint state = firstSpawn + id.x;
+    Particle particle;
+    particle.position.x = emitterPosition.x + (NextRandom(state) * 2.0f - 1.0f) * radius;
+    particle.position.y = emitterPosition.y + (NextRandom(state) * 2.0f - 1.0f) * radius;
+    particle.position.z = emitterPosition.z + (NextRandom(state) * 2.0f - 1.0f) * radius;
+    particle.velocity.x = emitterVelocity.x + (NextRandom(state) * 2.0f - 1.0f) * velocitySpread;
+    particle.velocity.y = emitterVelocity.y + (NextRandom(state) * 2.0f - 1.0f) * velocitySpread;
+    particle.velocity.z = emitterVelocity.z + (NextRandom(state) * 2.0f - 1.0f) * velocitySpread;
+    particle.lifetime = minLifetime + NextRandom(state) * (maxLifetime - minLifetime);
+    particle.age = 0.0f;
+    Particles[index] = particle;
+}
@@ -0,0 +1,41 @@
+// Integrates the previous frame's particles and appends the living ones to the other buffer
+#include "particle.hlsli"
+
+[[vk::binding(0, 0)]] StructuredBuffer<Particle> Source : register(t0, space0);
+[[vk::binding(0, 1)]] RWStructuredBuffer<Particle> Target : register(u0, space1);
+[[vk::binding(1, 1)]] RWByteAddressBuffer Counts : register(u1, space1);
+
+[[vk::binding(0, 2)]] cbuffer SimulateUniforms : register(b0, space2)
+{
+    float3 gravity : packoffset(c0);
+    float drag : packoffset(c0.w);
+    float deltaTime : packoffset(c1.x);
+    uint sourceCountOffset : packoffset(c1.y);
+    uint targetCountOffset : packoffset(c1.z);
+    uint capacity : packoffset(c1.w);
+};
+
+[numthreads(64, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    if (id.x >= Counts.Load(sourceCountOffset))
+    {
+        return;
+    }
+
+    Particle particle = Source[id.x];
+    particle.velocity = (particle.velocity + gravity * deltaTime) * max(0.0f, 1.0f - drag * deltaTime);
+    particle.position = particle.position + particle.velocity * deltaTime;
+    particle.age = particle.age + deltaTime;
+    if (particle.age >= particle.lifetime)
+    {
+        return;
+    }
+
+    uint index;
+    Counts.InterlockedAdd(targetCountOffset, 1, index);
+    if (index < capacity)
+    {
+        Target[index] = particle;
+    }
+}
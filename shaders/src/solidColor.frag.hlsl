@@ -1,3 +1,10 @@
+// Permutation options, see add_shader_permutations() in CMakeLists.txt
+#ifndef GRAYSCALE
+#define GRAYSCALE 0
+#endif
+
+[[vk::constant_id(0)]] const bool ANIMATED = true;
+
 cbuffer TimeBuffer : register(b0)
 {
     float time : packoffset(c0);  // Time in seconds
@@ -5,10 +12,17 @@ cbuffer TimeBuffer : register(b0)
 
 float4 main(float2 UV : TEXCOORD0) : SV_Target0
 {
+    float t = ANIMATED ? time : 0.0f;
+
     // Combine UV with Time for dynamic gradient effect
-    float r = UV.x + 0.5f * sin(time);
-    float g = UV.y + 0.5f * cos(time);
-    float b = 0.5f + 0.5f * sin(UV.x * 10.0f + time);
+    float r = UV.x + 0.5f * sin(t);
+    float g = UV.y + 0.5f * cos(t);
+    float b = 0.5f + 0.5f * sin(UV.x * 10.0f + t);
 
+#if GRAYSCALE
+    float luminance = dot(float3(r, g, b), float3(0.299f, 0.587f, 0.114f));
+    return float4(luminance, luminance, luminance, 1.0f);
+#else
     return float4(r, g, b, 1.0f); // Ensure values are clamped in [0, 1]
+#endif
 }
@@ -0,0 +1,48 @@
+// One instanced draw per texture: six vertices per sprite, everything else comes from the
+// sprite's entry in the instance buffer (SpriteInstance in sprite_batch.hpp)
+struct SpriteInstance
+{
+    float3 position;
+    float rotation;
+    float2 size;
+    float2 padding;
+    float4 uvRect;  // x, y, width, height
+    float4 color;
+};
+
+[[vk::binding(0, 0)]] StructuredBuffer<SpriteInstance> Sprites : register(t0, space0);
+
+[[vk::binding(0, 1)]] cbuffer SpriteUniforms : register(b0, space1)
+{
+    float4x4 viewProjection : packoffset(c0);
+    uint firstSprite : packoffset(c4);  // This draw's first entry in Sprites
+};
+
+struct Output
+{
+    float2 UV : TEXCOORD0;
+    float4 Color : TEXCOORD1;
+    float4 Position : SV_Position;
+};
+
+static const float2 corners[6] = {
+    float2(0.0f, 0.0f), float2(1.0f, 0.0f), float2(0.0f, 1.0f),
+    float2(0.0f, 1.0f), float2(1.0f, 0.0f), float2(1.0f, 1.0f),
+};
+
+Output main(uint vertexID : SV_VertexID, uint instanceID : SV_InstanceID)
+{
+    SpriteInstance sprite = Sprites[firstSprite + instanceID];
+    float2 corner = corners[vertexID];
+
+    float2 local = (corner - 0.5f) * sprite.size;
+    float s, c;
+    sincos(sprite.rotation, s, c);
+    float2 rotated = float2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    Output output;
+    output.Position = mul(viewProjection, float4(sprite.position.xy + rotated, sprite.position.z, 1.0f));
+    output.UV = sprite.uvRect.xy + corner * sprite.uvRect.zw;
+    output.Color = sprite.color;
+    return output;
+}
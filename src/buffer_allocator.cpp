@@ -0,0 +1,321 @@
+#include "../include/buffer_allocator.hpp"
+#include <SDL3/SDL.h>
+#include <bit>
+
+#define TLSF_NONE 0xFFFFFFFFu
+#define TLSF_GRANULARITY (1u << TLSF_GRANULARITY_LOG2)
+#define TLSF_MAX_ALLOCATION (1u << 31)
+
+static uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Size classes: sizes below 2^TLSF_FL_SHIFT map linearly to first level 0, larger ones
+// by their top bit (first level) and the next TLSF_SL_LOG2 bits (second level).
+static void MappingInsert(uint32_t size, uint32_t* firstLevel, uint32_t* secondLevel) {
+    if (size < (1u << TLSF_FL_SHIFT)) {
+        *firstLevel = 0;
+        *secondLevel = size >> TLSF_GRANULARITY_LOG2;
+    } else {
+        uint32_t topBit = std::bit_width(size) - 1;
+        *firstLevel = topBit - TLSF_FL_SHIFT + 1;
+        *secondLevel = (size >> (topBit - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+    }
+}
+
+// Rounds up to the next class boundary so any block in the found list is large enough
+static void MappingSearch(uint32_t size, uint32_t* firstLevel, uint32_t* secondLevel) {
+    if (size >= (1u << TLSF_FL_SHIFT)) {
+        size += (1u << (std::bit_width(size) - 1 - TLSF_SL_LOG2)) - 1;
+    }
+    MappingInsert(size, firstLevel, secondLevel);
+}
+
+static uint32_t NewBlock(GPUBufferAllocator* allocator) {
+    if (allocator->unusedBlocks != TLSF_NONE) {
+        uint32_t index = allocator->unusedBlocks;
+        allocator->unusedBlocks = allocator->blocks[index].nextFree;
+        return index;
+    }
+    allocator->blocks.push_back({});
+    return (uint32_t)allocator->blocks.size() - 1;
+}
+
+static void RecycleBlock(GPUBufferAllocator* allocator, uint32_t index) {
+    allocator->blocks[index] = {
+        .page = TLSF_NONE,
+        .nextFree = allocator->unusedBlocks,
+    };
+    allocator->unusedBlocks = index;
+}
+
+static void InsertFree(GPUBufferAllocator* allocator, uint32_t index) {
+    TlsfBlock& block = allocator->blocks[index];
+    BufferPage& page = allocator->pages[block.page];
+    uint32_t firstLevel, secondLevel;
+    MappingInsert(block.size, &firstLevel, &secondLevel);
+
+    uint32_t head = page.freeLists[firstLevel][secondLevel];
+    block.free = true;
+    block.previousFree = TLSF_NONE;
+    block.nextFree = head;
+    if (head != TLSF_NONE) {
+        allocator->blocks[head].previousFree = index;
+    }
+    page.freeLists[firstLevel][secondLevel] = index;
+    page.firstLevelBitmap |= 1u << firstLevel;
+    page.secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+static void RemoveFree(GPUBufferAllocator* allocator, uint32_t index) {
+    TlsfBlock& block = allocator->blocks[index];
+    BufferPage& page = allocator->pages[block.page];
+    uint32_t firstLevel, secondLevel;
+    MappingInsert(block.size, &firstLevel, &secondLevel);
+
+    if (block.previousFree != TLSF_NONE) {
+        allocator->blocks[block.previousFree].nextFree = block.nextFree;
+    } else {
+        page.freeLists[firstLevel][secondLevel] = block.nextFree;
+        if (block.nextFree == TLSF_NONE) {
+            page.secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+            if (page.secondLevelBitmaps[firstLevel] == 0) {
+                page.firstLevelBitmap &= ~(1u << firstLevel);
+            }
+        }
+    }
+    if (block.nextFree != TLSF_NONE) {
+        allocator->blocks[block.nextFree].previousFree = block.previousFree;
+    }
+    block.free = false;
+}
+
+static uint32_t FindFree(const BufferPage& page, uint32_t size) {
+    uint32_t firstLevel, secondLevel;
+    MappingSearch(size, &firstLevel, &secondLevel);
+    if (firstLevel >= TLSF_FL_COUNT) {
+        return TLSF_NONE;
+    }
+
+    uint32_t secondLevelMap = page.secondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (secondLevelMap == 0) {
+        uint32_t firstLevelMap = firstLevel + 1 < 32 ? page.firstLevelBitmap & (~0u << (firstLevel + 1)) : 0;
+        if (firstLevelMap == 0) {
+            return TLSF_NONE;
+        }
+        firstLevel = std::countr_zero(firstLevelMap);
+        secondLevelMap = page.secondLevelBitmaps[firstLevel];
+    }
+    return page.freeLists[firstLevel][std::countr_zero(secondLevelMap)];
+}
+
+// Splits the range [offset, offset + size) off the front of block, the rest becomes a new block after it
+static uint32_t SplitBlock(GPUBufferAllocator* allocator, uint32_t index, uint32_t size) {
+    uint32_t rest = NewBlock(allocator);
+    TlsfBlock& block = allocator->blocks[index];
+    allocator->blocks[rest] = {
+        .offset = block.offset + size,
+        .size = block.size - size,
+        .page = block.page,
+        .previousPhysical = index,
+        .nextPhysical = block.nextPhysical,
+        .previousFree = TLSF_NONE,
+        .nextFree = TLSF_NONE,
+        .free = false,
+    };
+    if (block.nextPhysical != TLSF_NONE) {
+        allocator->blocks[block.nextPhysical].previousPhysical = rest;
+    }
+    block.nextPhysical = rest;
+    block.size = size;
+    return rest;
+}
+
+// Folds next into block; next must directly follow it
+static void MergeBlocks(GPUBufferAllocator* allocator, uint32_t index, uint32_t next) {
+    TlsfBlock& block = allocator->blocks[index];
+    TlsfBlock& nextBlock = allocator->blocks[next];
+    block.size += nextBlock.size;
+    block.nextPhysical = nextBlock.nextPhysical;
+    if (nextBlock.nextPhysical != TLSF_NONE) {
+        allocator->blocks[nextBlock.nextPhysical].previousPhysical = index;
+    }
+    RecycleBlock(allocator, next);
+}
+
+// Returns the page's single free block
+static uint32_t AddPage(SDL_GPUDevice* GPUDevice, GPUBufferAllocator* allocator, uint32_t size) {
+    SDL_GPUBufferCreateInfo createInfo = {
+        .usage = allocator->usage,
+        .size = size,
+    };
+    SDL_GPUBuffer* buffer = SDL_CreateGPUBuffer(GPUDevice, &createInfo);
+    if (buffer == NULL) {
+        SDL_LogError(1, "Failed to create %u byte buffer page! error: %s", size, SDL_GetError());
+        return TLSF_NONE;
+    }
+
+    BufferPage page = {
+        .buffer = buffer,
+        .size = size,
+    };
+    for (uint32_t firstLevel = 0; firstLevel < TLSF_FL_COUNT; ++firstLevel) {
+        for (uint32_t secondLevel = 0; secondLevel < TLSF_SL_COUNT; ++secondLevel) {
+            page.freeLists[firstLevel][secondLevel] = TLSF_NONE;
+        }
+    }
+    allocator->pages.push_back(page);
+
+    uint32_t index = NewBlock(allocator);
+    allocator->blocks[index] = {
+        .offset = 0,
+        .size = size,
+        .page = (uint32_t)allocator->pages.size() - 1,
+        .previousPhysical = TLSF_NONE,
+        .nextPhysical = TLSF_NONE,
+    };
+    InsertFree(allocator, index);
+    return index;
+}
+
+void CreateBufferAllocator(GPUBufferAllocator* allocator, SDL_GPUBufferUsageFlags usage, uint32_t pageSize) {
+    allocator->usage = usage;
+    allocator->pageSize = AlignUp(pageSize, TLSF_GRANULARITY);
+    allocator->pages.clear();
+    allocator->blocks.clear();
+    allocator->unusedBlocks = TLSF_NONE;
+    allocator->allocationCount = 0;
+    allocator->usedBytes = 0;
+}
+
+void DestroyBufferAllocator(SDL_GPUDevice* GPUDevice, GPUBufferAllocator* allocator) {
+    if (allocator->allocationCount > 0) {
+        SDL_LogWarn(1, "Destroying buffer allocator with %u live allocations", allocator->allocationCount);
+    }
+    for (BufferPage& page : allocator->pages) {
+        SDL_ReleaseGPUBuffer(GPUDevice, page.buffer);
+    }
+    CreateBufferAllocator(allocator, allocator->usage, allocator->pageSize);
+}
+
+bool BufferAlloc(
+    SDL_GPUDevice* GPUDevice,
+    GPUBufferAllocator* allocator,
+    uint32_t size,
+    uint32_t alignment,
+    BufferAllocation* allocation
+) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        SDL_LogError(1, "Buffer allocation alignment %u is not a power of two", alignment);
+        return false;
+    }
+    alignment = SDL_max(alignment, TLSF_GRANULARITY);
+    size = AlignUp(SDL_max(size, 1u), TLSF_GRANULARITY);
+    if (size >= TLSF_MAX_ALLOCATION - alignment) {
+        SDL_LogError(1, "Buffer allocation of %u bytes is too large", size);
+        return false;
+    }
+
+    // Block offsets are always granularity aligned, so this is the worst case padding
+    uint32_t searchSize = size + alignment - TLSF_GRANULARITY;
+
+    uint32_t index = TLSF_NONE;
+    for (const BufferPage& page : allocator->pages) {
+        index = FindFree(page, searchSize);
+        if (index != TLSF_NONE) {
+            break;
+        }
+    }
+    if (index == TLSF_NONE) {
+        // Taken directly: a page sized exactly for a large request sits below the rounded-up search class
+        index = AddPage(GPUDevice, allocator, SDL_max(allocator->pageSize, searchSize));
+        if (index == TLSF_NONE) {
+            return false;
+        }
+    }
+    RemoveFree(allocator, index);
+
+    uint32_t padding = AlignUp(allocator->blocks[index].offset, alignment) - allocator->blocks[index].offset;
+    if (padding > 0) {
+        uint32_t aligned = SplitBlock(allocator, index, padding);
+        InsertFree(allocator, index);
+        index = aligned;
+    }
+    if (allocator->blocks[index].size - size >= TLSF_GRANULARITY) {
+        uint32_t rest = SplitBlock(allocator, index, size);
+        InsertFree(allocator, rest);
+    }
+
+    const TlsfBlock& block = allocator->blocks[index];
+    *allocation = {
+        .buffer = allocator->pages[block.page].buffer,
+        .offset = block.offset,
+        .size = block.size,
+        .block = index,
+    };
+    allocator->allocationCount++;
+    allocator->usedBytes += block.size;
+    return true;
+}
+
+void BufferFree(GPUBufferAllocator* allocator, BufferAllocation* allocation) {
+    uint32_t index = allocation->block;
+    if (allocation->buffer == NULL || index >= allocator->blocks.size() || allocator->blocks[index].free ||
+        allocator->blocks[index].page == TLSF_NONE) {
+        SDL_LogWarn(1, "BufferFree called with an allocation that is not live");
+        return;
+    }
+    allocator->allocationCount--;
+    allocator->usedBytes -= allocator->blocks[index].size;
+
+    uint32_t previous = allocator->blocks[index].previousPhysical;
+    if (previous != TLSF_NONE && allocator->blocks[previous].free) {
+        RemoveFree(allocator, previous);
+        MergeBlocks(allocator, previous, index);
+        index = previous;
+    }
+    uint32_t next = allocator->blocks[index].nextPhysical;
+    if (next != TLSF_NONE && allocator->blocks[next].free) {
+        RemoveFree(allocator, next);
+        MergeBlocks(allocator, index, next);
+    }
+    InsertFree(allocator, index);
+    *allocation = {};
+}
+
+BufferAllocatorStats GetBufferAllocatorStats(const GPUBufferAllocator* allocator) {
+    BufferAllocatorStats stats = {
+        .pageCount = (uint32_t)allocator->pages.size(),
+        .allocationCount = allocator->allocationCount,
+        .usedBytes = allocator->usedBytes,
+    };
+    for (const BufferPage& page : allocator->pages) {
+        stats.capacity += page.size;
+    }
+    for (const TlsfBlock& block : allocator->blocks) {
+        if (block.page != TLSF_NONE && block.free) {
+            stats.freeBlockCount++;
+            stats.freeBytes += block.size;
+            stats.largestFreeBlock = SDL_max(stats.largestFreeBlock, block.size);
+        }
+    }
+    if (stats.freeBytes > 0) {
+        stats.fragmentation = 1.0f - (float)stats.largestFreeBlock / (float)stats.freeBytes;
+    }
+    return stats;
+}
+
+void LogBufferAllocatorStats(const char* name, const GPUBufferAllocator* allocator) {
+    BufferAllocatorStats stats = GetBufferAllocatorStats(allocator);
+    SDL_Log(
+        "%s: %u allocations in %u pages, %.1f of %.1f KB used, %u free blocks, largest %.1f KB, fragmentation %.1f%%",
+        name,
+        stats.allocationCount,
+        stats.pageCount,
+        (double)stats.usedBytes / 1024.0,
+        (double)stats.capacity / 1024.0,
+        stats.freeBlockCount,
+        (double)stats.largestFreeBlock / 1024.0,
+        stats.fragmentation * 100.0f
+    );
+}
@@ -0,0 +1,199 @@
+#include "../include/command_recorder.hpp"
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_timer.h>
+
+static void RunJob(CommandRecorder* recorder, uint32_t jobIndex, int workerIndex) {
+    RecordingJob* job = &recorder->jobs[jobIndex];
+    Uint64 start = SDL_GetTicksNS();
+
+    SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(recorder->GPUDevice);
+    if (commandBuffer == NULL) {
+        SDL_LogError(1, "Failed to acquire a command buffer for %s! error: %s", job->name, SDL_GetError());
+    } else {
+        job->record(commandBuffer, job->userData);
+    }
+    job->durationNS = SDL_GetTicksNS() - start;
+    job->workerIndex = workerIndex;
+
+    // Jobs are taken in order, so every job before this one is already being recorded and
+    // none of them waits on this one
+    Uint64 waitStart = SDL_GetTicksNS();
+    SDL_LockMutex(recorder->mutex);
+    while (recorder->nextSubmit != jobIndex) {
+        SDL_WaitCondition(recorder->submitted, recorder->mutex);
+    }
+    recorder->submitWaitNS += SDL_GetTicksNS() - waitStart;
+    SDL_UnlockMutex(recorder->mutex);
+
+    job->succeeded = commandBuffer != NULL && SDL_SubmitGPUCommandBuffer(commandBuffer);
+    if (commandBuffer != NULL && !job->succeeded) {
+        SDL_LogError(1, "Failed to submit the command buffer of %s! error: %s", job->name, SDL_GetError());
+    }
+
+    SDL_LockMutex(recorder->mutex);
+    recorder->nextSubmit++;
+    SDL_BroadcastCondition(recorder->submitted);
+    SDL_UnlockMutex(recorder->mutex);
+}
+
+static void DrainJobs(CommandRecorder* recorder, int workerIndex) {
+    for (;;) {
+        int jobIndex = SDL_AddAtomicInt(&recorder->nextJob, 1);
+        if (jobIndex >= (int)recorder->jobCount) {
+            return;
+        }
+        RunJob(recorder, (uint32_t)jobIndex, workerIndex);
+    }
+}
+
+static int SDLCALL RecordingWorkerMain(void* data) {
+    RecordingWorker* worker = static_cast<RecordingWorker*>(data);
+    CommandRecorder* recorder = worker->recorder;
+    uint64_t seenFrame = 0;
+    for (;;) {
+        SDL_LockMutex(recorder->mutex);
+        while (!recorder->quitting && recorder->frame == seenFrame) {
+            SDL_WaitCondition(recorder->frameReady, recorder->mutex);
+        }
+        bool quitting = recorder->quitting;
+        seenFrame = recorder->frame;
+        SDL_UnlockMutex(recorder->mutex);
+
+        if (quitting) {
+            return 0;
+        }
+        DrainJobs(recorder, worker->index);
+
+        SDL_LockMutex(recorder->mutex);
+        recorder->finishedWorkers++;
+        SDL_BroadcastCondition(recorder->submitted);
+        SDL_UnlockMutex(recorder->mutex);
+    }
+}
+
+bool CreateCommandRecorder(SDL_GPUDevice* GPUDevice, CommandRecorder* recorder, int workerCount) {
+    *recorder = {};
+    recorder->GPUDevice = GPUDevice;
+    recorder->mutex = SDL_CreateMutex();
+    recorder->frameReady = SDL_CreateCondition();
+    recorder->submitted = SDL_CreateCondition();
+    if (recorder->mutex == NULL || recorder->frameReady == NULL || recorder->submitted == NULL) {
+        SDL_LogError(1, "Failed to create the command recorder's locks! error: %s", SDL_GetError());
+        DestroyCommandRecorder(recorder);
+        return false;
+    }
+
+    if (workerCount <= 0) {
+        workerCount = SDL_GetNumLogicalCPUCores();
+    }
+    workerCount = SDL_clamp(workerCount, 1, MAX_RECORDING_WORKERS);
+
+    // Worker 0 is the thread calling RecordFrame
+    recorder->workerCount = 1;
+    for (int i = 1; i < workerCount; ++i) {
+        recorder->workers[i] = { .recorder = recorder, .index = i };
+        recorder->threads[i] = SDL_CreateThread(RecordingWorkerMain, "RecordingWorker", &recorder->workers[i]);
+        if (recorder->threads[i] == NULL) {
+            SDL_LogWarn(1, "Failed to start recording worker %d: %s", i, SDL_GetError());
+            break;
+        }
+        recorder->workerCount++;
+    }
+    return true;
+}
+
+void DestroyCommandRecorder(CommandRecorder* recorder) {
+    if (recorder->mutex != NULL) {
+        SDL_LockMutex(recorder->mutex);
+        recorder->quitting = true;
+        SDL_BroadcastCondition(recorder->frameReady);
+        SDL_UnlockMutex(recorder->mutex);
+    }
+    for (int i = 1; i < MAX_RECORDING_WORKERS; ++i) {
+        if (recorder->threads[i] != NULL) {
+            SDL_WaitThread(recorder->threads[i], NULL);
+        }
+    }
+
+    SDL_DestroyCondition(recorder->submitted);
+    SDL_DestroyCondition(recorder->frameReady);
+    SDL_DestroyMutex(recorder->mutex);
+    *recorder = {};
+}
+
+void BeginRecording(CommandRecorder* recorder) {
+    recorder->jobCount = 0;
+}
+
+bool AddRecordingJob(CommandRecorder* recorder, const char* name, RecordCommands record, void* userData) {
+    if (recorder->jobCount == MAX_RECORDING_JOBS) {
+        SDL_LogError(1, "Too many recording jobs, %s was not added", name);
+        return false;
+    }
+    recorder->jobs[recorder->jobCount++] = {
+        .name = name,
+        .record = record,
+        .userData = userData,
+    };
+    return true;
+}
+
+bool RecordFrame(CommandRecorder* recorder) {
+    Uint64 start = SDL_GetTicksNS();
+    SDL_SetAtomicInt(&recorder->nextJob, 0);
+
+    SDL_LockMutex(recorder->mutex);
+    recorder->nextSubmit = 0;
+    recorder->submitWaitNS = 0;
+    recorder->finishedWorkers = 0;
+    recorder->frame++;
+    SDL_BroadcastCondition(recorder->frameReady);
+    SDL_UnlockMutex(recorder->mutex);
+
+    DrainJobs(recorder, 0);
+
+    // Workers may still be recording or submitting the last jobs
+    SDL_LockMutex(recorder->mutex);
+    while (recorder->nextSubmit != recorder->jobCount || recorder->finishedWorkers != recorder->workerCount - 1) {
+        SDL_WaitCondition(recorder->submitted, recorder->mutex);
+    }
+    Uint64 submitWaitNS = recorder->submitWaitNS;
+    SDL_UnlockMutex(recorder->mutex);
+
+    CommandRecorderStats* stats = &recorder->stats;
+    stats->frameJobs = recorder->jobCount;
+    stats->frameRecordNS = 0;
+    stats->frameSubmitWaitNS = submitWaitNS;
+    bool succeeded = true;
+    for (uint32_t i = 0; i < recorder->jobCount; ++i) {
+        stats->frameRecordNS += recorder->jobs[i].durationNS;
+        if (!recorder->jobs[i].succeeded) {
+            stats->failedJobs++;
+            succeeded = false;
+        }
+    }
+    stats->frameWallNS = SDL_GetTicksNS() - start;
+    stats->totalFrames++;
+    stats->totalJobs += recorder->jobCount;
+    return succeeded;
+}
+
+const CommandRecorderStats* GetCommandRecorderStats(const CommandRecorder* recorder) {
+    return &recorder->stats;
+}
+
+void LogCommandRecorderStats(const CommandRecorder* recorder) {
+    const CommandRecorderStats* stats = &recorder->stats;
+    SDL_Log(
+        "Command recording: %u jobs on %d workers, %.2f ms of recording in %.2f ms (%.1fx), %.2f ms waiting to submit, %llu jobs in %llu frames, %llu failed",
+        stats->frameJobs,
+        recorder->workerCount,
+        (double)stats->frameRecordNS / SDL_NS_PER_MS,
+        (double)stats->frameWallNS / SDL_NS_PER_MS,
+        stats->frameWallNS > 0 ? (double)stats->frameRecordNS / (double)stats->frameWallNS : 0.0,
+        (double)stats->frameSubmitWaitNS / SDL_NS_PER_MS,
+        (unsigned long long)stats->totalJobs,
+        (unsigned long long)stats->totalFrames,
+        (unsigned long long)stats->failedJobs
+    );
+}
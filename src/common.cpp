@@ -1,4 +1,8 @@
 #include "../include/common.hpp"
+#include "../include/image.hpp"
+#include "../include/pipeline_cache.hpp"
+#include "../include/shader_cache.hpp"
+#include "../include/shader_metadata.hpp"
 #include <SDL3/SDL_filesystem.h>
 #include <cstdint>
 
@@ -28,6 +32,8 @@ int GeneralInit(Context *context, SDL_WindowFlags windowFlags) {
 }
 
 void GeneralQuit(Context* context) {
+    DestroyPipelineCache(context->GPUDevice);
+    DestroyShaderCache(context->GPUDevice);
     SDL_ReleaseWindowFromGPUDevice(context->GPUDevice, context->window);
     SDL_DestroyWindow(context->window);
     SDL_DestroyGPUDevice(context->GPUDevice);
@@ -39,81 +45,87 @@ void InitAssetLoader() {
     basePath = SDL_GetBasePath();
 }
 
-SDL_GPUShader* LoadShader(
-    SDL_GPUDevice *GPUDevice,
-    const std::string &fileName,
-    uint32_t samplerCount,
-    uint32_t uniformBufferCount,
-    uint32_t storageBufferCount,
-    uint32_t storageTextureCount
+// Shaders built with dxc (generated/shaders) take precedence over the checked-in ones
+static void ShaderPath(const std::string& fileName, char* fullPath, size_t fullPathSize) {
+    SDL_snprintf(fullPath, fullPathSize, "%sgenerated/shaders/%s.spv", basePath, fileName.c_str());
+    if (!SDL_GetPathInfo(fullPath, NULL)) {
+        SDL_snprintf(fullPath, fullPathSize, "%sshaders/compiled/%s.spv", basePath, fileName.c_str());
+    }
+}
+
+bool GetShaderCreateInfo(
+    SDL_GPUDevice* GPUDevice,
+    const std::string& fileName,
+    SDL_GPUShaderCreateInfo* createInfo,
+    char* fullPath,
+    size_t fullPathSize
 ) {
+    const ShaderMetadata* metadata = FindShaderMetadata(fileName);
+    if (metadata == NULL) {
+        SDL_LogError(1, "No reflection metadata for shader %s, is it in shaders/compiled or built by add_shader()?", fileName.c_str());
+        return false;
+    }
+
     SDL_GPUShaderStage stage;
-    if (SDL_strstr(fileName.c_str(), ".vert")) {
+    if (metadata->kind == SHADER_KIND_VERTEX) {
         stage = SDL_GPU_SHADERSTAGE_VERTEX;
     }
-    else if (SDL_strstr(fileName.c_str(), ".frag")) {
+    else if (metadata->kind == SHADER_KIND_FRAGMENT) {
         stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
     }
     else {
         SDL_LogWarn(1, "Invalid shader stage!");
-        return NULL;
+        return false;
     }
 
-    char fullPath[256];
     SDL_GPUShaderFormat backendFormats = SDL_GetGPUShaderFormats(GPUDevice);
     SDL_GPUShaderFormat format = SDL_GPU_SHADERFORMAT_INVALID;
     const char *entrypoint;
 
     if (backendFormats & SDL_GPU_SHADERFORMAT_SPIRV) {
-        SDL_snprintf(fullPath, sizeof(fullPath), "%sshaders/compiled/%s.spv", basePath, fileName.c_str());
+        ShaderPath(fileName, fullPath, fullPathSize);
         format = SDL_GPU_SHADERFORMAT_SPIRV;
         entrypoint = "main";
     } else {
         SDL_LogError(1, "Unrecognized backend shader format!");
-        return NULL;
-    }
-
-    size_t codeSize;
-    void* code = SDL_LoadFile(fullPath, &codeSize);
-    if (code == NULL) {
-        SDL_LogError(1, "Failed to load shader from disk! path: %s    error: %s", fullPath, SDL_GetError());
-        return NULL;
+        return false;
     }
 
-    SDL_GPUShaderCreateInfo shaderInfo = {
-        .code_size = codeSize,
-        .code = static_cast<const uint8_t*>(code),
+    *createInfo = {
         .entrypoint = entrypoint,
         .format = format,
         .stage = stage,
-        .num_samplers = samplerCount,
-        .num_storage_textures = storageTextureCount,
-        .num_storage_buffers = storageBufferCount,
-        .num_uniform_buffers = uniformBufferCount,
+        .num_samplers = metadata->samplerCount,
+        .num_storage_textures = metadata->storageTextureCount,
+        .num_storage_buffers = metadata->storageBufferCount,
+        .num_uniform_buffers = metadata->uniformBufferCount,
     };
-    SDL_GPUShader* shader = SDL_CreateGPUShader(GPUDevice, &shaderInfo);
-    if (shader == NULL) {
-        SDL_Log("Failed to create shader! error: %s", SDL_GetError());
-        SDL_free(code);
+    return true;
+}
+
+SDL_GPUShader* LoadShader(SDL_GPUDevice *GPUDevice, const std::string &fileName) {
+    char fullPath[256];
+    SDL_GPUShaderCreateInfo shaderInfo;
+    if (!GetShaderCreateInfo(GPUDevice, fileName, &shaderInfo, fullPath, sizeof(fullPath))) {
         return NULL;
     }
-
-    SDL_free(code);
-    return shader;
+    return AcquireShader(GPUDevice, fullPath, &shaderInfo);
 }
 
-SDL_GPUComputePipeline* CreateComputePipelineFromShader(
-    SDL_GPUDevice* GPUDevice,
-    const std::string& fileName,
-    SDL_GPUComputePipelineCreateInfo *createInfo
-) {
+SDL_GPUComputePipeline* CreateComputePipelineFromShader(SDL_GPUDevice* GPUDevice, const std::string& fileName) {
+    const ShaderMetadata* metadata = FindShaderMetadata(fileName);
+    if (metadata == NULL || metadata->kind != SHADER_KIND_COMPUTE) {
+        SDL_LogError(1, "No compute reflection metadata for shader %s", fileName.c_str());
+        return NULL;
+    }
+
     char fullPath[256];
     SDL_GPUShaderFormat backendFormats = SDL_GetGPUShaderFormats(GPUDevice);
     SDL_GPUShaderFormat format = SDL_GPU_SHADERFORMAT_INVALID;
     const char *entrypoint;
 
     if (backendFormats & SDL_GPU_SHADERFORMAT_SPIRV) {
-        SDL_snprintf(fullPath, sizeof(fullPath), "%sshaders/compiled/%s.spv", basePath, fileName.c_str());
+        ShaderPath(fileName, fullPath, sizeof(fullPath));
         format = SDL_GPU_SHADERFORMAT_SPIRV;
         entrypoint = "main";
     } else {
@@ -122,27 +134,33 @@ SDL_GPUComputePipeline* CreateComputePipelineFromShader(
     }
 
     size_t codeSize;
-    void* code = SDL_LoadFile(fullPath, &codeSize);
+    const uint8_t* code = LoadShaderCode(fullPath, &codeSize);
     if (code == NULL) {
-        SDL_Log("Failed to load compute shader from disk! file: %s    error: %s", fullPath, SDL_GetError());
         return NULL;
     }
 
-    // Make a copy of the create data, then overwrite the parts we need
-    SDL_GPUComputePipelineCreateInfo newCreateInfo = *createInfo;
-    newCreateInfo.code = static_cast<const uint8_t*>(code);
-    newCreateInfo.code_size = codeSize;
-    newCreateInfo.entrypoint = entrypoint;
-    newCreateInfo.format = format;
+    SDL_GPUComputePipelineCreateInfo createInfo = {
+        .code_size = codeSize,
+        .code = code,
+        .entrypoint = entrypoint,
+        .format = format,
+        .num_samplers = metadata->samplerCount,
+        .num_readonly_storage_textures = metadata->storageTextureCount,
+        .num_readonly_storage_buffers = metadata->storageBufferCount,
+        .num_readwrite_storage_textures = metadata->readWriteStorageTextureCount,
+        .num_readwrite_storage_buffers = metadata->readWriteStorageBufferCount,
+        .num_uniform_buffers = metadata->uniformBufferCount,
+        .threadcount_x = metadata->threadCount[0],
+        .threadcount_y = metadata->threadCount[1],
+        .threadcount_z = metadata->threadCount[2],
+    };
 
-    SDL_GPUComputePipeline* pipeline = SDL_CreateGPUComputePipeline(GPUDevice, &newCreateInfo);
+    SDL_GPUComputePipeline* pipeline = SDL_CreateGPUComputePipeline(GPUDevice, &createInfo);
     if (pipeline == NULL) {
         SDL_LogError(1, "Failed to create compute pipeline! error: %s", SDL_GetError());
-        SDL_free(code);
         return NULL;
     }
 
-    SDL_free(code);
     return pipeline;
 }
 
@@ -153,9 +171,17 @@ SDL_Surface* LoadImage(const std::string& imageFileName, int desiredChannels) {
 
     SDL_snprintf(fullPath, sizeof(fullPath), "%sassets/%s", basePath, imageFileName.c_str());
 
-    result = SDL_LoadBMP(fullPath);
+    size_t fileSize;
+    void* fileData = SDL_LoadFile(fullPath, &fileSize);
+    if (fileData == NULL) {
+        SDL_LogError(1, "Failed to load image from disk! path: %s    error: %s", fullPath, SDL_GetError());
+        return NULL;
+    }
+
+    result = DecodeImage(static_cast<const uint8_t*>(fileData), fileSize);
+    SDL_free(fileData);
     if (result == NULL) {
-        SDL_LogError(1, "Failed to load BMP error: %s", SDL_GetError());
+        SDL_LogError(1, "Failed to decode image %s error: %s", fullPath, SDL_GetError());
         return NULL;
     }
 
@@ -330,6 +356,38 @@ Matrix4x4 Matrix4x4_CreatePerspectiveFieldOfView(
 	};
 }
 
+// Depth is 1 at the near plane and 0 at the far plane. With a float depth buffer the float's
+// precision, densest near 0, then evens out the 1/z precision loss over distance.
+Matrix4x4 Matrix4x4_CreatePerspectiveFieldOfViewReversedZ(
+	float fieldOfView,
+	float aspectRatio,
+	float nearPlaneDistance,
+	float farPlaneDistance
+) {
+	float num = 1.0f / ((float) SDL_tanf(fieldOfView * 0.5f));
+	return (Matrix4x4) {
+		num / aspectRatio, 0, 0, 0,
+		0, num, 0, 0,
+		0, 0, nearPlaneDistance / (farPlaneDistance - nearPlaneDistance), -1,
+		0, 0, (nearPlaneDistance * farPlaneDistance) / (farPlaneDistance - nearPlaneDistance), 0
+	};
+}
+
+// The limit of the reversed-Z projection as the far plane goes to infinity: depth = near / distance
+Matrix4x4 Matrix4x4_CreatePerspectiveFieldOfViewInfiniteReversedZ(
+	float fieldOfView,
+	float aspectRatio,
+	float nearPlaneDistance
+) {
+	float num = 1.0f / ((float) SDL_tanf(fieldOfView * 0.5f));
+	return (Matrix4x4) {
+		num / aspectRatio, 0, 0, 0,
+		0, num, 0, 0,
+		0, 0, 0, -1,
+		0, 0, nearPlaneDistance, 0
+	};
+}
+
 Matrix4x4 Matrix4x4_CreateLookAt(
 	Vector3 cameraPosition,
 	Vector3 cameraTarget,
@@ -0,0 +1,60 @@
+#include "../include/depth_buffer.hpp"
+#include <SDL3/SDL.h>
+
+SDL_GPUTextureFormat ChooseDepthFormat(SDL_GPUDevice* GPUDevice) {
+    // SDL guarantees D16_UNORM and one of D24_UNORM or D32_FLOAT
+    SDL_GPUTextureFormat formats[] = {
+        SDL_GPU_TEXTUREFORMAT_D32_FLOAT,
+        SDL_GPU_TEXTUREFORMAT_D24_UNORM,
+    };
+    for (SDL_GPUTextureFormat format : formats) {
+        if (SDL_GPUTextureSupportsFormat(GPUDevice, format, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)) {
+            return format;
+        }
+    }
+    return SDL_GPU_TEXTUREFORMAT_D16_UNORM;
+}
+
+SDL_GPUDepthStencilState DepthTestState(DepthMode mode) {
+    switch (mode) {
+    case DEPTH_MODE_TEST:
+        // Or equal so geometry on the far plane, like a 2D quad at depth 0, still draws
+        return {
+            .compare_op = SDL_GPU_COMPAREOP_GREATER_OR_EQUAL,
+            .enable_depth_test = true,
+            .enable_depth_write = true,
+        };
+    case DEPTH_MODE_PRE_PASS:
+        // The pre-pass already wrote the nearest depth, only the fragment that produced it passes
+        return {
+            .compare_op = SDL_GPU_COMPAREOP_EQUAL,
+            .enable_depth_test = true,
+            .enable_depth_write = false,
+        };
+    case DEPTH_MODE_NONE:
+        break;
+    }
+    return {};
+}
+
+void SetPipelineDepth(SDL_GPUGraphicsPipelineCreateInfo* createInfo, SDL_GPUTextureFormat depthFormat, DepthMode mode) {
+    if (mode == DEPTH_MODE_NONE) {
+        return;
+    }
+    createInfo->depth_stencil_state = DepthTestState(mode);
+    createInfo->target_info.depth_stencil_format = depthFormat;
+    createInfo->target_info.has_depth_stencil_target = true;
+}
+
+SDL_GPUGraphicsPipelineCreateInfo DepthPrePassCreateInfo(const SDL_GPUGraphicsPipelineCreateInfo* createInfo, SDL_GPUTextureFormat depthFormat) {
+    SDL_GPUGraphicsPipelineCreateInfo prePass = *createInfo;
+    prePass.fragment_shader = NULL;
+    prePass.depth_stencil_state = DepthTestState(DEPTH_MODE_TEST);
+    prePass.target_info = {
+        .color_target_descriptions = NULL,
+        .num_color_targets = 0,
+        .depth_stencil_format = depthFormat,
+        .has_depth_stencil_target = true,
+    };
+    return prePass;
+}
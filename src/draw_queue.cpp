@@ -0,0 +1,342 @@
+#include "../include/draw_queue.hpp"
+#include <SDL3/SDL.h>
+#include <cstring>
+
+#define DRAW_KEY_FIELD(value, bits) ((uint64_t)(value) & ((1ull << (bits)) - 1))
+
+void CreateDrawQueue(DrawQueue* queue) {
+    *queue = {};
+    for (uint32_t pass = 0; pass < DRAW_QUEUE_MAX_PASSES; ++pass) {
+        queue->passOrder[pass] = DRAW_ORDER_STATE;
+    }
+}
+
+void DestroyDrawQueue(DrawQueue* queue) {
+    *queue = {};
+}
+
+void SetDrawPassOrder(DrawQueue* queue, uint32_t pass, DrawOrder order) {
+    SDL_assert(pass < DRAW_QUEUE_MAX_PASSES);
+    queue->passOrder[pass] = order;
+}
+
+uint32_t AddDrawMaterial(DrawQueue* queue, const void* fragmentUniforms, uint32_t size) {
+    DrawMaterial material = {
+        .offset = (uint32_t)queue->materialData.size(),
+        .size = size,
+    };
+    queue->materialData.resize(material.offset + size);
+    memcpy(queue->materialData.data() + material.offset, fragmentUniforms, size);
+    queue->materials.push_back(material);
+    return (uint32_t)queue->materials.size() - 1;
+}
+
+void UpdateDrawMaterial(DrawQueue* queue, uint32_t material, const void* fragmentUniforms) {
+    const DrawMaterial* entry = &queue->materials[material];
+    memcpy(queue->materialData.data() + entry->offset, fragmentUniforms, entry->size);
+}
+
+void BeginDraws(DrawQueue* queue) {
+    queue->packets.clear();
+    queue->keys.clear();
+    queue->vertexUniforms.clear();
+    queue->sorted = false;
+
+    DrawPassStats frame = SumDrawPassStats(queue);
+    DrawQueueStats* stats = &queue->stats;
+    stats->totalDraws += frame.draws;
+    stats->totalBinds += frame.pipelineBinds + frame.samplerBinds + frame.materialPushes + frame.bufferBinds;
+    stats->totalSkippedBinds += frame.skippedBinds;
+    for (DrawPassStats& passStats : queue->passStats) {
+        passStats = {};
+    }
+}
+
+uint64_t MakeDrawKey(uint32_t pass, DrawOrder order, uint32_t pipelineId, uint32_t textureId, uint32_t materialId, float depth) {
+    // The bits of a non-negative float order the same as its value, so the top bits below the
+    // sign are a quantized depth with no range to configure
+    uint32_t depthBits;
+    depth = depth > 0.0f ? depth : 0.0f;
+    memcpy(&depthBits, &depth, sizeof(depthBits));
+    uint64_t depthKey = depthBits >> (31 - DRAW_KEY_DEPTH_BITS);
+
+    uint64_t state =
+        DRAW_KEY_FIELD(pipelineId, DRAW_KEY_PIPELINE_BITS) << (DRAW_KEY_TEXTURE_BITS + DRAW_KEY_MATERIAL_BITS) |
+        DRAW_KEY_FIELD(textureId, DRAW_KEY_TEXTURE_BITS) << DRAW_KEY_MATERIAL_BITS |
+        DRAW_KEY_FIELD(materialId, DRAW_KEY_MATERIAL_BITS);
+    const uint32_t stateBits = DRAW_KEY_PIPELINE_BITS + DRAW_KEY_TEXTURE_BITS + DRAW_KEY_MATERIAL_BITS;
+
+    uint64_t key = DRAW_KEY_FIELD(pass, DRAW_KEY_PASS_BITS) << (64 - DRAW_KEY_PASS_BITS);
+    if (order == DRAW_ORDER_BACK_TO_FRONT) {
+        uint64_t farFirst = ((1ull << DRAW_KEY_DEPTH_BITS) - 1) - depthKey;
+        key |= farFirst << stateBits | state;
+    } else {
+        key |= state << DRAW_KEY_DEPTH_BITS | depthKey;
+    }
+    return key;
+}
+
+template <typename T>
+static uint32_t InternId(std::unordered_map<T*, uint32_t>* ids, T* object) {
+    auto [entry, added] = ids->try_emplace(object, (uint32_t)ids->size());
+    return entry->second;
+}
+
+void SubmitDraw(DrawQueue* queue, const DrawDesc* draw) {
+    SDL_assert(draw->pass < DRAW_QUEUE_MAX_PASSES);
+    SDL_assert(draw->material == DRAW_MATERIAL_NONE || draw->material < queue->materials.size());
+
+    DrawPacket packet = {
+        .pipeline = draw->pipeline,
+        .texture = draw->texture,
+        .sampler = draw->sampler,
+        .material = draw->material,
+        .mesh = draw->mesh,
+        .instanceCount = draw->instanceCount,
+        .firstInstance = draw->firstInstance,
+        .vertexUniformsOffset = (uint32_t)queue->vertexUniforms.size(),
+        .vertexUniformsSize = draw->vertexUniforms != NULL ? draw->vertexUniformsSize : 0,
+    };
+    if (packet.vertexUniformsSize > 0) {
+        queue->vertexUniforms.resize(packet.vertexUniformsOffset + packet.vertexUniformsSize);
+        memcpy(queue->vertexUniforms.data() + packet.vertexUniformsOffset, draw->vertexUniforms, packet.vertexUniformsSize);
+    }
+
+    // 0 is kept for no texture and no material so they sort together
+    uint32_t pipelineId = InternId(&queue->pipelineIds, draw->pipeline);
+    uint32_t textureId = draw->texture != NULL ? InternId(&queue->textureIds, draw->texture) + 1 : 0;
+    uint32_t materialId = draw->material + 1;
+    queue->keys.push_back(MakeDrawKey(draw->pass, queue->passOrder[draw->pass], pipelineId, textureId, materialId, draw->depth));
+    queue->packets.push_back(packet);
+}
+
+uint32_t RadixSortKeys(
+    uint64_t* keys,
+    uint32_t* values,
+    uint32_t count,
+    std::vector<uint64_t>* keyScratch,
+    std::vector<uint32_t>* valueScratch
+) {
+    if (count < 2) {
+        return 0;
+    }
+    keyScratch->resize(count);
+    valueScratch->resize(count);
+
+    // All eight histograms in one read of the keys
+    uint32_t histograms[8][256] = {};
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t key = keys[i];
+        for (uint32_t digit = 0; digit < 8; ++digit) {
+            histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+        }
+    }
+
+    uint64_t* sourceKeys = keys;
+    uint32_t* sourceValues = values;
+    uint64_t* targetKeys = keyScratch->data();
+    uint32_t* targetValues = valueScratch->data();
+    uint32_t skipped = 0;
+    for (uint32_t digit = 0; digit < 8; ++digit) {
+        uint32_t shift = digit * 8;
+        uint32_t* histogram = histograms[digit];
+        // Unused key bits, like the pass when there is one pass, would be a copy for nothing
+        if (histogram[(sourceKeys[0] >> shift) & 0xFF] == count) {
+            skipped++;
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < 256; ++bucket) {
+            uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t destination = histogram[(sourceKeys[i] >> shift) & 0xFF]++;
+            targetKeys[destination] = sourceKeys[i];
+            targetValues[destination] = sourceValues[i];
+        }
+        std::swap(sourceKeys, targetKeys);
+        std::swap(sourceValues, targetValues);
+    }
+
+    if (sourceKeys != keys) {
+        memcpy(keys, sourceKeys, count * sizeof(uint64_t));
+        memcpy(values, sourceValues, count * sizeof(uint32_t));
+    }
+    return skipped;
+}
+
+static bool SameState(const DrawPacket* a, const DrawPacket* b) {
+    return a->pipeline == b->pipeline && a->texture == b->texture && a->sampler == b->sampler && a->material == b->material;
+}
+
+static uint32_t CountStateChanges(const std::vector<DrawPacket>& packets, const uint32_t* order, uint32_t count) {
+    uint32_t changes = 0;
+    for (uint32_t i = 1; i < count; ++i) {
+        changes += !SameState(&packets[order[i - 1]], &packets[order[i]]);
+    }
+    return changes;
+}
+
+void SortDraws(DrawQueue* queue) {
+    Uint64 start = SDL_GetTicksNS();
+    uint32_t count = (uint32_t)queue->packets.size();
+    queue->order.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        queue->order[i] = i;
+    }
+    queue->stats.unsortedStateChanges = CountStateChanges(queue->packets, queue->order.data(), count);
+
+    queue->stats.skippedSortPasses = RadixSortKeys(queue->keys.data(), queue->order.data(), count, &queue->keyScratch, &queue->orderScratch);
+
+    // Keys are sorted by pass first, so each pass is one range
+    uint32_t draw = 0;
+    for (uint32_t pass = 0; pass < DRAW_QUEUE_MAX_PASSES; ++pass) {
+        queue->passStart[pass] = draw;
+        while (draw < count && (queue->keys[draw] >> (64 - DRAW_KEY_PASS_BITS)) == pass) {
+            draw++;
+        }
+    }
+    queue->passStart[DRAW_QUEUE_MAX_PASSES] = count;
+
+    queue->stats.frameDraws = count;
+    queue->stats.sortedStateChanges = CountStateChanges(queue->packets, queue->order.data(), count);
+    queue->stats.sortNS += SDL_GetTicksNS() - start;
+    queue->sorted = true;
+}
+
+void RenderDraws(DrawQueue* queue, const MeshPool* pool, SDL_GPUCommandBuffer* commandBuffer, SDL_GPURenderPass* renderPass, uint32_t pass) {
+    if (!queue->sorted) {
+        SDL_LogError(1, "RenderDraws called before SortDraws");
+        return;
+    }
+
+    // Bindings do not carry over between render passes, and other code may have pushed
+    // uniforms in between, so every pass starts from nothing bound
+    SDL_GPUGraphicsPipeline* boundPipeline = NULL;
+    SDL_GPUTexture* boundTexture = NULL;
+    SDL_GPUSampler* boundSampler = NULL;
+    uint32_t boundMaterial = DRAW_MATERIAL_NONE;
+    SDL_GPUBuffer* boundVertexBuffer = NULL;
+    SDL_GPUBuffer* boundIndexBuffer = NULL;
+    SDL_GPUIndexElementSize boundIndexElementSize = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+
+    DrawPassStats* stats = &queue->passStats[pass];
+    for (uint32_t i = queue->passStart[pass]; i < queue->passStart[pass + 1]; ++i) {
+        const DrawPacket* packet = &queue->packets[queue->order[i]];
+        const PooledMesh* mesh = GetMesh(pool, packet->mesh);
+        if (mesh == NULL) {
+            SDL_LogWarn(1, "RenderDraws: draw of a mesh that is not in the pool");
+            continue;
+        }
+
+        if (packet->pipeline != boundPipeline) {
+            SDL_BindGPUGraphicsPipeline(renderPass, packet->pipeline);
+            boundPipeline = packet->pipeline;
+            stats->pipelineBinds++;
+        } else {
+            stats->skippedBinds++;
+        }
+
+        if (packet->texture != NULL) {
+            if (packet->texture != boundTexture || packet->sampler != boundSampler) {
+                SDL_GPUTextureSamplerBinding textureBinding = {
+                    .texture = packet->texture,
+                    .sampler = packet->sampler,
+                };
+                SDL_BindGPUFragmentSamplers(renderPass, 0, &textureBinding, 1);
+                boundTexture = packet->texture;
+                boundSampler = packet->sampler;
+                stats->samplerBinds++;
+            } else {
+                stats->skippedBinds++;
+            }
+        }
+
+        if (packet->material != DRAW_MATERIAL_NONE) {
+            if (packet->material != boundMaterial) {
+                const DrawMaterial* material = &queue->materials[packet->material];
+                SDL_PushGPUFragmentUniformData(commandBuffer, 0, queue->materialData.data() + material->offset, material->size);
+                boundMaterial = packet->material;
+                stats->materialPushes++;
+            } else {
+                stats->skippedBinds++;
+            }
+        }
+
+        if (mesh->vertices.buffer != boundVertexBuffer) {
+            SDL_GPUBufferBinding vertexBufferBinding = {
+                .buffer = mesh->vertices.buffer,
+                .offset = 0,
+            };
+            SDL_BindGPUVertexBuffers(renderPass, 0, &vertexBufferBinding, 1);
+            boundVertexBuffer = mesh->vertices.buffer;
+            stats->bufferBinds++;
+        } else {
+            stats->skippedBinds++;
+        }
+        if (mesh->indices.buffer != boundIndexBuffer || mesh->indexElementSize != boundIndexElementSize) {
+            SDL_GPUBufferBinding indexBufferBinding = {
+                .buffer = mesh->indices.buffer,
+                .offset = 0,
+            };
+            SDL_BindGPUIndexBuffer(renderPass, &indexBufferBinding, mesh->indexElementSize);
+            boundIndexBuffer = mesh->indices.buffer;
+            boundIndexElementSize = mesh->indexElementSize;
+            stats->bufferBinds++;
+        } else {
+            stats->skippedBinds++;
+        }
+
+        if (packet->vertexUniformsSize > 0) {
+            SDL_PushGPUVertexUniformData(
+                commandBuffer,
+                0,
+                queue->vertexUniforms.data() + packet->vertexUniformsOffset,
+                packet->vertexUniformsSize
+            );
+        }
+
+        SDL_DrawGPUIndexedPrimitives(renderPass, mesh->indexCount, packet->instanceCount, mesh->firstIndex, mesh->vertexOffset, packet->firstInstance);
+        stats->draws++;
+    }
+}
+
+const DrawQueueStats* GetDrawQueueStats(const DrawQueue* queue) {
+    return &queue->stats;
+}
+
+DrawPassStats SumDrawPassStats(const DrawQueue* queue) {
+    DrawPassStats sum = {};
+    for (const DrawPassStats& pass : queue->passStats) {
+        sum.draws += pass.draws;
+        sum.pipelineBinds += pass.pipelineBinds;
+        sum.samplerBinds += pass.samplerBinds;
+        sum.materialPushes += pass.materialPushes;
+        sum.bufferBinds += pass.bufferBinds;
+        sum.skippedBinds += pass.skippedBinds;
+    }
+    return sum;
+}
+
+void LogDrawQueueStats(const DrawQueue* queue) {
+    const DrawQueueStats* stats = &queue->stats;
+    DrawPassStats frame = SumDrawPassStats(queue);
+    SDL_Log(
+        "Draw queue: %u draws, %u state changes sorted (%u unsorted), %u pipeline %u sampler %u material %u buffer binds, %u redundant binds skipped, %u of 8 sort passes skipped, %llu binds and %llu skipped, %.3f ms sorting in total",
+        frame.draws,
+        stats->sortedStateChanges,
+        stats->unsortedStateChanges,
+        frame.pipelineBinds,
+        frame.samplerBinds,
+        frame.materialPushes,
+        frame.bufferBinds,
+        frame.skippedBinds,
+        stats->skippedSortPasses,
+        (unsigned long long)stats->totalBinds,
+        (unsigned long long)stats->totalSkippedBinds,
+        (double)stats->sortNS / 1e6
+    );
+}
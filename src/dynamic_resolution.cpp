@@ -0,0 +1,109 @@
+#include "../include/dynamic_resolution.hpp"
+#include <SDL3/SDL.h>
+
+void InitDynamicResolution(DynamicResolution* resolution, float targetFrameMS, float minScale, float maxScale) {
+    *resolution = {
+        .targetFrameMS = targetFrameMS,
+        .minScale = minScale,
+        .maxScale = maxScale,
+        .scale = maxScale,
+        .averageFrameMS = 0.0f,
+        .framesSinceChange = 0,
+        .stats = { .lowestScale = maxScale },
+    };
+}
+
+float UpdateDynamicResolution(DynamicResolution* resolution, Uint64 frameNS) {
+    DynamicResolutionStats* stats = &resolution->stats;
+    stats->frames++;
+    stats->framesBelowFull += resolution->scale < resolution->maxScale;
+
+    // A single hitch, like the window being dragged, should not throw the average far off
+    float frameMS = SDL_min((float)frameNS / SDL_NS_PER_MS, 4.0f * resolution->targetFrameMS);
+    if (resolution->averageFrameMS == 0.0f) {
+        resolution->averageFrameMS = frameMS;
+    } else {
+        resolution->averageFrameMS += DYNAMIC_RESOLUTION_SMOOTHING * (frameMS - resolution->averageFrameMS);
+    }
+
+    if (++resolution->framesSinceChange < DYNAMIC_RESOLUTION_SETTLE_FRAMES || resolution->averageFrameMS <= 0.0f) {
+        return resolution->scale;
+    }
+
+    float wanted = resolution->scale * SDL_sqrtf(resolution->targetFrameMS / resolution->averageFrameMS);
+    float scale = resolution->scale;
+    if (resolution->averageFrameMS > resolution->targetFrameMS) {
+        scale = SDL_max(wanted, resolution->scale - DYNAMIC_RESOLUTION_MAX_STEP);
+    } else if (resolution->averageFrameMS < resolution->targetFrameMS * DYNAMIC_RESOLUTION_HEADROOM) {
+        scale = SDL_min(wanted, resolution->scale + DYNAMIC_RESOLUTION_MAX_STEP);
+    }
+    scale = SDL_clamp(scale, resolution->minScale, resolution->maxScale);
+
+    if (SDL_fabsf(scale - resolution->scale) > 0.01f) {
+        resolution->scale = scale;
+        resolution->framesSinceChange = 0;
+        stats->scaleChanges++;
+        stats->lowestScale = SDL_min(stats->lowestScale, scale);
+    }
+    return resolution->scale;
+}
+
+static uint32_t ScaleExtent(uint32_t extent, float scale) {
+    uint32_t scaled = (uint32_t)((float)extent * scale + 0.5f) & ~1u;
+    return SDL_clamp(scaled, 2u, SDL_max(extent, 2u));
+}
+
+void GetScaledResolution(const DynamicResolution* resolution, uint32_t width, uint32_t height, uint32_t* scaledWidth, uint32_t* scaledHeight) {
+    *scaledWidth = ScaleExtent(width, resolution->scale);
+    *scaledHeight = ScaleExtent(height, resolution->scale);
+}
+
+void UpscaleTexture(
+    SDL_GPUCommandBuffer* commandBuffer,
+    SDL_GPUTexture* source,
+    uint32_t sourceWidth,
+    uint32_t sourceHeight,
+    SDL_GPUTexture* destination,
+    uint32_t destinationWidth,
+    uint32_t destinationHeight
+) {
+    // Every destination pixel is written, nothing needs loading
+    SDL_GPUBlitInfo blitInfo = {
+        .source = {
+            .texture = source,
+            .x = 0,
+            .y = 0,
+            .w = sourceWidth,
+            .h = sourceHeight,
+        },
+        .destination = {
+            .texture = destination,
+            .x = 0,
+            .y = 0,
+            .w = destinationWidth,
+            .h = destinationHeight,
+        },
+        .load_op = SDL_GPU_LOADOP_DONT_CARE,
+        .filter = SDL_GPU_FILTER_LINEAR,
+        .cycle = false,
+    };
+    SDL_BlitGPUTexture(commandBuffer, &blitInfo);
+}
+
+const DynamicResolutionStats* GetDynamicResolutionStats(const DynamicResolution* resolution) {
+    return &resolution->stats;
+}
+
+void LogDynamicResolutionStats(const DynamicResolution* resolution) {
+    const DynamicResolutionStats* stats = &resolution->stats;
+    SDL_Log(
+        "Dynamic resolution: scale %.2f, %.2f ms average against %.2f ms, lowest scale %.2f, %llu changes, %llu of %llu frames below full",
+        resolution->scale,
+        resolution->averageFrameMS,
+        resolution->targetFrameMS,
+        stats->lowestScale,
+        (unsigned long long)stats->scaleChanges,
+        (unsigned long long)stats->framesBelowFull,
+        (unsigned long long)stats->frames
+    );
+}
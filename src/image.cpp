@@ -0,0 +1,904 @@
+#include "../include/image.hpp"
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_timer.h>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IMAGE_USE_SSE2 1
+#endif
+
+static ImageDecodeStats decodeStats[IMAGE_FORMAT_COUNT];
+
+static uint32_t ReadBE32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint32_t Load32(const uint8_t* p) {
+    uint32_t v;
+    SDL_memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void Store32(uint8_t* p, uint32_t v) {
+    SDL_memcpy(p, &v, sizeof(v));
+}
+
+bool IsQOI(const uint8_t* data, size_t size) {
+    return size >= 4 && SDL_memcmp(data, "qoif", 4) == 0;
+}
+
+bool IsPNG(const uint8_t* data, size_t size) {
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    return size >= 8 && SDL_memcmp(data, signature, 8) == 0;
+}
+
+// QOI
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xC0
+#define QOI_OP_RGB   0xFE
+#define QOI_OP_RGBA  0xFF
+#define QOI_MASK_2   0xC0
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8
+#define QOI_PIXELS_MAX 400000000u
+
+SDL_Surface* DecodeQOI(const uint8_t* data, size_t size) {
+    if (!IsQOI(data, size) || size < QOI_HEADER_SIZE + QOI_PADDING_SIZE) {
+        SDL_SetError("Not a QOI file");
+        return NULL;
+    }
+
+    uint32_t width = ReadBE32(data + 4);
+    uint32_t height = ReadBE32(data + 8);
+    uint8_t channels = data[12];
+    if (width == 0 || height == 0 || channels < 3 || channels > 4 || height >= QOI_PIXELS_MAX / width) {
+        SDL_SetError("Invalid QOI header");
+        return NULL;
+    }
+
+    SDL_Surface* surface = SDL_CreateSurface((int)width, (int)height, SDL_PIXELFORMAT_RGBA32);
+    if (surface == NULL) {
+        return NULL;
+    }
+
+    uint8_t index[64][4] = {};
+    uint8_t px[4] = { 0, 0, 0, 255 };
+    uint32_t run = 0;
+    size_t p = QOI_HEADER_SIZE;
+    size_t chunksEnd = size - QOI_PADDING_SIZE;
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* row = static_cast<uint8_t*>(surface->pixels) + (size_t)y * surface->pitch;
+        uint8_t* rowEnd = row + (size_t)width * 4;
+
+        for (uint8_t* out = row; out < rowEnd; out += 4) {
+            if (run > 0) {
+                run--;
+            } else if (p < chunksEnd) {
+                uint8_t b1 = data[p++];
+
+                if (b1 == QOI_OP_RGB) {
+                    px[0] = data[p];
+                    px[1] = data[p + 1];
+                    px[2] = data[p + 2];
+                    p += 3;
+                } else if (b1 == QOI_OP_RGBA) {
+                    SDL_memcpy(px, data + p, 4);
+                    p += 4;
+                } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+                    SDL_memcpy(px, index[b1], 4);
+                } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+                    px[0] += ((b1 >> 4) & 0x03) - 2;
+                    px[1] += ((b1 >> 2) & 0x03) - 2;
+                    px[2] += (b1 & 0x03) - 2;
+                } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+                    uint8_t b2 = data[p++];
+                    int vg = (b1 & 0x3F) - 32;
+                    px[0] += vg - 8 + ((b2 >> 4) & 0x0F);
+                    px[1] += vg;
+                    px[2] += vg - 8 + (b2 & 0x0F);
+                } else {
+                    run = b1 & 0x3F;
+                }
+
+                SDL_memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) & 63], px, 4);
+            }
+
+            SDL_memcpy(out, px, 4);
+        }
+    }
+
+    return surface;
+}
+
+// Inflate (RFC 1950/1951), only what PNG needs
+
+#define ZFAST_BITS 9
+#define ZFAST_MASK ((1 << ZFAST_BITS) - 1)
+#define ZNUM_SYMBOLS 288
+
+struct ZHuffman {
+    uint16_t fast[1 << ZFAST_BITS];
+    uint16_t firstCode[16];
+    int maxCode[17];
+    uint16_t firstSymbol[16];
+    uint8_t size[ZNUM_SYMBOLS];
+    uint16_t value[ZNUM_SYMBOLS];
+};
+
+struct Inflater {
+    const uint8_t* in;
+    const uint8_t* inEnd;
+    uint64_t bitBuffer;
+    int numBits;
+    uint8_t* out;
+    uint8_t* outCursor;
+    uint8_t* outEnd;
+};
+
+static const uint16_t lengthBase[31] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258, 0, 0
+};
+static const uint8_t lengthExtra[31] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0, 0, 0
+};
+static const uint16_t distBase[32] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577, 0, 0
+};
+static const uint8_t distExtra[32] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 0, 0
+};
+
+static int BitReverse16(int n) {
+    n = ((n & 0xAAAA) >> 1) | ((n & 0x5555) << 1);
+    n = ((n & 0xCCCC) >> 2) | ((n & 0x3333) << 2);
+    n = ((n & 0xF0F0) >> 4) | ((n & 0x0F0F) << 4);
+    n = ((n & 0xFF00) >> 8) | ((n & 0x00FF) << 8);
+    return n;
+}
+
+static int BitReverse(int v, int bits) {
+    return BitReverse16(v) >> (16 - bits);
+}
+
+static bool BuildHuffman(ZHuffman* z, const uint8_t* sizeList, int num) {
+    int sizes[17] = {};
+    int nextCode[16];
+    int code = 0;
+    int k = 0;
+
+    SDL_memset(z->fast, 0, sizeof(z->fast));
+    for (int i = 0; i < num; ++i) {
+        ++sizes[sizeList[i]];
+    }
+    sizes[0] = 0;
+    for (int i = 1; i < 16; ++i) {
+        if (sizes[i] > (1 << i)) {
+            return SDL_SetError("Bad huffman code lengths");
+        }
+    }
+
+    for (int i = 1; i < 16; ++i) {
+        nextCode[i] = code;
+        z->firstCode[i] = (uint16_t)code;
+        z->firstSymbol[i] = (uint16_t)k;
+        code += sizes[i];
+        if (sizes[i] && code - 1 >= (1 << i)) {
+            return SDL_SetError("Bad huffman code lengths");
+        }
+        z->maxCode[i] = code << (16 - i);
+        code <<= 1;
+        k += sizes[i];
+    }
+    z->maxCode[16] = 0x10000;
+
+    for (int i = 0; i < num; ++i) {
+        int s = sizeList[i];
+        if (s == 0) {
+            continue;
+        }
+        int c = nextCode[s] - z->firstCode[s] + z->firstSymbol[s];
+        z->size[c] = (uint8_t)s;
+        z->value[c] = (uint16_t)i;
+        if (s <= ZFAST_BITS) {
+            uint16_t fastValue = (uint16_t)((s << 9) | i);
+            for (int j = BitReverse(nextCode[s], s); j < (1 << ZFAST_BITS); j += (1 << s)) {
+                z->fast[j] = fastValue;
+            }
+        }
+        ++nextCode[s];
+    }
+    return true;
+}
+
+static void FillBits(Inflater* z) {
+    // Past the end we feed zeros; the caller notices truncation through the output size
+    while (z->numBits <= 56) {
+        uint64_t byte = z->in < z->inEnd ? *z->in++ : 0;
+        z->bitBuffer |= byte << z->numBits;
+        z->numBits += 8;
+    }
+}
+
+static uint32_t ReceiveBits(Inflater* z, int n) {
+    if (z->numBits < n) {
+        FillBits(z);
+    }
+    uint32_t v = (uint32_t)(z->bitBuffer & ((1ull << n) - 1));
+    z->bitBuffer >>= n;
+    z->numBits -= n;
+    return v;
+}
+
+static int DecodeSymbol(Inflater* z, const ZHuffman* h) {
+    if (z->numBits < 16) {
+        FillBits(z);
+    }
+
+    int b = h->fast[z->bitBuffer & ZFAST_MASK];
+    if (b) {
+        int s = b >> 9;
+        z->bitBuffer >>= s;
+        z->numBits -= s;
+        return b & 511;
+    }
+
+    int k = BitReverse((int)(z->bitBuffer & 0xFFFF), 16);
+    int s;
+    for (s = ZFAST_BITS + 1; k >= h->maxCode[s]; ++s) {}
+    if (s >= 16) {
+        return -1;
+    }
+    b = (k >> (16 - s)) - h->firstCode[s] + h->firstSymbol[s];
+    if (b >= ZNUM_SYMBOLS || h->size[b] != s) {
+        return -1;
+    }
+    z->bitBuffer >>= s;
+    z->numBits -= s;
+    return h->value[b];
+}
+
+static bool InflateHuffmanBlock(Inflater* z, const ZHuffman* lengthCodes, const ZHuffman* distCodes) {
+    uint8_t* out = z->outCursor;
+    for (;;) {
+        int symbol = DecodeSymbol(z, lengthCodes);
+        if (symbol < 256) {
+            if (symbol < 0) {
+                return SDL_SetError("Bad huffman code");
+            }
+            if (out >= z->outEnd) {
+                return SDL_SetError("Inflate output overflow");
+            }
+            *out++ = (uint8_t)symbol;
+            continue;
+        }
+        if (symbol == 256) {
+            z->outCursor = out;
+            return true;
+        }
+
+        symbol -= 257;
+        if (symbol >= 29) {
+            return SDL_SetError("Bad length symbol");
+        }
+        int length = lengthBase[symbol];
+        if (lengthExtra[symbol]) {
+            length += ReceiveBits(z, lengthExtra[symbol]);
+        }
+
+        symbol = DecodeSymbol(z, distCodes);
+        if (symbol < 0 || symbol >= 30) {
+            return SDL_SetError("Bad distance symbol");
+        }
+        int dist = distBase[symbol];
+        if (distExtra[symbol]) {
+            dist += ReceiveBits(z, distExtra[symbol]);
+        }
+
+        if (out - z->out < dist) {
+            return SDL_SetError("Bad distance");
+        }
+        if (z->outEnd - out < length) {
+            return SDL_SetError("Inflate output overflow");
+        }
+
+        const uint8_t* src = out - dist;
+        if (dist >= 8 && length >= 8) {
+            // Non-overlapping 8 byte steps, the tail is handled byte-wise
+            while (length >= 8) {
+                SDL_memcpy(out, src, 8);
+                out += 8;
+                src += 8;
+                length -= 8;
+            }
+        }
+        while (length--) {
+            *out++ = *src++;
+        }
+    }
+}
+
+static bool InflateStoredBlock(Inflater* z) {
+    ReceiveBits(z, z->numBits & 7);
+    uint32_t length = ReceiveBits(z, 16);
+    uint32_t nlength = ReceiveBits(z, 16);
+    if ((length ^ 0xFFFF) != nlength) {
+        return SDL_SetError("Corrupt stored block");
+    }
+    if ((uint32_t)(z->outEnd - z->outCursor) < length) {
+        return SDL_SetError("Inflate output overflow");
+    }
+
+    // Drain whole bytes still sitting in the bit buffer before copying from the input
+    while (length > 0 && z->numBits >= 8) {
+        *z->outCursor++ = (uint8_t)ReceiveBits(z, 8);
+        length--;
+    }
+    if ((uint32_t)(z->inEnd - z->in) < length) {
+        return SDL_SetError("Truncated stored block");
+    }
+    SDL_memcpy(z->outCursor, z->in, length);
+    z->outCursor += length;
+    z->in += length;
+    return true;
+}
+
+static bool BuildFixedHuffman(ZHuffman* lengthCodes, ZHuffman* distCodes) {
+    uint8_t sizes[ZNUM_SYMBOLS];
+    int i = 0;
+    for (; i <= 143; ++i) sizes[i] = 8;
+    for (; i <= 255; ++i) sizes[i] = 9;
+    for (; i <= 279; ++i) sizes[i] = 7;
+    for (; i <= 287; ++i) sizes[i] = 8;
+
+    uint8_t distSizes[32];
+    SDL_memset(distSizes, 5, sizeof(distSizes));
+    return BuildHuffman(lengthCodes, sizes, ZNUM_SYMBOLS) && BuildHuffman(distCodes, distSizes, 32);
+}
+
+static bool BuildDynamicHuffman(Inflater* z, ZHuffman* lengthCodes, ZHuffman* distCodes) {
+    static const uint8_t lengthDezigzag[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    ZHuffman codeLengthCodes;
+    uint8_t codeLengthSizes[19] = {};
+    uint8_t sizes[286 + 32 + 137];
+
+    int hlit = ReceiveBits(z, 5) + 257;
+    int hdist = ReceiveBits(z, 5) + 1;
+    int hclen = ReceiveBits(z, 4) + 4;
+    int total = hlit + hdist;
+
+    for (int i = 0; i < hclen; ++i) {
+        codeLengthSizes[lengthDezigzag[i]] = (uint8_t)ReceiveBits(z, 3);
+    }
+    if (!BuildHuffman(&codeLengthCodes, codeLengthSizes, 19)) {
+        return false;
+    }
+
+    int n = 0;
+    while (n < total) {
+        int c = DecodeSymbol(z, &codeLengthCodes);
+        if (c < 0 || c >= 19) {
+            return SDL_SetError("Bad code lengths");
+        }
+        if (c < 16) {
+            sizes[n++] = (uint8_t)c;
+            continue;
+        }
+
+        uint8_t fill = 0;
+        int repeat;
+        if (c == 16) {
+            if (n == 0) {
+                return SDL_SetError("Bad code lengths");
+            }
+            repeat = ReceiveBits(z, 2) + 3;
+            fill = sizes[n - 1];
+        } else if (c == 17) {
+            repeat = ReceiveBits(z, 3) + 3;
+        } else {
+            repeat = ReceiveBits(z, 7) + 11;
+        }
+        if (total - n < repeat) {
+            return SDL_SetError("Bad code lengths");
+        }
+        SDL_memset(sizes + n, fill, repeat);
+        n += repeat;
+    }
+
+    return BuildHuffman(lengthCodes, sizes, hlit) && BuildHuffman(distCodes, sizes + hlit, hdist);
+}
+
+static bool ZlibInflate(const uint8_t* in, size_t inSize, uint8_t* out, size_t outSize) {
+    if (inSize < 2) {
+        return SDL_SetError("Truncated zlib stream");
+    }
+    uint8_t cmf = in[0];
+    uint8_t flg = in[1];
+    if ((cmf * 256 + flg) % 31 != 0 || (cmf & 15) != 8 || (flg & 32)) {
+        return SDL_SetError("Unsupported zlib stream");
+    }
+
+    Inflater z = {
+        .in = in + 2,
+        .inEnd = in + inSize,
+        .bitBuffer = 0,
+        .numBits = 0,
+        .out = out,
+        .outCursor = out,
+        .outEnd = out + outSize,
+    };
+
+    ZHuffman lengthCodes;
+    ZHuffman distCodes;
+    bool final;
+    do {
+        final = ReceiveBits(&z, 1);
+        uint32_t type = ReceiveBits(&z, 2);
+        bool ok;
+        if (type == 0) {
+            ok = InflateStoredBlock(&z);
+        } else if (type == 1) {
+            ok = BuildFixedHuffman(&lengthCodes, &distCodes) && InflateHuffmanBlock(&z, &lengthCodes, &distCodes);
+        } else if (type == 2) {
+            ok = BuildDynamicHuffman(&z, &lengthCodes, &distCodes) && InflateHuffmanBlock(&z, &lengthCodes, &distCodes);
+        } else {
+            ok = SDL_SetError("Bad deflate block type");
+        }
+        if (!ok) {
+            return false;
+        }
+    } while (!final);
+
+    if (z.outCursor != z.outEnd) {
+        return SDL_SetError("Truncated image data");
+    }
+    return true;
+}
+
+// PNG
+
+// Same limit as QOI_PIXELS_MAX, the side limit alone still allows terabyte images
+#define PNG_PIXELS_MAX 400000000u
+// Deflate cannot expand input more than about 1032 times
+#define DEFLATE_MAX_RATIO 1032
+
+enum PNGFilter {
+    PNG_FILTER_NONE,
+    PNG_FILTER_SUB,
+    PNG_FILTER_UP,
+    PNG_FILTER_AVERAGE,
+    PNG_FILTER_PAETH,
+};
+
+static uint8_t Paeth(int a, int b, int c) {
+    int pa = SDL_abs(b - c);
+    int pb = SDL_abs(a - c);
+    int pc = SDL_abs(a + b - 2 * c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    if (pb <= pc) return (uint8_t)b;
+    return (uint8_t)c;
+}
+
+static void UnfilterUp(uint8_t* row, const uint8_t* prior, size_t rowBytes) {
+    size_t i = 0;
+#ifdef IMAGE_USE_SSE2
+    for (; i + 16 <= rowBytes; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), _mm_add_epi8(x, b));
+    }
+#endif
+    for (; i < rowBytes; ++i) {
+        row[i] += prior[i];
+    }
+}
+
+#ifdef IMAGE_USE_SSE2
+// Sub, Average and Paeth carry a dependency from one pixel to the next, so for RGBA8 the
+// vector unit works on one whole pixel (4 lanes) per step instead of one byte.
+static void UnfilterSub4(uint8_t* row, size_t rowBytes) {
+    __m128i a = _mm_setzero_si128();
+    for (size_t i = 0; i < rowBytes; i += 4) {
+        __m128i x = _mm_cvtsi32_si128((int)Load32(row + i));
+        a = _mm_add_epi8(x, a);
+        Store32(row + i, (uint32_t)_mm_cvtsi128_si32(a));
+    }
+}
+
+static void UnfilterAverage4(uint8_t* row, const uint8_t* prior, size_t rowBytes) {
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i a = _mm_setzero_si128();
+    for (size_t i = 0; i < rowBytes; i += 4) {
+        __m128i b = _mm_cvtsi32_si128((int)Load32(prior + i));
+        __m128i x = _mm_cvtsi32_si128((int)Load32(row + i));
+        // avg_epu8 rounds up, PNG wants floor((a + b) / 2)
+        __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+        a = _mm_add_epi8(x, average);
+        Store32(row + i, (uint32_t)_mm_cvtsi128_si32(a));
+    }
+}
+
+static void UnfilterPaeth4(uint8_t* row, const uint8_t* prior, size_t rowBytes) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a = zero;
+    __m128i c = zero;
+    for (size_t i = 0; i < rowBytes; i += 4) {
+        __m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)Load32(prior + i)), zero);
+        __m128i x = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)Load32(row + i)), zero);
+
+        __m128i bc = _mm_sub_epi16(b, c);
+        __m128i ac = _mm_sub_epi16(a, c);
+        __m128i pa = _mm_max_epi16(bc, _mm_sub_epi16(zero, bc));
+        __m128i pb = _mm_max_epi16(ac, _mm_sub_epi16(zero, ac));
+        __m128i abc = _mm_add_epi16(bc, ac);
+        __m128i pc = _mm_max_epi16(abc, _mm_sub_epi16(zero, abc));
+
+        __m128i smallest = _mm_min_epi16(_mm_min_epi16(pa, pb), pc);
+        __m128i useA = _mm_cmpeq_epi16(pa, smallest);
+        __m128i useB = _mm_andnot_si128(useA, _mm_cmpeq_epi16(pb, smallest));
+        __m128i useC = _mm_andnot_si128(_mm_or_si128(useA, useB), _mm_set1_epi16(-1));
+        __m128i predictor = _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(useA, a), _mm_and_si128(useB, b)),
+            _mm_and_si128(useC, c)
+        );
+
+        c = b;
+        a = _mm_and_si128(_mm_add_epi16(x, predictor), _mm_set1_epi16(0xFF));
+        Store32(row + i, (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(a, zero)));
+    }
+}
+#endif
+
+static bool UnfilterRow(uint8_t filter, uint8_t* row, const uint8_t* prior, size_t rowBytes, size_t bpp) {
+    switch (filter) {
+    case PNG_FILTER_NONE:
+        return true;
+    case PNG_FILTER_SUB:
+#ifdef IMAGE_USE_SSE2
+        if (bpp == 4) {
+            UnfilterSub4(row, rowBytes);
+            return true;
+        }
+#endif
+        for (size_t i = bpp; i < rowBytes; ++i) {
+            row[i] += row[i - bpp];
+        }
+        return true;
+    case PNG_FILTER_UP:
+        UnfilterUp(row, prior, rowBytes);
+        return true;
+    case PNG_FILTER_AVERAGE:
+#ifdef IMAGE_USE_SSE2
+        if (bpp == 4) {
+            UnfilterAverage4(row, prior, rowBytes);
+            return true;
+        }
+#endif
+        for (size_t i = 0; i < bpp; ++i) {
+            row[i] += prior[i] >> 1;
+        }
+        for (size_t i = bpp; i < rowBytes; ++i) {
+            row[i] += (uint8_t)((row[i - bpp] + prior[i]) >> 1);
+        }
+        return true;
+    case PNG_FILTER_PAETH:
+#ifdef IMAGE_USE_SSE2
+        if (bpp == 4) {
+            UnfilterPaeth4(row, prior, rowBytes);
+            return true;
+        }
+#endif
+        for (size_t i = 0; i < bpp; ++i) {
+            row[i] += prior[i];
+        }
+        for (size_t i = bpp; i < rowBytes; ++i) {
+            row[i] += Paeth(row[i - bpp], prior[i], prior[i - bpp]);
+        }
+        return true;
+    default:
+        return SDL_SetError("Bad PNG filter type %d", filter);
+    }
+}
+
+static uint16_t ReadSample(const uint8_t* row, uint32_t index, uint8_t bitDepth) {
+    if (bitDepth == 8) {
+        return row[index];
+    }
+    if (bitDepth == 16) {
+        return (uint16_t)((row[index * 2] << 8) | row[index * 2 + 1]);
+    }
+    uint32_t bit = index * bitDepth;
+    return (uint16_t)((row[bit >> 3] >> (8 - bitDepth - (bit & 7))) & ((1 << bitDepth) - 1));
+}
+
+static uint8_t ScaleSample(uint16_t sample, uint8_t bitDepth) {
+    if (bitDepth == 16) {
+        return (uint8_t)(sample >> 8);
+    }
+    if (bitDepth == 8) {
+        return (uint8_t)sample;
+    }
+    return (uint8_t)(sample * 255 / ((1 << bitDepth) - 1));
+}
+
+struct PNGHeader {
+    uint32_t width;
+    uint32_t height;
+    uint8_t bitDepth;
+    uint8_t colorType;
+    uint8_t interlace;
+};
+
+struct PNGColorKey {
+    bool enabled;
+    uint16_t values[3];
+};
+
+static void ExpandRow(
+    const PNGHeader* header,
+    const uint8_t* row,
+    uint8_t* out,
+    const uint8_t* palette,
+    const PNGColorKey* key
+) {
+    uint8_t depth = header->bitDepth;
+
+    if (header->colorType == 6 && depth == 8) {
+        SDL_memcpy(out, row, (size_t)header->width * 4);
+        return;
+    }
+
+    if (header->colorType == 2 && depth == 8 && !key->enabled) {
+        for (uint32_t x = 0; x < header->width; ++x) {
+            out[x * 4 + 0] = row[x * 3 + 0];
+            out[x * 4 + 1] = row[x * 3 + 1];
+            out[x * 4 + 2] = row[x * 3 + 2];
+            out[x * 4 + 3] = 255;
+        }
+        return;
+    }
+
+    for (uint32_t x = 0; x < header->width; ++x) {
+        uint8_t* px = out + x * 4;
+        switch (header->colorType) {
+        case 0: {
+            uint16_t g = ReadSample(row, x, depth);
+            px[0] = px[1] = px[2] = ScaleSample(g, depth);
+            px[3] = (key->enabled && g == key->values[0]) ? 0 : 255;
+            break;
+        }
+        case 2: {
+            uint16_t r = ReadSample(row, x * 3 + 0, depth);
+            uint16_t g = ReadSample(row, x * 3 + 1, depth);
+            uint16_t b = ReadSample(row, x * 3 + 2, depth);
+            px[0] = ScaleSample(r, depth);
+            px[1] = ScaleSample(g, depth);
+            px[2] = ScaleSample(b, depth);
+            px[3] = (key->enabled && r == key->values[0] && g == key->values[1] && b == key->values[2]) ? 0 : 255;
+            break;
+        }
+        case 3:
+            SDL_memcpy(px, palette + ReadSample(row, x, depth) * 4, 4);
+            break;
+        case 4:
+            px[0] = px[1] = px[2] = ScaleSample(ReadSample(row, x * 2 + 0, depth), depth);
+            px[3] = ScaleSample(ReadSample(row, x * 2 + 1, depth), depth);
+            break;
+        case 6:
+            for (uint32_t c = 0; c < 4; ++c) {
+                px[c] = ScaleSample(ReadSample(row, x * 4 + c, depth), depth);
+            }
+            break;
+        }
+    }
+}
+
+static uint32_t PNGChannels(uint8_t colorType) {
+    switch (colorType) {
+    case 0: return 1;
+    case 2: return 3;
+    case 3: return 1;
+    case 4: return 2;
+    case 6: return 4;
+    default: return 0;
+    }
+}
+
+SDL_Surface* DecodePNG(const uint8_t* data, size_t size) {
+    if (!IsPNG(data, size)) {
+        SDL_SetError("Not a PNG file");
+        return NULL;
+    }
+
+    PNGHeader header = {};
+    PNGColorKey key = {};
+    uint8_t palette[256 * 4];
+    uint32_t paletteSize = 0;
+    std::vector<uint8_t> compressed;
+    bool haveHeader = false;
+
+    for (size_t i = 0; i < SDL_arraysize(palette); i += 4) {
+        palette[i + 0] = palette[i + 1] = palette[i + 2] = 0;
+        palette[i + 3] = 255;
+    }
+
+    size_t p = 8;
+    for (;;) {
+        if (size - p < 12) {
+            SDL_SetError("Truncated PNG");
+            return NULL;
+        }
+        uint32_t length = ReadBE32(data + p);
+        const uint8_t* type = data + p + 4;
+        const uint8_t* chunk = data + p + 8;
+        if (length > size - p - 12) {
+            SDL_SetError("Truncated PNG chunk");
+            return NULL;
+        }
+        p += 12 + (size_t)length;
+
+        if (SDL_memcmp(type, "IHDR", 4) == 0) {
+            if (length != 13) {
+                SDL_SetError("Bad IHDR");
+                return NULL;
+            }
+            header.width = ReadBE32(chunk);
+            header.height = ReadBE32(chunk + 4);
+            header.bitDepth = chunk[8];
+            header.colorType = chunk[9];
+            header.interlace = chunk[12];
+            haveHeader = true;
+        } else if (SDL_memcmp(type, "PLTE", 4) == 0) {
+            paletteSize = SDL_min(length / 3, 256u);
+            for (uint32_t i = 0; i < paletteSize; ++i) {
+                SDL_memcpy(palette + i * 4, chunk + i * 3, 3);
+            }
+        } else if (SDL_memcmp(type, "tRNS", 4) == 0) {
+            if (header.colorType == 3) {
+                for (uint32_t i = 0; i < SDL_min(length, 256u); ++i) {
+                    palette[i * 4 + 3] = chunk[i];
+                }
+            } else if (header.colorType == 0 && length >= 2) {
+                key.enabled = true;
+                key.values[0] = (uint16_t)((chunk[0] << 8) | chunk[1]);
+            } else if (header.colorType == 2 && length >= 6) {
+                key.enabled = true;
+                for (int c = 0; c < 3; ++c) {
+                    key.values[c] = (uint16_t)((chunk[c * 2] << 8) | chunk[c * 2 + 1]);
+                }
+            }
+        } else if (SDL_memcmp(type, "IDAT", 4) == 0) {
+            compressed.insert(compressed.end(), chunk, chunk + length);
+        } else if (SDL_memcmp(type, "IEND", 4) == 0) {
+            break;
+        } else if (!(type[0] & 32)) {
+            SDL_SetError("Unknown critical PNG chunk %.4s", reinterpret_cast<const char*>(type));
+            return NULL;
+        }
+    }
+
+    uint32_t channels = PNGChannels(header.colorType);
+    uint8_t depth = header.bitDepth;
+    bool depthValid = (depth == 8) || (depth == 16 && header.colorType != 3) ||
+        ((depth == 1 || depth == 2 || depth == 4) && (header.colorType == 0 || header.colorType == 3));
+    if (!haveHeader || channels == 0 || !depthValid || header.width == 0 || header.height == 0 ||
+        header.width > (1u << 24) || header.height > (1u << 24) || header.height > PNG_PIXELS_MAX / header.width) {
+        SDL_SetError("Unsupported PNG header");
+        return NULL;
+    }
+    if (header.interlace != 0) {
+        SDL_SetError("Interlaced PNG is not supported");
+        return NULL;
+    }
+    if (header.colorType == 3 && paletteSize == 0) {
+        SDL_SetError("Palette PNG without PLTE");
+        return NULL;
+    }
+
+    size_t bitsPerPixel = (size_t)channels * depth;
+    size_t bpp = SDL_max(bitsPerPixel / 8, (size_t)1);
+    size_t rowBytes = (header.width * bitsPerPixel + 7) / 8;
+    size_t stride = rowBytes + 1;
+
+    // Rejects a small file that claims a huge image before allocating for it
+    if (stride * header.height / DEFLATE_MAX_RATIO > compressed.size()) {
+        SDL_SetError("PNG image data is too short for %ux%u pixels", header.width, header.height);
+        return NULL;
+    }
+    std::vector<uint8_t> raw(stride * header.height);
+    if (!ZlibInflate(compressed.data(), compressed.size(), raw.data(), raw.size())) {
+        return NULL;
+    }
+
+    SDL_Surface* surface = SDL_CreateSurface((int)header.width, (int)header.height, SDL_PIXELFORMAT_RGBA32);
+    if (surface == NULL) {
+        return NULL;
+    }
+
+    // Filters run in place over the inflated buffer, the first row sees an all-zero prior row
+    std::vector<uint8_t> zeroRow(rowBytes, 0);
+    const uint8_t* prior = zeroRow.data();
+    for (uint32_t y = 0; y < header.height; ++y) {
+        uint8_t* row = raw.data() + y * stride;
+        if (!UnfilterRow(row[0], row + 1, prior, rowBytes, bpp)) {
+            SDL_DestroySurface(surface);
+            return NULL;
+        }
+        ExpandRow(&header, row + 1, static_cast<uint8_t*>(surface->pixels) + (size_t)y * surface->pitch, palette, &key);
+        prior = row + 1;
+    }
+
+    return surface;
+}
+
+SDL_Surface* DecodeImage(const uint8_t* data, size_t size) {
+    ImageFormat format = IMAGE_FORMAT_BMP;
+    if (IsQOI(data, size)) {
+        format = IMAGE_FORMAT_QOI;
+    } else if (IsPNG(data, size)) {
+        format = IMAGE_FORMAT_PNG;
+    }
+
+    Uint64 start = SDL_GetTicksNS();
+    SDL_Surface* surface;
+    switch (format) {
+    case IMAGE_FORMAT_QOI:
+        surface = DecodeQOI(data, size);
+        break;
+    case IMAGE_FORMAT_PNG:
+        surface = DecodePNG(data, size);
+        break;
+    default:
+        surface = SDL_LoadBMP_IO(SDL_IOFromConstMem(data, size), true);
+        break;
+    }
+    if (surface == NULL) {
+        return NULL;
+    }
+
+    ImageDecodeStats* stats = &decodeStats[format];
+    stats->imageCount++;
+    stats->inputBytes += size;
+    stats->outputBytes += (uint64_t)surface->pitch * surface->h;
+    stats->decodeNS += SDL_GetTicksNS() - start;
+    return surface;
+}
+
+const ImageDecodeStats* GetImageDecodeStats(ImageFormat format) {
+    return &decodeStats[format];
+}
+
+double ImageDecodeThroughputMBs(const ImageDecodeStats* stats) {
+    if (stats->decodeNS == 0) {
+        return 0.0;
+    }
+    return ((double)stats->outputBytes / (1024.0 * 1024.0)) / ((double)stats->decodeNS / SDL_NS_PER_SECOND);
+}
+
+void LogImageDecodeStats() {
+    static const char* formatNames[IMAGE_FORMAT_COUNT] = { "BMP", "QOI", "PNG" };
+    for (int i = 0; i < IMAGE_FORMAT_COUNT; ++i) {
+        const ImageDecodeStats* stats = &decodeStats[i];
+        if (stats->imageCount == 0) {
+            continue;
+        }
+        SDL_Log(
+            "%s: %u images, %.2f MB in, %.2f MB out, %.2f ms, %.1f MB/s",
+            formatNames[i],
+            stats->imageCount,
+            (double)stats->inputBytes / (1024.0 * 1024.0),
+            (double)stats->outputBytes / (1024.0 * 1024.0),
+            (double)stats->decodeNS / SDL_NS_PER_MS,
+            ImageDecodeThroughputMBs(stats)
+        );
+    }
+}
@@ -0,0 +1,282 @@
+#include "../include/indirect_draw.hpp"
+#include "../include/meshlet.hpp"
+#include "../include/uniform_block.hpp"
+#include <SDL3/SDL.h>
+
+// numthreads of cullDraws.comp.hlsl
+#define CULL_DRAWS_GROUP_SIZE 64
+
+struct CullUniforms {
+    float planes[6][4];
+    uint32_t objectCount;
+    uint32_t padding[3];
+};
+
+static_assert(sizeof(IndirectDrawObject) == 32);
+static_assert(sizeof(SDL_GPUIndexedIndirectDrawCommand) == 20);
+
+CHECK_UNIFORM_BLOCK_IF_BUILT(
+    CullUniforms,
+    "cullDraws.comp",
+    0,
+    UNIFORM_MEMBER(CullUniforms, planes),
+    UNIFORM_MEMBER(CullUniforms, objectCount)
+);
+
+bool CreateIndirectDrawList(SDL_GPUDevice* GPUDevice, IndirectDrawList* list, uint32_t capacity) {
+    *list = {};
+    list->capacity = capacity;
+
+    list->cullPipeline = CreateComputePipelineFromShader(GPUDevice, "cullDraws.comp");
+    if (list->cullPipeline == NULL) {
+        SDL_LogError(1, "Failed to create draw culling pipeline");
+        return false;
+    }
+
+    SDL_GPUBufferCreateInfo objectInfo = {
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ,
+        .size = capacity * (uint32_t)sizeof(IndirectDrawObject),
+    };
+    SDL_GPUBufferCreateInfo indirectInfo = {
+        .usage = SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+        .size = capacity * (uint32_t)sizeof(SDL_GPUIndexedIndirectDrawCommand),
+    };
+    SDL_GPUBufferCreateInfo countInfo = {
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+        .size = sizeof(uint32_t),
+    };
+    list->objectBuffer = SDL_CreateGPUBuffer(GPUDevice, &objectInfo);
+    list->indirectBuffer = SDL_CreateGPUBuffer(GPUDevice, &indirectInfo);
+    list->countBuffer = SDL_CreateGPUBuffer(GPUDevice, &countInfo);
+    if (list->objectBuffer == NULL || list->indirectBuffer == NULL || list->countBuffer == NULL) {
+        SDL_LogError(1, "Failed to create indirect draw buffers! error: %s", SDL_GetError());
+        DestroyIndirectDrawList(GPUDevice, list);
+        return false;
+    }
+    return true;
+}
+
+void DestroyIndirectDrawList(SDL_GPUDevice* GPUDevice, IndirectDrawList* list) {
+    if (list->cullPipeline != NULL) {
+        SDL_ReleaseGPUComputePipeline(GPUDevice, list->cullPipeline);
+    }
+    if (list->objectBuffer != NULL) {
+        SDL_ReleaseGPUBuffer(GPUDevice, list->objectBuffer);
+    }
+    if (list->indirectBuffer != NULL) {
+        SDL_ReleaseGPUBuffer(GPUDevice, list->indirectBuffer);
+    }
+    if (list->countBuffer != NULL) {
+        SDL_ReleaseGPUBuffer(GPUDevice, list->countBuffer);
+    }
+    *list = {};
+}
+
+uint32_t AddIndirectDrawObject(
+    IndirectDrawList* list,
+    const MeshPool* pool,
+    MeshHandle mesh,
+    const float center[3],
+    float radius,
+    uint32_t firstInstance
+) {
+    const PooledMesh* pooled = GetMesh(pool, mesh);
+    if (pooled == NULL) {
+        SDL_LogWarn(1, "AddIndirectDrawObject called with a mesh that is not in the pool");
+        return UINT32_MAX;
+    }
+    if (list->objects.size() >= list->capacity) {
+        SDL_LogError(1, "Indirect draw list is full (%u objects)", list->capacity);
+        return UINT32_MAX;
+    }
+
+    list->objects.push_back({
+        .center = { center[0], center[1], center[2] },
+        .radius = radius,
+        .firstIndex = pooled->firstIndex,
+        .indexCount = pooled->indexCount,
+        .vertexOffset = pooled->vertexOffset,
+        .firstInstance = firstInstance,
+    });
+    list->objectMeshes.push_back(mesh);
+    list->dirty = true;
+    return (uint32_t)list->objects.size() - 1;
+}
+
+void MoveIndirectDrawObject(IndirectDrawList* list, uint32_t object, const float center[3], float radius) {
+    if (object >= list->objects.size()) {
+        SDL_LogWarn(1, "MoveIndirectDrawObject called with object %u, the list has %zu", object, list->objects.size());
+        return;
+    }
+    IndirectDrawObject* target = &list->objects[object];
+    target->center[0] = center[0];
+    target->center[1] = center[1];
+    target->center[2] = center[2];
+    target->radius = radius;
+    list->dirty = true;
+}
+
+void ClearIndirectDrawObjects(IndirectDrawList* list) {
+    list->objects.clear();
+    list->objectMeshes.clear();
+    list->runs.clear();
+    list->dirty = true;
+}
+
+bool PrepareIndirectDraws(SDL_GPUDevice* GPUDevice, IndirectDrawList* list, const MeshPool* pool, UploadQueue* uploadQueue) {
+    list->stats.frameObjects = 0;
+    list->stats.frameIndirectDraws = 0;
+
+    uint32_t* count = static_cast<uint32_t*>(QueueBufferWrite(GPUDevice, uploadQueue, list->countBuffer, 0, sizeof(uint32_t)));
+    if (count == NULL) {
+        return false;
+    }
+    *count = 0;
+
+    uint32_t objectCount = (uint32_t)list->objects.size();
+    if (!list->dirty || objectCount == 0) {
+        list->dirty = false;
+        return true;
+    }
+
+    // Counting sort by page, in order of first use, so each run binds one set of buffers.
+    // There are only a few pages, a linear search finds an object's run.
+    list->runs.clear();
+    std::vector<uint32_t> objectRun(objectCount);
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        const PooledMesh* pooled = GetMesh(pool, list->objectMeshes[i]);
+        if (pooled == NULL) {
+            SDL_LogError(1, "Indirect draw object %u refers to a mesh that was removed from the pool", i);
+            list->runs.clear();
+            return false;
+        }
+        uint32_t run = 0;
+        while (run < list->runs.size() && (
+            list->runs[run].vertexBuffer != pooled->vertices.buffer ||
+            list->runs[run].indexBuffer != pooled->indices.buffer ||
+            list->runs[run].indexElementSize != pooled->indexElementSize
+        )) {
+            ++run;
+        }
+        if (run == list->runs.size()) {
+            list->runs.push_back({
+                .vertexBuffer = pooled->vertices.buffer,
+                .indexBuffer = pooled->indices.buffer,
+                .indexElementSize = pooled->indexElementSize,
+                .firstObject = 0,
+                .objectCount = 0,
+            });
+        }
+        objectRun[i] = run;
+        list->runs[run].objectCount++;
+    }
+
+    IndirectDrawObject* objects = static_cast<IndirectDrawObject*>(QueueBufferWrite(
+        GPUDevice,
+        uploadQueue,
+        list->objectBuffer,
+        0,
+        objectCount * (uint32_t)sizeof(IndirectDrawObject)
+    ));
+    if (objects == NULL) {
+        list->runs.clear();
+        return false;
+    }
+
+    std::vector<uint32_t> cursor(list->runs.size());
+    uint32_t next = 0;
+    for (size_t run = 0; run < list->runs.size(); ++run) {
+        cursor[run] = next;
+        list->runs[run].firstObject = next;
+        next += list->runs[run].objectCount;
+    }
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        objects[cursor[objectRun[i]]++] = list->objects[i];
+    }
+
+    list->dirty = false;
+    list->stats.objectUploads += objectCount;
+    return true;
+}
+
+void CullIndirectDraws(IndirectDrawList* list, SDL_GPUCommandBuffer* commandBuffer, const Matrix4x4* viewProjection) {
+    // What the last PrepareIndirectDraws uploaded
+    if (list->runs.empty()) {
+        return;
+    }
+    uint32_t objectCount = list->runs.back().firstObject + list->runs.back().objectCount;
+
+    float planes[8][4];
+    ExtractFrustumPlanes(viewProjection, planes);
+    CullUniforms uniforms = { .objectCount = objectCount };
+    SDL_memcpy(uniforms.planes, planes, sizeof(uniforms.planes));
+
+    // Every command is rewritten, so the previous frame's can be discarded; the count was
+    // just reset by the upload queue and has to be kept
+    SDL_GPUStorageBufferReadWriteBinding storageBindings[] = {
+        { .buffer = list->indirectBuffer, .cycle = true },
+        { .buffer = list->countBuffer, .cycle = false },
+    };
+    SDL_GPUComputePass* computePass = SDL_BeginGPUComputePass(commandBuffer, NULL, 0, storageBindings, SDL_arraysize(storageBindings));
+    SDL_BindGPUComputePipeline(computePass, list->cullPipeline);
+    SDL_BindGPUComputeStorageBuffers(computePass, 0, &list->objectBuffer, 1);
+    SDL_PushGPUComputeUniformData(commandBuffer, 0, &uniforms, sizeof(uniforms));
+    SDL_DispatchGPUCompute(computePass, (objectCount + CULL_DRAWS_GROUP_SIZE - 1) / CULL_DRAWS_GROUP_SIZE, 1, 1);
+    SDL_EndGPUComputePass(computePass);
+
+    list->stats.frameObjects = objectCount;
+    list->stats.totalDispatches++;
+}
+
+void DrawIndirect(IndirectDrawList* list, MeshPool* pool, SDL_GPURenderPass* renderPass) {
+    for (const IndirectDrawRun& run : list->runs) {
+        // Shares the pool's binding state, so DrawMesh calls in the same pass stay correct
+        if (run.vertexBuffer != pool->boundVertexBuffer) {
+            SDL_GPUBufferBinding vertexBufferBinding = {
+                .buffer = run.vertexBuffer,
+                .offset = 0,
+            };
+            SDL_BindGPUVertexBuffers(renderPass, 0, &vertexBufferBinding, 1);
+            pool->boundVertexBuffer = run.vertexBuffer;
+            pool->stats.passBufferBinds++;
+        }
+        if (run.indexBuffer != pool->boundIndexBuffer || run.indexElementSize != pool->boundIndexElementSize) {
+            SDL_GPUBufferBinding indexBufferBinding = {
+                .buffer = run.indexBuffer,
+                .offset = 0,
+            };
+            SDL_BindGPUIndexBuffer(renderPass, &indexBufferBinding, run.indexElementSize);
+            pool->boundIndexBuffer = run.indexBuffer;
+            pool->boundIndexElementSize = run.indexElementSize;
+            pool->stats.passBufferBinds++;
+        }
+        SDL_DrawGPUIndexedPrimitivesIndirect(
+            renderPass,
+            list->indirectBuffer,
+            run.firstObject * (uint32_t)sizeof(SDL_GPUIndexedIndirectDrawCommand),
+            run.objectCount
+        );
+        list->stats.frameIndirectDraws++;
+    }
+    list->stats.totalIndirectDraws += list->runs.size();
+}
+
+SDL_GPUBuffer* GetIndirectDrawCountBuffer(const IndirectDrawList* list) {
+    return list->countBuffer;
+}
+
+const IndirectDrawStats* GetIndirectDrawStats(const IndirectDrawList* list) {
+    return &list->stats;
+}
+
+void LogIndirectDrawStats(const IndirectDrawList* list) {
+    const IndirectDrawStats* stats = &list->stats;
+    SDL_Log(
+        "Indirect draws: %u objects in %u draws, %llu dispatches, %llu draws and %llu object uploads total",
+        stats->frameObjects,
+        stats->frameIndirectDraws,
+        (unsigned long long)stats->totalDispatches,
+        (unsigned long long)stats->totalIndirectDraws,
+        (unsigned long long)stats->objectUploads
+    );
+}
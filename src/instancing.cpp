@@ -0,0 +1,150 @@
+#include "../include/instancing.hpp"
+#include <SDL3/SDL.h>
+
+static_assert(sizeof(InstanceTransform) == 64);
+
+CHECK_UNIFORM_BLOCK_IF_BUILT(InstancedUniforms, "instanced.vert", 0, UNIFORM_MEMBER(InstancedUniforms, viewProjection));
+
+uint32_t VertexElementSize(SDL_GPUVertexElementFormat format) {
+    switch (format) {
+    case SDL_GPU_VERTEXELEMENTFORMAT_INT:
+    case SDL_GPU_VERTEXELEMENTFORMAT_UINT:
+    case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT:
+    case SDL_GPU_VERTEXELEMENTFORMAT_BYTE4:
+    case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4:
+    case SDL_GPU_VERTEXELEMENTFORMAT_BYTE4_NORM:
+    case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM:
+    case SDL_GPU_VERTEXELEMENTFORMAT_SHORT2:
+    case SDL_GPU_VERTEXELEMENTFORMAT_USHORT2:
+    case SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM:
+    case SDL_GPU_VERTEXELEMENTFORMAT_USHORT2_NORM:
+    case SDL_GPU_VERTEXELEMENTFORMAT_HALF2:
+        return 4;
+    case SDL_GPU_VERTEXELEMENTFORMAT_BYTE2:
+    case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE2:
+    case SDL_GPU_VERTEXELEMENTFORMAT_BYTE2_NORM:
+    case SDL_GPU_VERTEXELEMENTFORMAT_UBYTE2_NORM:
+        return 2;
+    case SDL_GPU_VERTEXELEMENTFORMAT_INT2:
+    case SDL_GPU_VERTEXELEMENTFORMAT_UINT2:
+    case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2:
+    case SDL_GPU_VERTEXELEMENTFORMAT_SHORT4:
+    case SDL_GPU_VERTEXELEMENTFORMAT_USHORT4:
+    case SDL_GPU_VERTEXELEMENTFORMAT_SHORT4_NORM:
+    case SDL_GPU_VERTEXELEMENTFORMAT_USHORT4_NORM:
+    case SDL_GPU_VERTEXELEMENTFORMAT_HALF4:
+        return 8;
+    case SDL_GPU_VERTEXELEMENTFORMAT_INT3:
+    case SDL_GPU_VERTEXELEMENTFORMAT_UINT3:
+    case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3:
+        return 12;
+    case SDL_GPU_VERTEXELEMENTFORMAT_INT4:
+    case SDL_GPU_VERTEXELEMENTFORMAT_UINT4:
+    case SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+uint32_t AddVertexBuffer(VertexLayout* layout, SDL_GPUVertexInputRate inputRate) {
+    SDL_assert(layout->bufferCount < VERTEX_LAYOUT_MAX_BUFFERS);
+    uint32_t slot = layout->bufferCount++;
+    layout->buffers[slot] = {
+        .slot = slot,
+        .pitch = 0,
+        .input_rate = inputRate,
+        .instance_step_rate = 0,
+    };
+    return slot;
+}
+
+uint32_t AddVertexAttribute(VertexLayout* layout, uint32_t slot, SDL_GPUVertexElementFormat format) {
+    SDL_assert(slot < layout->bufferCount && layout->attributeCount < VERTEX_LAYOUT_MAX_ATTRIBUTES);
+    uint32_t location = layout->attributeCount++;
+    layout->attributes[location] = {
+        .location = location,
+        .buffer_slot = slot,
+        .format = format,
+        .offset = layout->buffers[slot].pitch,
+    };
+    layout->buffers[slot].pitch += VertexElementSize(format);
+    return location;
+}
+
+SDL_GPUVertexInputState GetVertexInputState(const VertexLayout* layout) {
+    return {
+        .vertex_buffer_descriptions = layout->buffers,
+        .num_vertex_buffers = layout->bufferCount,
+        .vertex_attributes = layout->attributes,
+        .num_vertex_attributes = layout->attributeCount,
+    };
+}
+
+uint32_t AddInstanceTransformBuffer(VertexLayout* layout) {
+    uint32_t slot = AddVertexBuffer(layout, SDL_GPU_VERTEXINPUTRATE_INSTANCE);
+    for (int i = 0; i < 4; ++i) {
+        AddVertexAttribute(layout, slot, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4);
+    }
+    return slot;
+}
+
+InstanceTransform MakeInstanceTransform(const Matrix4x4* model, float r, float g, float b, float a) {
+    // Matrix4x4 transforms row vectors, the shader dots each row with a column vector
+    return {
+        .row0 = { model->m11, model->m21, model->m31, model->m41 },
+        .row1 = { model->m12, model->m22, model->m32, model->m42 },
+        .row2 = { model->m13, model->m23, model->m33, model->m43 },
+        .color = { r, g, b, a },
+    };
+}
+
+bool CreateInstanceStream(
+    SDL_GPUDevice* GPUDevice,
+    InstanceStream* stream,
+    uint32_t instancePitch,
+    uint32_t maxInstances,
+    uint32_t framesInFlight
+) {
+    *stream = {};
+    if (instancePitch == 0) {
+        SDL_LogError(1, "Instance stream needs a non-zero instance pitch");
+        return false;
+    }
+    if (!CreateUniformArena(GPUDevice, &stream->arena, instancePitch * maxInstances, framesInFlight, SDL_GPU_BUFFERUSAGE_VERTEX)) {
+        return false;
+    }
+    stream->instancePitch = instancePitch;
+    return true;
+}
+
+void DestroyInstanceStream(SDL_GPUDevice* GPUDevice, InstanceStream* stream) {
+    DestroyUniformArena(GPUDevice, &stream->arena);
+    *stream = {};
+}
+
+void BeginInstanceFrame(InstanceStream* stream) {
+    BeginUniformFrame(&stream->arena);
+}
+
+void* StreamInstances(
+    SDL_GPUDevice* GPUDevice,
+    InstanceStream* stream,
+    UploadQueue* uploadQueue,
+    uint32_t count,
+    uint32_t* firstInstance
+) {
+    void* instances = UniformArenaAllocArray(GPUDevice, &stream->arena, uploadQueue, stream->instancePitch, count, firstInstance);
+    if (instances == NULL) {
+        SDL_LogError(1, "Instance stream is out of space for %u instances", count);
+    }
+    return instances;
+}
+
+void BindInstanceStream(SDL_GPURenderPass* renderPass, const InstanceStream* stream, uint32_t slot) {
+    SDL_GPUBufferBinding binding = {
+        .buffer = GetUniformArenaBuffer(&stream->arena),
+        .offset = 0,
+    };
+    SDL_BindGPUVertexBuffers(renderPass, slot, &binding, 1);
+}
@@ -1,11 +1,51 @@
+#include "../include/command_recorder.hpp"
 #include "../include/common.hpp"
+#include "../include/depth_buffer.hpp"
+#include "../include/dynamic_resolution.hpp"
+#include "../include/instancing.hpp"
+#include "../include/mesh_optimize.hpp"
+#include "../include/mesh_pool.hpp"
+#include "../include/pipeline_cache.hpp"
+#include "../include/pipeline_startup.hpp"
+#include "../include/render_graph.hpp"
+#include "../include/shader_variants.hpp"
+#include "../include/uniform_block.hpp"
+#include "../include/upload_queue.hpp"
 #include <SDL3/SDL_gpu.h>
 #include <SDL3/SDL_mouse.h>
 #include <SDL3/SDL_timer.h>
 
-static SDL_GPUGraphicsPipeline* pipeline;
-static SDL_GPUBuffer* vertexBuffer;
-static SDL_GPUBuffer* indexBuffer;
+static GraphicsPipelineVariants gradientPipelines;
+static uint16_t gradientVariant = ShaderOptionBit("solidColor.frag", "ANIMATED");
+static MeshPool meshPool;
+static MeshHandle quadMesh;
+static StagingRing stagingRing;
+static UploadQueue uploadQueue;
+static RenderGraph renderGraph;
+static RenderGraph sceneGraph;
+static CommandRecorder commandRecorder;
+// DEPTH_MODE_PRE_PASS needs depthOnly.frag, which is only built when dxc is available
+static DepthMode depthMode = DEPTH_MODE_TEST;
+static SDL_GPUTextureFormat depthFormat;
+static GraphicsPipelineVariants depthPrePassPipelines;
+
+// The scene is drawn into the top left of a swapchain sized target, as much of it as the
+// resolution scale allows, then stretched over the swapchain. The target keeps its size, so
+// the render graph's pooled texture is reused whatever the scale. sceneGraph is recorded on a
+// command recorder job; renderGraph, on the command buffer that acquired the swapchain, only
+// does the upscale.
+static DynamicResolution dynamicResolution;
+struct ScenePass {
+    // The target in sceneGraph, and the same texture imported into renderGraph
+    RenderResource scene;
+    RenderResource upscaleSource;
+    RenderResource output;
+    uint32_t width;
+    uint32_t height;
+    uint32_t outputWidth;
+    uint32_t outputHeight;
+};
+static ScenePass scenePass;
 
 static void Quit(Context* context);
 
@@ -22,48 +62,22 @@ static Context context = {
 typedef struct GradientUniforms
 {
     float time;
+    float padding[3];
 } GradientUniforms;
 
+// cbuffer TimeBuffer in solidColor.frag.hlsl
+CHECK_UNIFORM_BLOCK(GradientUniforms, "solidColor.frag", 0, UNIFORM_MEMBER(GradientUniforms, time));
+
 static GradientUniforms GradientUniformValues;
 
 int Init(Context* context) {
     int result = GeneralInit(context, 0);
     if (result < 0) return result;
 
-    SDL_GPUShader* vertexShader = LoadShader( context->GPUDevice, "position.vert", 0, 0, 0, 0);
-    if (vertexShader == NULL) {
-
-        SDL_Log("Failed to create vertex shader");
-        return -1;
-    }
-
-    SDL_GPUShader* fragmentShader = LoadShader( context->GPUDevice, "solidColor.frag", 0, 1, 0, 0);
-    if (fragmentShader == NULL) {
-        SDL_Log("Failed to create fragment shader");
-        return -1;
-    }
-
-    SDL_GPUVertexBufferDescription vertexBufferDescription[] = {{
-        .slot = 0,
-        .pitch = sizeof(PositionVertex),
-        .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-        .instance_step_rate = 0,
-    }};
-
-    SDL_GPUVertexAttribute vertexAttributes[] = {{
-        .location = 0,
-        .buffer_slot = 0,
-        .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-        .offset = 0
-    }};
-
-    SDL_GPUVertexInputState vertexInputState = {
-        .vertex_buffer_descriptions = vertexBufferDescription,
-        .num_vertex_buffers = 1,
-        .vertex_attributes = vertexAttributes,
-        .num_vertex_attributes = 1,
-    };
-
+    VertexLayout vertexLayout = {};
+    uint32_t vertexSlot = AddVertexBuffer(&vertexLayout, SDL_GPU_VERTEXINPUTRATE_VERTEX);
+    AddVertexAttribute(&vertexLayout, vertexSlot, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3);
+    SDL_assert(vertexLayout.buffers[vertexSlot].pitch == sizeof(PositionVertex));
 
     SDL_GPUColorTargetDescription colorTargetDescription[] = {{
         .format = SDL_GetGPUSwapchainTextureFormat(context->GPUDevice, context->window),
@@ -79,9 +93,7 @@ int Init(Context* context) {
     }};
 
     SDL_GPUGraphicsPipelineCreateInfo pipelineCreateInfo = {
-        .vertex_shader = vertexShader,
-        .fragment_shader = fragmentShader,
-        .vertex_input_state = vertexInputState,
+        .vertex_input_state = GetVertexInputState(&vertexLayout),
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
         .target_info = {
             .color_target_descriptions = colorTargetDescription,
@@ -89,104 +101,131 @@ int Init(Context* context) {
         },
     };
 
-    pipeline = SDL_CreateGPUGraphicsPipeline(context->GPUDevice, &pipelineCreateInfo);
-    if (pipeline == NULL) {
-        SDL_LogError(1, "Failed creating graphics pipeline error: %s", SDL_GetError());
-    }
+    depthFormat = ChooseDepthFormat(context->GPUDevice);
+    SDL_GPUGraphicsPipelineCreateInfo prePassCreateInfo = DepthPrePassCreateInfo(&pipelineCreateInfo, depthFormat);
+    SetPipelineDepth(&pipelineCreateInfo, depthFormat, depthMode);
 
-    SDL_ReleaseGPUShader(context->GPUDevice, vertexShader);
-    SDL_ReleaseGPUShader(context->GPUDevice, fragmentShader);
+    InitGraphicsPipelineVariants(&gradientPipelines, "position.vert", "solidColor.frag", &pipelineCreateInfo);
+    InitGraphicsPipelineVariants(&depthPrePassPipelines, "position.vert", "depthOnly.frag", &prePassCreateInfo);
 
-    SDL_GPUBufferCreateInfo vertexBufferCreateInfo = {
-        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
-        .size = sizeof(PositionVertex) * 4
+    // Everything the first frame needs is built up front on the startup workers,
+    // other variants are created when first drawn
+    PipelineJob pipelineJobs[] = {
+        GraphicsPipelineJob("gradient", &gradientPipelines, 0, gradientVariant),
+        GraphicsPipelineJob("depthPrePass", &depthPrePassPipelines, 0, 0),
     };
-    vertexBuffer = SDL_CreateGPUBuffer(
-        context->GPUDevice,
-        &vertexBufferCreateInfo
-    );
+    uint32_t pipelineJobCount = depthMode == DEPTH_MODE_PRE_PASS ? 2 : 1;
+    if (!BuildPipelines(context->GPUDevice, pipelineJobs, pipelineJobCount)) {
+        SDL_Log("Failed to create gradient pipeline");
+        return -1;
+    }
+    LogPipelineCacheStats();
+
+    // Only the scene is a job so far, the calling thread and one worker are plenty
+    if (!CreateCommandRecorder(context->GPUDevice, &commandRecorder, 2)) {
+        return -1;
+    }
+
+    if (!CreateStagingRing(context->GPUDevice, &stagingRing, 64 * 1024, STAGING_RING_MAX_FRAMES)) {
+        return -1;
+    }
+    InitUploadQueue(&uploadQueue, &stagingRing);
+    BeginUploadFrame(context->GPUDevice, &uploadQueue);
+
+    // Every PositionVertex mesh shares the pool's buffers, uploaded with the first frame
+    CreateMeshPool(&meshPool, sizeof(PositionVertex), 4 * 1024 * 1024, 1024 * 1024);
 
-    SDL_GPUBufferCreateInfo indexBufferCreateInfo = {
-            .usage = SDL_GPU_BUFFERUSAGE_INDEX,
-            .size = sizeof(uint16_t) * 6
+    PositionVertex quadVertices[] = {
+        { -0.5f, -0.5f, 0 },
+        {  0.5f, -0.5f, 0 },
+        {  0.5f,  0.5f, 0 },
+        { -0.5f,  0.5f, 0 },
     };
-    indexBuffer = SDL_CreateGPUBuffer(
-        context->GPUDevice,
-        &indexBufferCreateInfo
-    );
+    Uint32 quadIndices[] = { 0, 1, 2, 0, 2, 3 };
 
-    SDL_GPUTransferBufferCreateInfo transferBufferCreateInfo = {
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = (sizeof(PositionVertex) * 4) + (sizeof(uint16_t) * 6),
+    ImportedMesh quad;
+    MeshImportOptions importOptions = {
+        .optimizeOverdraw = true,
+        .overdrawThreshold = 1.05f,
     };
-    SDL_GPUTransferBuffer* transferBuffer = SDL_CreateGPUTransferBuffer(
+    if (!ImportMesh(
+        "quad",
+        quadVertices,
+        SDL_arraysize(quadVertices),
+        sizeof(PositionVertex),
+        quadIndices,
+        SDL_arraysize(quadIndices),
+        &importOptions,
+        &quad
+    )) {
+        return -1;
+    }
+    quadMesh = AddMesh(
         context->GPUDevice,
-        &transferBufferCreateInfo
+        &meshPool,
+        &uploadQueue,
+        quad.vertices.data(),
+        quad.vertexCount,
+        quad.indices.data(),
+        quad.indexCount,
+        quad.indexElementSize
     );
+    if (quadMesh == MESH_HANDLE_INVALID) {
+        return -1;
+    }
 
-    PositionVertex* transferData = static_cast<PositionVertex*>(SDL_MapGPUTransferBuffer(
-        context->GPUDevice,
-        transferBuffer,
-        false
-    ));
-
-    transferData[0] = (PositionVertex){ -0.5f, -0.5f, 0};
-    transferData[1] = (PositionVertex){  0.5f, -0.5f, 0};
-    transferData[2] = (PositionVertex){  0.5f,  0.5f, 0};
-    transferData[3] = (PositionVertex){ -0.5f,  0.5f, 0};
+    return 0;
+}
 
-    Uint16* indexData = (Uint16*) &transferData[4];
-    indexData[0] = 0;
-    indexData[1] = 1;
-    indexData[2] = 2;
-    indexData[3] = 0;
-    indexData[4] = 2;
-    indexData[5] = 3;
+static void SetSceneViewport(SDL_GPURenderPass* renderPass) {
+    SDL_GPUViewport viewport = {
+        .x = 0.0f,
+        .y = 0.0f,
+        .w = (float)scenePass.width,
+        .h = (float)scenePass.height,
+        .min_depth = 0.0f,
+        .max_depth = 1.0f,
+    };
+    SDL_SetGPUViewport(renderPass, &viewport);
+}
 
-    SDL_UnmapGPUTransferBuffer(context->GPUDevice, transferBuffer);
+static void DrawDepthPrePass(RenderGraphContext* graphContext, void*) {
+    SetSceneViewport(graphContext->renderPass);
+    SDL_BindGPUGraphicsPipeline(graphContext->renderPass, GetGraphicsPipelineVariant(context.GPUDevice, &depthPrePassPipelines, 0, 0));
+    BeginMeshPass(&meshPool);
+    DrawMesh(&meshPool, graphContext->renderPass, quadMesh, 1, 0);
+}
 
+static void DrawGradient(RenderGraphContext* graphContext, void*) {
+    SetSceneViewport(graphContext->renderPass);
+    SDL_BindGPUGraphicsPipeline(
+        graphContext->renderPass,
+        GetGraphicsPipelineVariant(context.GPUDevice, &gradientPipelines, 0, gradientVariant)
+    );
+    BeginMeshPass(&meshPool);
 
-    // Upload the transfer data to the vertex and index buffer
-    SDL_GPUCommandBuffer* uploadCmdBuf = SDL_AcquireGPUCommandBuffer(context->GPUDevice);
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(uploadCmdBuf);
+    //SDL_PushGPUFragmentUniformData(cmdbuf, 1, &context.mousPos, sizeof(context.mousPos));
+    //SDL_PushGPUFragmentUniformData(cmdbuf, 2, &context.windowSize, sizeof(context.windowSize));
+    PushFragmentUniformBlock(graphContext->commandBuffer, 0, GradientUniformValues);
+    SDL_Log("%f", GradientUniformValues.time);
 
-    SDL_GPUTransferBufferLocation transferVertexBufferLocation =  {
-        .transfer_buffer = transferBuffer,
-        .offset = 0
-    };
-    SDL_GPUBufferRegion vertexBufferRegion = {
-        .buffer = vertexBuffer,
-        .offset = 0,
-        .size = sizeof(PositionVertex) * 4
-    };
-    SDL_UploadToGPUBuffer(
-        copyPass,
-        &transferVertexBufferLocation,
-        &vertexBufferRegion,
-        false
-    );
+    DrawMesh(&meshPool, graphContext->renderPass, quadMesh, 1, 0);
+}
 
-    SDL_GPUTransferBufferLocation transferIndexBufferLocation = {
-        .transfer_buffer = transferBuffer,
-        .offset = sizeof(PositionVertex) * 4
-    };
-    SDL_GPUBufferRegion indexBufferRegion = {
-        .buffer = indexBuffer,
-        .offset = 0,
-        .size = sizeof(Uint16) * 6
-    };
-    SDL_UploadToGPUBuffer(
-        copyPass,
-        &transferIndexBufferLocation,
-        &indexBufferRegion,
-        false
+static void UpscaleScene(RenderGraphContext* graphContext, void*) {
+    UpscaleTexture(
+        graphContext->commandBuffer,
+        GetRenderGraphTexture(graphContext->graph, scenePass.upscaleSource),
+        scenePass.width,
+        scenePass.height,
+        GetRenderGraphTexture(graphContext->graph, scenePass.output),
+        scenePass.outputWidth,
+        scenePass.outputHeight
     );
+}
 
-    SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPUCommandBuffer(uploadCmdBuf);
-    SDL_ReleaseGPUTransferBuffer(context->GPUDevice, transferBuffer);
-
-    return 0;
+static void RecordScene(SDL_GPUCommandBuffer* commandBuffer, void*) {
+    ExecuteRenderGraph(&sceneGraph, commandBuffer);
 }
 
 int main() {
@@ -197,9 +236,20 @@ int main() {
     InitAssetLoader();
     Init(&context);
 
+    // 60 Hz, down to half the width and height
+    InitDynamicResolution(&dynamicResolution, 1000.0f / 60.0f, 0.5f, 1.0f);
+
     bool running = true;
     SDL_Event e;
+    Uint64 gpuBusyNS = 0;
     while (running) {
+        // A frame costs whichever of the CPU and the GPU took longer. On the CPU only the
+        // frame's own work is timed: acquiring the swapchain, submitting and waiting for the
+        // frame in flight are left out, under vsync they pad every frame to the refresh
+        // interval. The GPU side is the busy time the staging ring saw complete since the last
+        // rendered frame; it lags by the frames in flight, which the settle frames allow for.
+        Uint64 workStart = SDL_GetTicksNS();
+
         GradientUniformValues.time += 0.1f;
         SDL_GetMouseState(&context.mousPos.x, &context.mousPos.y);
 
@@ -210,6 +260,15 @@ int main() {
             }
         }
 
+        // The scene job reads the uploads, so they are submitted ahead of it
+        SDL_GPUCommandBuffer* uploadCmdbuf = SDL_AcquireGPUCommandBuffer(context.GPUDevice);
+        if (uploadCmdbuf == NULL) {
+            SDL_Log("AcquireGPUCommandBuffer failed: %s", SDL_GetError());
+            return -1;
+        }
+        FlushUploads(context.GPUDevice, &uploadQueue, uploadCmdbuf);
+        SubmitStagingFrame(context.GPUDevice, &stagingRing, uploadCmdbuf);
+
         SDL_GPUCommandBuffer* cmdbuf = SDL_AcquireGPUCommandBuffer(context.GPUDevice);
         if (cmdbuf == NULL) {
             SDL_Log("AcquireGPUCommandBuffer failed: %s", SDL_GetError());
@@ -217,43 +276,90 @@ int main() {
         }
 
         SDL_GPUTexture* swapchainTexture;
-        if (!SDL_AcquireGPUSwapchainTexture(cmdbuf, context.window, &swapchainTexture, NULL, NULL)) {
+        Uint32 swapchainWidth, swapchainHeight;
+        Uint64 acquireStart = SDL_GetTicksNS();
+        if (!SDL_AcquireGPUSwapchainTexture(cmdbuf, context.window, &swapchainTexture, &swapchainWidth, &swapchainHeight)) {
             SDL_Log("WaitAndAcquireGPUSwapchainTexture failed: %s", SDL_GetError());
             return -1;
         }
+        workStart += SDL_GetTicksNS() - acquireStart;
 
         if (swapchainTexture != NULL) {
-            SDL_GPUColorTargetInfo colorTargetInfo = { 0 };
-            colorTargetInfo.texture = swapchainTexture;
-            colorTargetInfo.clear_color = (SDL_FColor){ 0.0f, 0.0f, 0.0f, 1.0f };
-            colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
-            colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
-
-            SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(cmdbuf, &colorTargetInfo, 1, NULL);
-            SDL_GPUBufferBinding vertexBufferBinding = {
-                .buffer = vertexBuffer,
-                .offset = 0
-            };
-            SDL_BindGPUGraphicsPipeline(renderPass, pipeline);
-            SDL_BindGPUVertexBuffers(renderPass, 0, &vertexBufferBinding, 1);
-
-            SDL_GPUBufferBinding indexBufferBinding = {
-                .buffer = indexBuffer,
-                .offset = 0
-            };
-            SDL_BindGPUIndexBuffer(renderPass, &indexBufferBinding, SDL_GPU_INDEXELEMENTSIZE_16BIT);
-
-            //SDL_PushGPUFragmentUniformData(cmdbuf, 1, &context.mousPos, sizeof(context.mousPos));
-            //SDL_PushGPUFragmentUniformData(cmdbuf, 2, &context.windowSize, sizeof(context.windowSize));
-            SDL_PushGPUFragmentUniformData(cmdbuf, 0, &GradientUniformValues, sizeof(GradientUniformValues));
-            SDL_Log("%f", GradientUniformValues.time);
-
-            SDL_DrawGPUIndexedPrimitives(renderPass, 6, 1, 0, 0, 0);
-
-            SDL_EndGPURenderPass(renderPass);
+            SDL_GPUTextureFormat swapchainFormat = SDL_GetGPUSwapchainTextureFormat(context.GPUDevice, context.window);
+            BeginRenderGraph(&sceneGraph);
+            scenePass.outputWidth = swapchainWidth;
+            scenePass.outputHeight = swapchainHeight;
+            scenePass.scene = CreateRenderTexture(&sceneGraph, "scene", swapchainFormat, swapchainWidth, swapchainHeight);
+            MarkRenderGraphOutput(&sceneGraph, scenePass.scene);
+            GetScaledResolution(&dynamicResolution, swapchainWidth, swapchainHeight, &scenePass.width, &scenePass.height);
+
+            RenderResource depth = RENDER_RESOURCE_INVALID;
+            float clearDepth = REVERSED_Z_CLEAR_DEPTH;
+            if (depthMode != DEPTH_MODE_NONE) {
+                depth = CreateRenderTexture(&sceneGraph, "depth", depthFormat, swapchainWidth, swapchainHeight);
+            }
+            if (depthMode == DEPTH_MODE_PRE_PASS) {
+                uint32_t prePass = AddRenderGraphPass(&sceneGraph, "depthPrePass", RENDER_GRAPH_PASS_GRAPHICS, DrawDepthPrePass, NULL);
+                PassDepthTarget(&sceneGraph, prePass, depth, &clearDepth);
+            }
+
+            SDL_FColor clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+            uint32_t gradientPass = AddRenderGraphPass(&sceneGraph, "gradient", RENDER_GRAPH_PASS_GRAPHICS, DrawGradient, NULL);
+            PassColorTarget(&sceneGraph, gradientPass, scenePass.scene, &clearColor);
+            if (depthMode != DEPTH_MODE_NONE) {
+                PassDepthTarget(&sceneGraph, gradientPass, depth, depthMode == DEPTH_MODE_PRE_PASS ? NULL : &clearDepth);
+            }
+
+            // The job's command buffer is submitted inside RecordFrame, before cmdbuf
+            bool sceneRecorded = false;
+            if (CompileRenderGraph(context.GPUDevice, &sceneGraph)) {
+                BeginRecording(&commandRecorder);
+                AddRecordingJob(&commandRecorder, "scene", RecordScene, NULL);
+                sceneRecorded = RecordFrame(&commandRecorder);
+            }
+
+            BeginRenderGraph(&renderGraph);
+            scenePass.output = ImportRenderTexture(
+                &renderGraph,
+                "swapchain",
+                swapchainTexture,
+                swapchainFormat,
+                swapchainWidth,
+                swapchainHeight
+            );
+            MarkRenderGraphOutput(&renderGraph, scenePass.output);
+
+            if (sceneRecorded) {
+                scenePass.upscaleSource = ImportRenderTexture(
+                    &renderGraph,
+                    "scene",
+                    GetRenderGraphTexture(&sceneGraph, scenePass.scene),
+                    swapchainFormat,
+                    swapchainWidth,
+                    swapchainHeight
+                );
+                uint32_t upscalePass = AddRenderGraphPass(&renderGraph, "upscale", RENDER_GRAPH_PASS_COMMANDS, UpscaleScene, NULL);
+                PassRead(&renderGraph, upscalePass, scenePass.upscaleSource);
+                PassColorTarget(&renderGraph, upscalePass, scenePass.output, NULL);
+            }
+
+            if (CompileRenderGraph(context.GPUDevice, &renderGraph)) {
+                ExecuteRenderGraph(&renderGraph, cmdbuf);
+            }
         }
 
-        SDL_SubmitGPUCommandBuffer(cmdbuf);
+        Uint64 workNS = SDL_GetTicksNS() - workStart;
+        SubmitStagingFrame(context.GPUDevice, &stagingRing, cmdbuf);
+
+        // Uploads for the next frame go to the next staging region; this also keeps the CPU
+        // from getting more than STAGING_RING_MAX_FRAMES frames ahead of the GPU
+        BeginUploadFrame(context.GPUDevice, &uploadQueue);
+
+        if (swapchainTexture != NULL) {
+            Uint64 gpuFrameNS = stagingRing.stats.gpuBusyNS - gpuBusyNS;
+            gpuBusyNS = stagingRing.stats.gpuBusyNS;
+            UpdateDynamicResolution(&dynamicResolution, SDL_max(workNS, gpuFrameNS));
+        }
     }
 
     Quit(&context);
@@ -261,9 +367,13 @@ int main() {
 }
 
 void Quit(Context* context) {
-    SDL_ReleaseGPUGraphicsPipeline(context->GPUDevice, pipeline);
-    SDL_ReleaseGPUBuffer(context->GPUDevice, vertexBuffer);
-    SDL_ReleaseGPUBuffer(context->GPUDevice, indexBuffer);
+    ReleaseGraphicsPipelineVariants(context->GPUDevice, &gradientPipelines);
+    ReleaseGraphicsPipelineVariants(context->GPUDevice, &depthPrePassPipelines);
+    DestroyMeshPool(context->GPUDevice, &meshPool);
+    DestroyCommandRecorder(&commandRecorder);
+    DestroyRenderGraph(context->GPUDevice, &sceneGraph);
+    DestroyRenderGraph(context->GPUDevice, &renderGraph);
+    DestroyStagingRing(context->GPUDevice, &stagingRing);
 
     GeneralQuit(context);
 }
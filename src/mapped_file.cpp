@@ -0,0 +1,86 @@
+#include "../include/mapped_file.hpp"
+#include <SDL3/SDL.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+bool MapFile(const char* path, MappedFile* file) {
+    *file = {};
+    HANDLE fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        SDL_SetError("Couldn't open %s", path);
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+        SDL_SetError("Couldn't map empty file %s", path);
+        CloseHandle(fileHandle);
+        return false;
+    }
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* data = mappingHandle != NULL ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (data == NULL) {
+        SDL_SetError("Couldn't map %s", path);
+        if (mappingHandle != NULL) {
+            CloseHandle(mappingHandle);
+        }
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    file->data = static_cast<const uint8_t*>(data);
+    file->size = (size_t)size.QuadPart;
+    file->fileHandle = fileHandle;
+    file->mappingHandle = mappingHandle;
+    return true;
+}
+
+void UnmapFile(MappedFile* file) {
+    if (file->data != NULL) {
+        UnmapViewOfFile(file->data);
+        CloseHandle(file->mappingHandle);
+        CloseHandle(file->fileHandle);
+    }
+    *file = {};
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MapFile(const char* path, MappedFile* file) {
+    *file = {};
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0) {
+        SDL_SetError("Couldn't open %s", path);
+        return false;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+        SDL_SetError("Couldn't map empty file %s", path);
+        close(descriptor);
+        return false;
+    }
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // The mapping keeps the file alive on its own
+    close(descriptor);
+    if (data == MAP_FAILED) {
+        SDL_SetError("Couldn't map %s", path);
+        return false;
+    }
+    madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+    file->data = static_cast<const uint8_t*>(data);
+    file->size = (size_t)info.st_size;
+    return true;
+}
+
+void UnmapFile(MappedFile* file) {
+    if (file->data != NULL) {
+        munmap(const_cast<uint8_t*>(file->data), file->size);
+    }
+    *file = {};
+}
+#endif
@@ -0,0 +1,239 @@
+#include "../include/mesh_cache.hpp"
+#include "../include/mapped_file.hpp"
+#include <SDL3/SDL.h>
+#include <cstring>
+
+#define MESH_CACHE_MAGIC 0x4853454Du // "MESH"
+#define MESH_CACHE_ALIGNMENT 16
+
+struct MeshCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t vertexPitch;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize;
+    uint32_t meshletCount;
+    uint32_t reserved;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t meshletOffset;
+};
+static_assert(sizeof(MeshCacheHeader) % MESH_CACHE_ALIGNMENT == 0);
+
+static MeshCacheStats stats;
+
+static uint64_t Rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static uint64_t MixWord(uint64_t accumulator, uint64_t word) {
+    return Rotl(accumulator + word * 0xC2B2AE3D27D4EB4Full, 31) * 0x9E3779B185EBCA87ull;
+}
+
+// Four independent lanes over 32-byte blocks so the multiplies pipeline, then a byte tail
+static uint64_t HashContent(const uint8_t* data, size_t size) {
+    uint64_t lanes[4] = {
+        0x60EA27EEADC0B5D6ull,
+        0xC2B2AE3D27D4EB4Full,
+        0x0000000000000000ull,
+        0x61C8864E7A143579ull,
+    };
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            memcpy(&word, data + i + lane * 8, 8);
+            lanes[lane] = MixWord(lanes[lane], word);
+        }
+    }
+    uint64_t hash = Rotl(lanes[0], 1) + Rotl(lanes[1], 7) + Rotl(lanes[2], 12) + Rotl(lanes[3], 18);
+    hash ^= size;
+    for (; i < size; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001B3ull;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void GetCachePath(uint64_t key, char* path, size_t pathSize) {
+    SDL_snprintf(path, pathSize, "%scache/meshes/%016llx.mesh", SDL_GetBasePath(), (unsigned long long)key);
+}
+
+uint64_t MeshCacheKey(const uint8_t* source, size_t size, uint32_t vertexPitch, const MeshImportOptions* options) {
+    Uint64 start = SDL_GetTicksNS();
+    uint64_t key = HashContent(source, size);
+    uint32_t threshold = 0;
+    if (options != NULL && options->optimizeOverdraw) {
+        memcpy(&threshold, &options->overdrawThreshold, 4);
+        key = MixWord(key, 1);
+    }
+    key = MixWord(key, ((uint64_t)MESH_CACHE_VERSION << 32) | vertexPitch);
+    key = MixWord(key, threshold);
+    stats.hashNS += SDL_GetTicksNS() - start;
+    return key;
+}
+
+static bool ValidateHeader(const MeshCacheHeader* header, uint64_t key, size_t fileSize) {
+    if (header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION || header->key != key) {
+        return false;
+    }
+    if (header->indexSize != 2 && header->indexSize != 4) {
+        return false;
+    }
+    uint64_t vertexBytes = (uint64_t)header->vertexCount * header->vertexPitch;
+    uint64_t indexBytes = (uint64_t)header->indexCount * header->indexSize;
+    uint64_t meshletBytes = (uint64_t)header->meshletCount * sizeof(Meshlet);
+    return header->vertexOffset >= sizeof(MeshCacheHeader) &&
+           header->indexOffset >= header->vertexOffset + vertexBytes &&
+           header->meshletOffset >= header->indexOffset + indexBytes &&
+           header->meshletOffset + meshletBytes <= fileSize;
+}
+
+bool LoadCachedMesh(
+    SDL_GPUDevice* GPUDevice,
+    MeshPool* pool,
+    UploadQueue* uploadQueue,
+    uint64_t key,
+    MeshHandle* mesh,
+    std::vector<Meshlet>* meshlets
+) {
+    char path[512];
+    GetCachePath(key, path, sizeof(path));
+
+    Uint64 start = SDL_GetTicksNS();
+    MappedFile file;
+    if (!MapFile(path, &file)) {
+        stats.misses++;
+        return false;
+    }
+    MeshCacheHeader header;
+    if (file.size < sizeof(header)) {
+        UnmapFile(&file);
+        stats.misses++;
+        return false;
+    }
+    memcpy(&header, file.data, sizeof(header));
+    if (!ValidateHeader(&header, key, file.size) || header.vertexPitch != pool->vertexPitch) {
+        SDL_LogWarn(1, "Ignoring stale mesh cache entry %s", path);
+        UnmapFile(&file);
+        stats.misses++;
+        return false;
+    }
+
+    void* vertices;
+    void* indices;
+    *mesh = AllocateMesh(
+        GPUDevice,
+        pool,
+        uploadQueue,
+        header.vertexCount,
+        header.indexCount,
+        header.indexSize == 2 ? SDL_GPU_INDEXELEMENTSIZE_16BIT : SDL_GPU_INDEXELEMENTSIZE_32BIT,
+        &vertices,
+        &indices
+    );
+    if (*mesh != MESH_HANDLE_INVALID) {
+        size_t vertexBytes = (size_t)header.vertexCount * header.vertexPitch;
+        size_t indexBytes = (size_t)header.indexCount * header.indexSize;
+        SDL_memcpy(vertices, file.data + header.vertexOffset, vertexBytes);
+        SDL_memcpy(indices, file.data + header.indexOffset, indexBytes);
+        stats.bytesLoaded += vertexBytes + indexBytes;
+    }
+    if (meshlets != NULL) {
+        const Meshlet* first = reinterpret_cast<const Meshlet*>(file.data + header.meshletOffset);
+        meshlets->assign(first, first + header.meshletCount);
+    }
+    UnmapFile(&file);
+
+    stats.hits++;
+    stats.loadNS += SDL_GetTicksNS() - start;
+    return true;
+}
+
+bool WriteCachedMesh(
+    uint64_t key,
+    uint32_t vertexPitch,
+    const void* vertices,
+    uint32_t vertexCount,
+    const void* indices,
+    uint32_t indexCount,
+    SDL_GPUIndexElementSize indexElementSize,
+    const std::vector<Meshlet>* meshlets
+) {
+    char directory[512];
+    SDL_snprintf(directory, sizeof(directory), "%scache/meshes", SDL_GetBasePath());
+    if (!SDL_CreateDirectory(directory)) {
+        SDL_LogWarn(1, "Failed to create mesh cache directory %s error: %s", directory, SDL_GetError());
+        return false;
+    }
+
+    size_t vertexBytes = (size_t)vertexCount * vertexPitch;
+    MeshCacheHeader header = {
+        .magic = MESH_CACHE_MAGIC,
+        .version = MESH_CACHE_VERSION,
+        .key = key,
+        .vertexPitch = vertexPitch,
+        .vertexCount = vertexCount,
+        .indexCount = indexCount,
+        .indexSize = indexElementSize == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2u : 4u,
+        .meshletCount = (uint32_t)meshlets->size(),
+        .reserved = 0,
+        .vertexOffset = sizeof(MeshCacheHeader),
+        .indexOffset = AlignUp(sizeof(MeshCacheHeader) + vertexBytes, MESH_CACHE_ALIGNMENT),
+    };
+    size_t indexBytes = (size_t)indexCount * header.indexSize;
+    size_t meshletBytes = meshlets->size() * sizeof(Meshlet);
+    header.meshletOffset = AlignUp(header.indexOffset + indexBytes, MESH_CACHE_ALIGNMENT);
+    static const uint8_t padding[MESH_CACHE_ALIGNMENT] = {};
+    size_t vertexPadding = header.indexOffset - header.vertexOffset - vertexBytes;
+    size_t indexPadding = header.meshletOffset - header.indexOffset - indexBytes;
+
+    char path[512];
+    char temporaryPath[520];
+    GetCachePath(key, path, sizeof(path));
+    SDL_snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path);
+
+    SDL_IOStream* stream = SDL_IOFromFile(temporaryPath, "wb");
+    if (stream == NULL) {
+        SDL_LogWarn(1, "Failed to open %s for writing error: %s", temporaryPath, SDL_GetError());
+        return false;
+    }
+    bool written = SDL_WriteIO(stream, &header, sizeof(header)) == sizeof(header) &&
+                   SDL_WriteIO(stream, vertices, vertexBytes) == vertexBytes &&
+                   SDL_WriteIO(stream, padding, vertexPadding) == vertexPadding &&
+                   SDL_WriteIO(stream, indices, indexBytes) == indexBytes &&
+                   SDL_WriteIO(stream, padding, indexPadding) == indexPadding &&
+                   SDL_WriteIO(stream, meshlets->data(), meshletBytes) == meshletBytes;
+    written = SDL_CloseIO(stream) && written;
+    if (!written || !SDL_RenamePath(temporaryPath, path)) {
+        SDL_LogWarn(1, "Failed to write mesh cache entry %s error: %s", path, SDL_GetError());
+        SDL_RemovePath(temporaryPath);
+        return false;
+    }
+    stats.writes++;
+    return true;
+}
+
+const MeshCacheStats* GetMeshCacheStats() {
+    return &stats;
+}
+
+void LogMeshCacheStats() {
+    SDL_Log(
+        "Mesh cache: %u hits, %u misses, %u written, %.2f MB loaded in %.2f ms, %.2f ms hashing sources",
+        stats.hits,
+        stats.misses,
+        stats.writes,
+        (double)stats.bytesLoaded / (1024.0 * 1024.0),
+        (double)stats.loadNS / SDL_NS_PER_MS,
+        (double)stats.hashNS / SDL_NS_PER_MS
+    );
+}
@@ -0,0 +1,931 @@
+#include "../include/mesh_import.hpp"
+#include "../include/common.hpp"
+#include "../include/mapped_file.hpp"
+#include "../include/mesh_cache.hpp"
+#include <SDL3/SDL.h>
+#include <cstring>
+#include <string_view>
+
+#define GLB_MAGIC 0x46546C67u
+#define GLB_CHUNK_JSON 0x4E4F534Au
+#define GLB_CHUNK_BIN 0x004E4942u
+#define GLTF_MODE_TRIANGLES 4
+#define JSON_MAX_DEPTH 64
+// Doubles are exact for integers up to here, byte offsets and counts past it are rejected
+#define JSON_MAX_EXACT_INTEGER 9007199254740992.0
+
+static MeshParseStats parseStats[MESH_FILE_FORMAT_COUNT];
+
+uint32_t MeshVertexPitch(MeshVertexLayout layout) {
+    return layout == MESH_VERTEX_POSITION_TEXTURE ? sizeof(PositionTextureVertex) : sizeof(PositionColorVertex);
+}
+
+// Attributes of one source vertex, before they are written out in the requested layout
+struct SourceVertex {
+    float position[3];
+    float texcoord[2];
+    float color[4];
+};
+
+static void AppendVertex(std::vector<uint8_t>* vertices, MeshVertexLayout layout, const SourceVertex& source) {
+    size_t offset = vertices->size();
+    vertices->resize(offset + MeshVertexPitch(layout));
+    if (layout == MESH_VERTEX_POSITION_TEXTURE) {
+        PositionTextureVertex vertex = {
+            source.position[0], source.position[1], source.position[2],
+            source.texcoord[0], source.texcoord[1],
+        };
+        SDL_memcpy(vertices->data() + offset, &vertex, sizeof(vertex));
+    } else {
+        PositionColorVertex vertex = {
+            source.position[0], source.position[1], source.position[2],
+            source.color[0], source.color[1], source.color[2], source.color[3],
+        };
+        SDL_memcpy(vertices->data() + offset, &vertex, sizeof(vertex));
+    }
+}
+
+// Float parsing. Digits are consumed eight at a time with SWAR arithmetic on a 64-bit load;
+// mantissas up to 2^53 with a power of ten up to 22 convert exactly, anything else falls
+// back to SDL_strtod.
+
+static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static bool IsDigit(char c) {
+    return (unsigned char)(c - '0') < 10;
+}
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+static uint64_t LoadEightBytes(const char* p) {
+    uint64_t value;
+    SDL_memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static bool IsEightDigits(uint64_t value) {
+    return ((value & 0xF0F0F0F0F0F0F0F0ull) | (((value + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+           0x3333333333333333ull;
+}
+
+static uint32_t ParseEightDigits(uint64_t value) {
+    value = ((value & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+    value = ((value & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+    return (uint32_t)(((value & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32);
+}
+#endif
+
+// Appends digits to mantissa while it has room, counting the ones that did not fit in dropped.
+// Zeros before the first significant digit take no room and are counted in zeros instead.
+static const char* ParseDigits(const char* p, const char* end, uint64_t* mantissa, int* digits, int* dropped, int* zeros) {
+    if (*digits == 0) {
+        while (p < end && *p == '0') {
+            *zeros += 1;
+            p++;
+        }
+    }
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    while (end - p >= 8 && *digits <= 19 - 8 && IsEightDigits(LoadEightBytes(p))) {
+        *mantissa = *mantissa * 100000000ull + ParseEightDigits(LoadEightBytes(p));
+        *digits += 8;
+        p += 8;
+    }
+#endif
+    while (p < end && IsDigit(*p)) {
+        if (*digits < 19) {
+            *mantissa = *mantissa * 10 + (uint64_t)(*p - '0');
+            *digits += 1;
+        } else {
+            *dropped += 1;
+        }
+        p++;
+    }
+    return p;
+}
+
+static const char* ParseDouble(const char* p, const char* end, double* out) {
+    const char* start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int dropped = 0;
+    int zeros = 0;
+    p = ParseDigits(p, end, &mantissa, &digits, &dropped, &zeros);
+    // Integer digits that did not fit still scale the value
+    int exponent = dropped;
+
+    if (p < end && *p == '.') {
+        p++;
+        int integerDigits = digits;
+        int integerZeros = zeros;
+        dropped = 0;
+        p = ParseDigits(p, end, &mantissa, &digits, &dropped, &zeros);
+        // Leading zeros after the point are not significant but still scale the value
+        exponent -= digits - integerDigits + zeros - integerZeros;
+    }
+    if (digits == 0 && zeros == 0) {
+        return NULL;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* exponentStart = p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = *p == '-';
+            p++;
+        }
+        if (p < end && IsDigit(*p)) {
+            int value = 0;
+            while (p < end && IsDigit(*p)) {
+                value = SDL_min(value * 10 + (*p - '0'), 100000);
+                p++;
+            }
+            exponent += negativeExponent ? -value : value;
+        } else {
+            p = exponentStart;
+        }
+    }
+
+    double value;
+    if (mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22) {
+        value = (double)mantissa;
+        value = exponent < 0 ? value / powersOfTen[-exponent] : value * powersOfTen[exponent];
+    } else {
+        char text[128];
+        size_t length = SDL_min((size_t)(p - start), sizeof(text) - 1);
+        SDL_memcpy(text, start, length);
+        text[length] = '\0';
+        value = SDL_strtod(text, NULL);
+        negative = false;
+    }
+    *out = negative ? -value : value;
+    return p;
+}
+
+static const char* ParseFloat(const char* p, const char* end, float* out) {
+    double value;
+    p = ParseDouble(p, end, &value);
+    if (p != NULL) {
+        *out = (float)value;
+    }
+    return p;
+}
+
+static const char* ParseInt(const char* p, const char* end, int64_t* out) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p >= end || !IsDigit(*p)) {
+        return NULL;
+    }
+    int64_t value = 0;
+    while (p < end && IsDigit(*p)) {
+        value = SDL_min(value * 10 + (*p - '0'), (int64_t)INT32_MAX);
+        p++;
+    }
+    *out = negative ? -value : value;
+    return p;
+}
+
+static const char* SkipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+static const char* SkipLine(const char* p, const char* end) {
+    const void* newline = memchr(p, '\n', (size_t)(end - p));
+    return newline != NULL ? static_cast<const char*>(newline) + 1 : end;
+}
+
+// Open addressing map from a 64-bit key to the index of the welded vertex
+struct WeldTable {
+    std::vector<uint32_t> slots;
+    std::vector<uint64_t> keys;
+};
+
+static uint32_t SlotOf(uint64_t key, size_t slotCount) {
+    return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (uint32_t)(slotCount - 1);
+}
+
+static void GrowWeldTable(WeldTable* table) {
+    table->slots.assign(SDL_max(table->slots.size() * 2, (size_t)1024), 0xFFFFFFFFu);
+    for (uint32_t vertex = 0; vertex < table->keys.size(); ++vertex) {
+        uint32_t slot = SlotOf(table->keys[vertex], table->slots.size());
+        while (table->slots[slot] != 0xFFFFFFFFu) {
+            slot = (slot + 1) & (uint32_t)(table->slots.size() - 1);
+        }
+        table->slots[slot] = vertex;
+    }
+}
+
+// Returns the vertex for key, inserted tells whether it was just created
+static uint32_t WeldIndex(WeldTable* table, uint64_t key, bool* inserted) {
+    if ((table->keys.size() + 1) * 2 > table->slots.size()) {
+        GrowWeldTable(table);
+    }
+    uint32_t mask = (uint32_t)(table->slots.size() - 1);
+    uint32_t slot = SlotOf(key, table->slots.size());
+    while (table->slots[slot] != 0xFFFFFFFFu) {
+        if (table->keys[table->slots[slot]] == key) {
+            *inserted = false;
+            return table->slots[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    uint32_t vertex = (uint32_t)table->keys.size();
+    table->slots[slot] = vertex;
+    table->keys.push_back(key);
+    *inserted = true;
+    return vertex;
+}
+
+// OBJ: v (with optional vertex colors), vt and f with any of the index forms; polygons are fanned.
+// Corners are welded on their (position, texcoord) pair. Texture v is flipped to SDL's top-left origin.
+static bool ParseOBJ(
+    const char* text,
+    size_t size,
+    MeshVertexLayout layout,
+    std::vector<uint8_t>* vertices,
+    uint32_t* vertexCount,
+    std::vector<uint32_t>* indices,
+    uint64_t* sourceVertices
+) {
+    const char* p = text;
+    const char* end = text + size;
+    std::vector<float> positions;
+    std::vector<float> colors;
+    std::vector<float> texcoords;
+    WeldTable weld;
+    uint32_t polygon[3];
+    *sourceVertices = 0;
+
+    while (p < end) {
+        p = SkipSpaces(p, end);
+        if (end - p < 2) {
+            break;
+        }
+
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
+            float values[6] = { 0, 0, 0, 1, 1, 1 };
+            const char* q = p + 2;
+            int count = 0;
+            while (count < 6) {
+                q = SkipSpaces(q, end);
+                const char* next = ParseFloat(q, end, &values[count]);
+                if (next == NULL) {
+                    break;
+                }
+                q = next;
+                count++;
+            }
+            if (count < 3) {
+                SDL_SetError("Bad vertex position at byte %zu", (size_t)(p - text));
+                return false;
+            }
+            positions.insert(positions.end(), values, values + 3);
+            colors.insert(colors.end(), values + 3, values + 6);
+        } else if (p[0] == 'v' && p[1] == 't') {
+            float values[2] = { 0, 0 };
+            const char* q = p + 2;
+            for (int i = 0; i < 2; ++i) {
+                q = SkipSpaces(q, end);
+                const char* next = ParseFloat(q, end, &values[i]);
+                if (next == NULL) {
+                    break;
+                }
+                q = next;
+            }
+            texcoords.push_back(values[0]);
+            texcoords.push_back(1.0f - values[1]);
+        } else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
+            const char* q = p + 2;
+            int corner = 0;
+            while (true) {
+                q = SkipSpaces(q, end);
+                int64_t position;
+                const char* next = ParseInt(q, end, &position);
+                if (next == NULL) {
+                    break;
+                }
+                q = next;
+
+                int64_t texcoord = 0;
+                if (q < end && *q == '/') {
+                    q++;
+                    if (q < end && *q != '/') {
+                        next = ParseInt(q, end, &texcoord);
+                        q = next != NULL ? next : q;
+                    }
+                    if (q < end && *q == '/') {
+                        int64_t normal;
+                        q++;
+                        next = ParseInt(q, end, &normal);
+                        q = next != NULL ? next : q;
+                    }
+                }
+
+                int64_t positionCount = (int64_t)positions.size() / 3;
+                int64_t texcoordCount = (int64_t)texcoords.size() / 2;
+                position = position < 0 ? positionCount + position : position - 1;
+                texcoord = texcoord < 0 ? texcoordCount + texcoord : texcoord - 1;
+                if (position < 0 || position >= positionCount || texcoord >= texcoordCount || texcoord < -1) {
+                    SDL_SetError("Face index out of range at byte %zu", (size_t)(p - text));
+                    return false;
+                }
+                (*sourceVertices)++;
+
+                bool inserted;
+                uint64_t key = ((uint64_t)position << 32) | (uint32_t)(texcoord + 1);
+                uint32_t vertex = WeldIndex(&weld, key, &inserted);
+                if (inserted) {
+                    SourceVertex source = {
+                        .position = { positions[position * 3], positions[position * 3 + 1], positions[position * 3 + 2] },
+                        .texcoord = { 0, 0 },
+                        .color = { colors[position * 3], colors[position * 3 + 1], colors[position * 3 + 2], 1 },
+                    };
+                    if (texcoord >= 0) {
+                        source.texcoord[0] = texcoords[texcoord * 2];
+                        source.texcoord[1] = texcoords[texcoord * 2 + 1];
+                    }
+                    AppendVertex(vertices, layout, source);
+                }
+
+                if (corner < 2) {
+                    polygon[corner] = vertex;
+                } else {
+                    indices->push_back(polygon[0]);
+                    indices->push_back(polygon[1]);
+                    indices->push_back(vertex);
+                    polygon[1] = vertex;
+                }
+                corner++;
+            }
+        }
+        p = SkipLine(p, end);
+    }
+
+    *vertexCount = (uint32_t)weld.keys.size();
+    return true;
+}
+
+// Just enough JSON for the glTF header: strings are kept as raw views without unescaping
+enum JsonType {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT,
+};
+
+struct JsonValue {
+    JsonType type;
+    double number;
+    std::string_view string;
+    std::vector<std::string_view> keys;
+    std::vector<JsonValue> elements;
+};
+
+struct JsonParser {
+    const char* p;
+    const char* end;
+};
+
+static void JsonSkipSpaces(JsonParser* parser) {
+    while (parser->p < parser->end && (*parser->p == ' ' || *parser->p == '\t' || *parser->p == '\n' || *parser->p == '\r')) {
+        parser->p++;
+    }
+}
+
+static bool JsonParseString(JsonParser* parser, std::string_view* out) {
+    const char* start = ++parser->p;
+    while (parser->p < parser->end && *parser->p != '"') {
+        parser->p += *parser->p == '\\' ? 2 : 1;
+    }
+    if (parser->p >= parser->end) {
+        return false;
+    }
+    *out = std::string_view(start, (size_t)(parser->p - start));
+    parser->p++;
+    return true;
+}
+
+static bool JsonParseValue(JsonParser* parser, JsonValue* value, int depth) {
+    JsonSkipSpaces(parser);
+    if (parser->p >= parser->end || depth > JSON_MAX_DEPTH) {
+        return false;
+    }
+
+    char c = *parser->p;
+    if (c == '{' || c == '[') {
+        bool object = c == '{';
+        value->type = object ? JSON_OBJECT : JSON_ARRAY;
+        parser->p++;
+        JsonSkipSpaces(parser);
+        if (parser->p < parser->end && *parser->p == (object ? '}' : ']')) {
+            parser->p++;
+            return true;
+        }
+        while (true) {
+            if (object) {
+                JsonSkipSpaces(parser);
+                std::string_view key;
+                if (parser->p >= parser->end || *parser->p != '"' || !JsonParseString(parser, &key)) {
+                    return false;
+                }
+                JsonSkipSpaces(parser);
+                if (parser->p >= parser->end || *parser->p != ':') {
+                    return false;
+                }
+                parser->p++;
+                value->keys.push_back(key);
+            }
+            value->elements.emplace_back();
+            if (!JsonParseValue(parser, &value->elements.back(), depth + 1)) {
+                return false;
+            }
+            JsonSkipSpaces(parser);
+            if (parser->p < parser->end && *parser->p == ',') {
+                parser->p++;
+                continue;
+            }
+            if (parser->p < parser->end && *parser->p == (object ? '}' : ']')) {
+                parser->p++;
+                return true;
+            }
+            return false;
+        }
+    }
+    if (c == '"') {
+        value->type = JSON_STRING;
+        return JsonParseString(parser, &value->string);
+    }
+    if (c == 't' || c == 'f' || c == 'n') {
+        std::string_view rest(parser->p, (size_t)(parser->end - parser->p));
+        for (const char* literal : { "true", "false", "null" }) {
+            if (rest.starts_with(literal)) {
+                value->type = c == 'n' ? JSON_NULL : JSON_BOOL;
+                value->number = c == 't' ? 1.0 : 0.0;
+                parser->p += SDL_strlen(literal);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Doubles hold byte offsets and counts exactly up to 2^53
+    double number;
+    const char* next = ParseDouble(parser->p, parser->end, &number);
+    if (next == NULL) {
+        return false;
+    }
+    value->type = JSON_NUMBER;
+    value->number = number;
+    parser->p = next;
+    return true;
+}
+
+static const JsonValue* JsonMember(const JsonValue* object, std::string_view key) {
+    if (object == NULL || object->type != JSON_OBJECT) {
+        return NULL;
+    }
+    for (size_t i = 0; i < object->keys.size(); ++i) {
+        if (object->keys[i] == key) {
+            return &object->elements[i];
+        }
+    }
+    return NULL;
+}
+
+static const JsonValue* JsonElement(const JsonValue* array, int64_t index) {
+    if (array == NULL || array->type != JSON_ARRAY || index < 0 || (size_t)index >= array->elements.size()) {
+        return NULL;
+    }
+    return &array->elements[index];
+}
+
+static int64_t JsonInt(const JsonValue* object, std::string_view key, int64_t fallback) {
+    const JsonValue* member = JsonMember(object, key);
+    if (member == NULL || member->type != JSON_NUMBER || SDL_fabs(member->number) > JSON_MAX_EXACT_INTEGER) {
+        return fallback;
+    }
+    return (int64_t)member->number;
+}
+
+// A byte offset, length or count: false unless it is missing (0) or a whole number >= 0
+static bool JsonSize(const JsonValue* object, std::string_view key, size_t* out) {
+    const JsonValue* member = JsonMember(object, key);
+    *out = 0;
+    if (member == NULL) {
+        return true;
+    }
+    double number = member->type == JSON_NUMBER ? member->number : -1.0;
+    if (number < 0.0 || number > JSON_MAX_EXACT_INTEGER || number != SDL_floor(number)) {
+        return false;
+    }
+    *out = (size_t)number;
+    return true;
+}
+
+static int ComponentSize(int64_t componentType) {
+    switch (componentType) {
+    case 5120: case 5121: return 1;
+    case 5122: case 5123: return 2;
+    case 5125: case 5126: return 4;
+    default: return 0;
+    }
+}
+
+static int ComponentCount(std::string_view type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+}
+
+static float ReadComponent(const uint8_t* data, int64_t componentType, bool normalized) {
+    switch (componentType) {
+    case 5126: { float v; SDL_memcpy(&v, data, 4); return v; }
+    case 5125: { uint32_t v; SDL_memcpy(&v, data, 4); return (float)v; }
+    case 5123: { uint16_t v; SDL_memcpy(&v, data, 2); return normalized ? v / 65535.0f : (float)v; }
+    case 5122: { int16_t v; SDL_memcpy(&v, data, 2); return normalized ? SDL_max(v / 32767.0f, -1.0f) : (float)v; }
+    case 5121: return normalized ? data[0] / 255.0f : (float)data[0];
+    default: return normalized ? SDL_max((int8_t)data[0] / 127.0f, -1.0f) : (float)(int8_t)data[0];
+    }
+}
+
+// A resolved accessor: element i starts at data + i * stride
+struct GltfAccessor {
+    const uint8_t* data;
+    size_t stride;
+    size_t count;
+    int components;
+    int64_t componentType;
+    bool normalized;
+};
+
+static bool ResolveAccessor(const JsonValue* json, const uint8_t* bin, size_t binSize, int64_t index, GltfAccessor* accessor) {
+    const JsonValue* info = JsonElement(JsonMember(json, "accessors"), index);
+    const JsonValue* type = JsonMember(info, "type");
+    if (info == NULL || type == NULL || JsonMember(info, "sparse") != NULL) {
+        SDL_SetError("Accessor %lld is missing or sparse", (long long)index);
+        return false;
+    }
+    const JsonValue* view = JsonElement(JsonMember(json, "bufferViews"), JsonInt(info, "bufferView", -1));
+    if (view == NULL || JsonInt(view, "buffer", 0) != 0) {
+        SDL_SetError("Accessor %lld has no view into the GLB buffer", (long long)index);
+        return false;
+    }
+
+    size_t viewOffset, viewLength, offset;
+    accessor->componentType = JsonInt(info, "componentType", 0);
+    accessor->components = ComponentCount(type->string);
+    if (!JsonSize(info, "count", &accessor->count) || !JsonSize(view, "byteStride", &accessor->stride) ||
+        !JsonSize(view, "byteOffset", &viewOffset) || !JsonSize(view, "byteLength", &viewLength) ||
+        !JsonSize(info, "byteOffset", &offset)) {
+        SDL_SetError("Accessor %lld has a negative or fractional size", (long long)index);
+        return false;
+    }
+    const JsonValue* normalized = JsonMember(info, "normalized");
+    accessor->normalized = normalized != NULL && normalized->number != 0.0;
+
+    size_t elementSize = (size_t)ComponentSize(accessor->componentType) * accessor->components;
+    if (accessor->stride == 0) {
+        accessor->stride = elementSize;
+    }
+    // Written so no sum or product can wrap: the view fits the buffer, the accessor starts in
+    // the view, and the last element ends in it
+    if (elementSize == 0 || viewOffset > binSize || viewLength > binSize - viewOffset || offset > viewLength ||
+        (accessor->count > 0 && (elementSize > viewLength - offset ||
+                                 accessor->count - 1 > (viewLength - offset - elementSize) / accessor->stride))) {
+        SDL_SetError("Accessor %lld is out of bounds", (long long)index);
+        return false;
+    }
+    accessor->data = bin + viewOffset + offset;
+    return true;
+}
+
+static void ReadElement(const GltfAccessor* accessor, size_t index, float* out, int outComponents) {
+    const uint8_t* element = accessor->data + index * accessor->stride;
+    int size = ComponentSize(accessor->componentType);
+    for (int i = 0; i < SDL_min(accessor->components, outComponents); ++i) {
+        out[i] = ReadComponent(element + i * size, accessor->componentType, accessor->normalized);
+    }
+}
+
+static uint64_t HashVertex(const uint8_t* vertex, size_t size) {
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= vertex[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+// Merges bit-identical vertices, rewriting indices
+static void WeldVertices(std::vector<uint8_t>* vertices, uint32_t* vertexCount, uint32_t pitch, std::vector<uint32_t>* indices) {
+    size_t slotCount = 1024;
+    while (slotCount < (size_t)*vertexCount * 2) {
+        slotCount *= 2;
+    }
+    std::vector<uint32_t> slots(slotCount, 0xFFFFFFFFu);
+    std::vector<uint32_t> remap(*vertexCount);
+    uint8_t* data = vertices->data();
+    uint32_t welded = 0;
+
+    for (uint32_t vertex = 0; vertex < *vertexCount; ++vertex) {
+        const uint8_t* bytes = data + (size_t)vertex * pitch;
+        uint32_t slot = SlotOf(HashVertex(bytes, pitch), slotCount);
+        while (slots[slot] != 0xFFFFFFFFu && SDL_memcmp(data + (size_t)slots[slot] * pitch, bytes, pitch) != 0) {
+            slot = (slot + 1) & (uint32_t)(slotCount - 1);
+        }
+        if (slots[slot] == 0xFFFFFFFFu) {
+            SDL_memmove(data + (size_t)welded * pitch, bytes, pitch);
+            slots[slot] = welded++;
+        }
+        remap[vertex] = slots[slot];
+    }
+
+    for (uint32_t& index : *indices) {
+        index = remap[index];
+    }
+    *vertexCount = welded;
+    vertices->resize((size_t)welded * pitch);
+}
+
+// glTF binary: triangle primitives of every mesh with POSITION, TEXCOORD_0 and COLOR_0.
+// Node transforms are not applied, meshes stay in their own space.
+static bool ParseGLB(
+    const uint8_t* data,
+    size_t size,
+    MeshVertexLayout layout,
+    std::vector<uint8_t>* vertices,
+    uint32_t* vertexCount,
+    std::vector<uint32_t>* indices,
+    uint64_t* sourceVertices
+) {
+    uint32_t header[5];
+    if (size < sizeof(header)) {
+        SDL_SetError("GLB file is truncated");
+        return false;
+    }
+    SDL_memcpy(header, data, sizeof(header));
+    if (header[0] != GLB_MAGIC || header[1] != 2 || header[4] != GLB_CHUNK_JSON || 20 + (size_t)header[3] > size) {
+        SDL_SetError("Not a glTF 2.0 binary file");
+        return false;
+    }
+    const char* jsonText = reinterpret_cast<const char*>(data + 20);
+    size_t jsonSize = header[3];
+
+    const uint8_t* bin = NULL;
+    size_t binSize = 0;
+    size_t binHeader = 20 + ((jsonSize + 3) & ~(size_t)3);
+    if (binHeader + 8 <= size) {
+        uint32_t chunk[2];
+        SDL_memcpy(chunk, data + binHeader, sizeof(chunk));
+        if (chunk[1] == GLB_CHUNK_BIN && binHeader + 8 + chunk[0] <= size) {
+            bin = data + binHeader + 8;
+            binSize = chunk[0];
+        }
+    }
+
+    JsonValue json = {};
+    JsonParser parser = { jsonText, jsonText + jsonSize };
+    if (!JsonParseValue(&parser, &json, 0) || json.type != JSON_OBJECT) {
+        SDL_SetError("GLB JSON chunk is malformed");
+        return false;
+    }
+
+    const JsonValue* meshes = JsonMember(&json, "meshes");
+    size_t meshCount = meshes != NULL && meshes->type == JSON_ARRAY ? meshes->elements.size() : 0;
+    *vertexCount = 0;
+    *sourceVertices = 0;
+
+    for (size_t m = 0; m < meshCount; ++m) {
+        const JsonValue* primitives = JsonMember(&meshes->elements[m], "primitives");
+        size_t primitiveCount = primitives != NULL && primitives->type == JSON_ARRAY ? primitives->elements.size() : 0;
+        for (size_t p = 0; p < primitiveCount; ++p) {
+            const JsonValue* primitive = &primitives->elements[p];
+            if (JsonInt(primitive, "mode", GLTF_MODE_TRIANGLES) != GLTF_MODE_TRIANGLES) {
+                continue;
+            }
+            const JsonValue* attributes = JsonMember(primitive, "attributes");
+            GltfAccessor positions;
+            if (!ResolveAccessor(&json, bin, binSize, JsonInt(attributes, "POSITION", -1), &positions)) {
+                return false;
+            }
+            GltfAccessor texcoords = {};
+            GltfAccessor colors = {};
+            bool hasTexcoords = JsonMember(attributes, "TEXCOORD_0") != NULL;
+            bool hasColors = JsonMember(attributes, "COLOR_0") != NULL;
+            if ((hasTexcoords && !ResolveAccessor(&json, bin, binSize, JsonInt(attributes, "TEXCOORD_0", -1), &texcoords)) ||
+                (hasColors && !ResolveAccessor(&json, bin, binSize, JsonInt(attributes, "COLOR_0", -1), &colors))) {
+                return false;
+            }
+
+            uint32_t baseVertex = *vertexCount;
+            for (size_t v = 0; v < positions.count; ++v) {
+                SourceVertex source = {
+                    .position = { 0, 0, 0 },
+                    .texcoord = { 0, 0 },
+                    .color = { 1, 1, 1, 1 },
+                };
+                ReadElement(&positions, v, source.position, 3);
+                if (hasTexcoords && v < texcoords.count) {
+                    ReadElement(&texcoords, v, source.texcoord, 2);
+                }
+                if (hasColors && v < colors.count) {
+                    ReadElement(&colors, v, source.color, 4);
+                }
+                AppendVertex(vertices, layout, source);
+            }
+            *vertexCount += (uint32_t)positions.count;
+            *sourceVertices += positions.count;
+
+            if (JsonMember(primitive, "indices") != NULL) {
+                GltfAccessor primitiveIndices;
+                if (!ResolveAccessor(&json, bin, binSize, JsonInt(primitive, "indices", -1), &primitiveIndices)) {
+                    return false;
+                }
+                int componentSize = ComponentSize(primitiveIndices.componentType);
+                for (size_t i = 0; i < primitiveIndices.count; ++i) {
+                    uint32_t index = 0;
+                    SDL_memcpy(&index, primitiveIndices.data + i * primitiveIndices.stride, componentSize);
+                    if (index >= positions.count) {
+                        SDL_SetError("Primitive index %u out of range", index);
+                        return false;
+                    }
+                    indices->push_back(baseVertex + index);
+                }
+            } else {
+                for (uint32_t i = 0; i < positions.count; ++i) {
+                    indices->push_back(baseVertex + i);
+                }
+            }
+        }
+    }
+
+    WeldVertices(vertices, vertexCount, MeshVertexPitch(layout), indices);
+    return true;
+}
+
+static bool ParseMeshData(
+    const uint8_t* data,
+    size_t size,
+    MeshVertexLayout layout,
+    std::vector<uint8_t>* vertices,
+    uint32_t* vertexCount,
+    std::vector<uint32_t>* indices
+) {
+    Uint64 start = SDL_GetTicksNS();
+    uint32_t magic = 0;
+    if (size >= 4) {
+        SDL_memcpy(&magic, data, 4);
+    }
+    MeshFileFormat format = magic == GLB_MAGIC ? MESH_FILE_GLB : MESH_FILE_OBJ;
+
+    vertices->clear();
+    indices->clear();
+    uint64_t sourceVertices = 0;
+    bool result = format == MESH_FILE_GLB
+        ? ParseGLB(data, size, layout, vertices, vertexCount, indices, &sourceVertices)
+        : ParseOBJ(reinterpret_cast<const char*>(data), size, layout, vertices, vertexCount, indices, &sourceVertices);
+
+    if (result) {
+        MeshParseStats* stats = &parseStats[format];
+        stats->fileCount++;
+        stats->inputBytes += size;
+        stats->parseNS += SDL_GetTicksNS() - start;
+        stats->sourceVertices += sourceVertices;
+        stats->weldedVertices += *vertexCount;
+    }
+    return result;
+}
+
+bool ParseMeshFile(
+    const char* path,
+    MeshVertexLayout layout,
+    std::vector<uint8_t>* vertices,
+    uint32_t* vertexCount,
+    std::vector<uint32_t>* indices
+) {
+    MappedFile file;
+    if (!MapFile(path, &file)) {
+        return false;
+    }
+    bool result = ParseMeshData(file.data, file.size, layout, vertices, vertexCount, indices);
+    UnmapFile(&file);
+    return result;
+}
+
+MeshHandle LoadMesh(
+    SDL_GPUDevice* GPUDevice,
+    MeshPool* pool,
+    UploadQueue* uploadQueue,
+    const std::string& meshFileName,
+    MeshVertexLayout layout,
+    const MeshImportOptions* options,
+    std::vector<Meshlet>* meshlets
+) {
+    uint32_t pitch = MeshVertexPitch(layout);
+    if (pool->vertexPitch != pitch) {
+        SDL_LogError(1, "Mesh %s: pool pitch %u does not match layout pitch %u", meshFileName.c_str(), pool->vertexPitch, pitch);
+        return MESH_HANDLE_INVALID;
+    }
+
+    char fullPath[256];
+    SDL_snprintf(fullPath, sizeof(fullPath), "%sassets/%s", SDL_GetBasePath(), meshFileName.c_str());
+
+    MappedFile source;
+    if (!MapFile(fullPath, &source)) {
+        SDL_LogError(1, "Failed to load mesh %s error: %s", fullPath, SDL_GetError());
+        return MESH_HANDLE_INVALID;
+    }
+    uint64_t cacheKey = MeshCacheKey(source.data, source.size, pitch, options);
+    MeshHandle mesh;
+    if (LoadCachedMesh(GPUDevice, pool, uploadQueue, cacheKey, &mesh, meshlets)) {
+        UnmapFile(&source);
+        return mesh;
+    }
+
+    std::vector<uint8_t> vertices;
+    std::vector<uint32_t> indices;
+    uint32_t vertexCount;
+    bool parsed = ParseMeshData(source.data, source.size, layout, &vertices, &vertexCount, &indices);
+    UnmapFile(&source);
+    if (!parsed) {
+        SDL_LogError(1, "Failed to load mesh %s error: %s", fullPath, SDL_GetError());
+        return MESH_HANDLE_INVALID;
+    }
+
+    VertexCacheStats before, after;
+    if (!OptimizeMesh(meshFileName.c_str(), &vertices, &vertexCount, pitch, &indices, options, &before, &after)) {
+        return MESH_HANDLE_INVALID;
+    }
+
+    SDL_GPUIndexElementSize indexElementSize = ChooseIndexElementSize(vertexCount);
+    uint32_t indexCount = (uint32_t)indices.size();
+    std::vector<uint8_t> packedIndices((size_t)indexCount * (indexElementSize == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4));
+    PackIndices(indices.data(), indexCount, indexElementSize, packedIndices.data());
+    std::vector<Meshlet> builtMeshlets;
+    BuildMeshlets(indices.data(), indexCount, vertices.data(), vertexCount, pitch, &builtMeshlets);
+    // A failed write only costs the next launch a re-import
+    WriteCachedMesh(cacheKey, pitch, vertices.data(), vertexCount, packedIndices.data(), indexCount, indexElementSize, &builtMeshlets);
+    if (meshlets != NULL) {
+        *meshlets = std::move(builtMeshlets);
+    }
+
+    void* vertexStaging;
+    void* indexStaging;
+    mesh = AllocateMesh(GPUDevice, pool, uploadQueue, vertexCount, indexCount, indexElementSize, &vertexStaging, &indexStaging);
+    if (mesh == MESH_HANDLE_INVALID) {
+        return MESH_HANDLE_INVALID;
+    }
+    SDL_memcpy(vertexStaging, vertices.data(), vertices.size());
+    SDL_memcpy(indexStaging, packedIndices.data(), packedIndices.size());
+    return mesh;
+}
+
+const MeshParseStats* GetMeshParseStats(MeshFileFormat format) {
+    return &parseStats[format];
+}
+
+double MeshParseThroughputMBs(const MeshParseStats* stats) {
+    if (stats->parseNS == 0) {
+        return 0.0;
+    }
+    return ((double)stats->inputBytes / (1024.0 * 1024.0)) / ((double)stats->parseNS / SDL_NS_PER_SECOND);
+}
+
+void LogMeshParseStats() {
+    static const char* formatNames[MESH_FILE_FORMAT_COUNT] = { "OBJ", "GLB" };
+    for (int i = 0; i < MESH_FILE_FORMAT_COUNT; ++i) {
+        const MeshParseStats* stats = &parseStats[i];
+        if (stats->fileCount == 0) {
+            continue;
+        }
+        SDL_Log(
+            "%s: %u meshes, %.2f MB, %llu vertices welded to %llu, %.2f ms, %.1f MB/s",
+            formatNames[i],
+            stats->fileCount,
+            (double)stats->inputBytes / (1024.0 * 1024.0),
+            (unsigned long long)stats->sourceVertices,
+            (unsigned long long)stats->weldedVertices,
+            (double)stats->parseNS / SDL_NS_PER_MS,
+            MeshParseThroughputMBs(stats)
+        );
+    }
+}
@@ -0,0 +1,445 @@
+#include "../include/mesh_optimize.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+
+#define INDEX_NONE 0xFFFFFFFFu
+#define FORSYTH_CACHE_SIZE 32
+#define FORSYTH_MAX_VALENCE 32
+#define ANALYZE_CACHE_SIZE 16
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+    // A vertex is still cached when fewer than cacheSize misses happened since it was loaded
+    std::vector<uint32_t> loadedAt(vertexCount, 0);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    size_t misses = 0;
+    size_t referencedCount = 0;
+
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t vertex = indices[i];
+        if (time - loadedAt[vertex] > cacheSize) {
+            loadedAt[vertex] = time++;
+            misses++;
+        }
+        if (!referenced[vertex]) {
+            referenced[vertex] = 1;
+            referencedCount++;
+        }
+    }
+
+    VertexCacheStats stats = {};
+    if (indexCount >= 3) {
+        stats.ACMR = (float)misses / (float)(indexCount / 3);
+        stats.ATVR = (float)misses / (float)referencedCount;
+    }
+    return stats;
+}
+
+static float cacheScores[FORSYTH_CACHE_SIZE];
+static float valenceScores[FORSYTH_MAX_VALENCE + 1];
+
+static void InitForsythScores() {
+    static bool initialized = false;
+    if (initialized) {
+        return;
+    }
+    for (int position = 0; position < FORSYTH_CACHE_SIZE; ++position) {
+        // The last triangle's vertices get a fixed score so it isn't simply repeated
+        cacheScores[position] = position < 3
+            ? 0.75f
+            : SDL_powf(1.0f - (float)(position - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+    }
+    valenceScores[0] = 0.0f;
+    for (int valence = 1; valence <= FORSYTH_MAX_VALENCE; ++valence) {
+        // Vertices with few triangles left are boosted so they get finished off
+        valenceScores[valence] = 2.0f * SDL_powf((float)valence, -0.5f);
+    }
+    initialized = true;
+}
+
+static float VertexScore(int32_t cachePosition, uint32_t liveTriangles) {
+    if (liveTriangles == 0) {
+        return -1.0f;
+    }
+    float score = cachePosition >= 0 ? cacheScores[cachePosition] : 0.0f;
+    return score + valenceScores[SDL_min(liveTriangles, (uint32_t)FORSYTH_MAX_VALENCE)];
+}
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    InitForsythScores();
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // Triangles of each vertex, the first liveTriangles[v] of its range are not emitted yet
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        liveTriangles[indices[i]]++;
+    }
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveTriangles[vertex];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    std::vector<int32_t> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        vertexScores[vertex] = VertexScore(-1, liveTriangles[vertex]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    uint32_t best = INDEX_NONE;
+    float bestScore = -1.0f;
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+        const uint32_t* corners = &indices[triangle * 3];
+        triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+        if (triangleScores[triangle] > bestScore) {
+            bestScore = triangleScores[triangle];
+            best = (uint32_t)triangle;
+        }
+    }
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> output(triangleCount * 3);
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+    size_t cacheCount = 0;
+    size_t cursor = 0;
+
+    for (size_t written = 0; written < triangleCount; ++written) {
+        if (best == INDEX_NONE) {
+            // Nothing in the cache has triangles left, continue with the next unused one
+            while (emitted[cursor]) {
+                cursor++;
+            }
+            best = (uint32_t)cursor;
+        }
+
+        const uint32_t* corners = &indices[best * 3];
+        output[written * 3 + 0] = corners[0];
+        output[written * 3 + 1] = corners[1];
+        output[written * 3 + 2] = corners[2];
+        emitted[best] = 1;
+
+        size_t newCount = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t vertex = corners[corner];
+            uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+            uint32_t& live = liveTriangles[vertex];
+            for (uint32_t i = 0; i < live; ++i) {
+                if (triangles[i] == best) {
+                    triangles[i] = triangles[live - 1];
+                    live--;
+                    break;
+                }
+            }
+            if (std::find(newCache, newCache + newCount, vertex) == newCache + newCount) {
+                newCache[newCount++] = vertex;
+            }
+        }
+        for (size_t i = 0; i < cacheCount; ++i) {
+            if (std::find(newCache, newCache + newCount, cache[i]) == newCache + newCount) {
+                newCache[newCount++] = cache[i];
+            }
+        }
+
+        // Rescore everything that moved in or out of the cache, then pick the best triangle
+        // among those still touching the cache
+        for (size_t i = 0; i < newCount; ++i) {
+            uint32_t vertex = newCache[i];
+            cachePositions[vertex] = i < FORSYTH_CACHE_SIZE ? (int32_t)i : -1;
+            float score = VertexScore(cachePositions[vertex], liveTriangles[vertex]);
+            float delta = score - vertexScores[vertex];
+            vertexScores[vertex] = score;
+
+            const uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+            for (uint32_t j = 0; j < liveTriangles[vertex]; ++j) {
+                triangleScores[triangles[j]] += delta;
+            }
+        }
+
+        best = INDEX_NONE;
+        bestScore = -1.0f;
+        cacheCount = SDL_min(newCount, (size_t)FORSYTH_CACHE_SIZE);
+        for (size_t i = 0; i < cacheCount; ++i) {
+            uint32_t vertex = newCache[i];
+            const uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+            for (uint32_t j = 0; j < liveTriangles[vertex]; ++j) {
+                if (triangleScores[triangles[j]] > bestScore) {
+                    bestScore = triangleScores[triangles[j]];
+                    best = triangles[j];
+                }
+            }
+        }
+        SDL_memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+    }
+
+    SDL_memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+struct Float3 {
+    float x, y, z;
+};
+
+static Float3 LoadPosition(const uint8_t* vertices, size_t vertexPitch, uint32_t vertex) {
+    Float3 position;
+    SDL_memcpy(&position, vertices + vertex * vertexPitch, sizeof(position));
+    return position;
+}
+
+struct TriangleCluster {
+    uint32_t first;
+    uint32_t count;
+    float sortKey;
+};
+
+void OptimizeOverdraw(
+    uint32_t* indices,
+    size_t indexCount,
+    const void* vertices,
+    size_t vertexCount,
+    size_t vertexPitch,
+    float threshold
+) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // Per triangle cache misses of the current order
+    std::vector<uint8_t> misses(triangleCount);
+    std::vector<uint32_t> loadedAt(vertexCount, 0);
+    uint32_t time = ANALYZE_CACHE_SIZE + 1;
+    for (size_t triangle = 0; triangle < triangleCount; ++triangle) {
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t vertex = indices[triangle * 3 + corner];
+            if (time - loadedAt[vertex] > ANALYZE_CACHE_SIZE) {
+                loadedAt[vertex] = time++;
+                misses[triangle]++;
+            }
+        }
+    }
+
+    // A triangle missing all three vertices starts fresh, so cutting there costs nothing.
+    // Those hard clusters are split again once a cluster, simulated from an empty cache as it
+    // will be after reordering, gets within threshold of the hard cluster's ACMR.
+    std::vector<TriangleCluster> clusters;
+    size_t hardStart = 0;
+    while (hardStart < triangleCount) {
+        size_t hardEnd = hardStart + 1;
+        while (hardEnd < triangleCount && misses[hardEnd] != 3) {
+            hardEnd++;
+        }
+
+        size_t hardMisses = 0;
+        for (size_t triangle = hardStart; triangle < hardEnd; ++triangle) {
+            hardMisses += misses[triangle];
+        }
+        float hardACMR = (float)hardMisses / (float)(hardEnd - hardStart);
+
+        size_t softStart = hardStart;
+        size_t softMisses = 0;
+        time += ANALYZE_CACHE_SIZE + 1;
+        for (size_t triangle = hardStart; triangle < hardEnd; ++triangle) {
+            for (int corner = 0; corner < 3; ++corner) {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                if (time - loadedAt[vertex] > ANALYZE_CACHE_SIZE) {
+                    loadedAt[vertex] = time++;
+                    softMisses++;
+                }
+            }
+            size_t count = triangle + 1 - softStart;
+            if (triangle + 1 == hardEnd || (float)softMisses / (float)count <= hardACMR * threshold) {
+                clusters.push_back({ (uint32_t)softStart, (uint32_t)count, 0.0f });
+                softStart = triangle + 1;
+                softMisses = 0;
+                time += ANALYZE_CACHE_SIZE + 1;
+            }
+        }
+        hardStart = hardEnd;
+    }
+
+    // Clusters facing away from the mesh center are likely in front, so they go first
+    const uint8_t* vertexBytes = static_cast<const uint8_t*>(vertices);
+    std::vector<Float3> centroids(clusters.size());
+    std::vector<Float3> normals(clusters.size());
+    Float3 meshCentroid = {};
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Float3 centroid = {};
+        Float3 normal = {};
+        float area = 0.0f;
+        for (uint32_t triangle = clusters[c].first; triangle < clusters[c].first + clusters[c].count; ++triangle) {
+            Float3 a = LoadPosition(vertexBytes, vertexPitch, indices[triangle * 3 + 0]);
+            Float3 b = LoadPosition(vertexBytes, vertexPitch, indices[triangle * 3 + 1]);
+            Float3 p = LoadPosition(vertexBytes, vertexPitch, indices[triangle * 3 + 2]);
+            Float3 ab = { b.x - a.x, b.y - a.y, b.z - a.z };
+            Float3 ac = { p.x - a.x, p.y - a.y, p.z - a.z };
+            Float3 cross = { ab.y * ac.z - ab.z * ac.y, ab.z * ac.x - ab.x * ac.z, ab.x * ac.y - ab.y * ac.x };
+            float triangleArea = SDL_sqrtf(cross.x * cross.x + cross.y * cross.y + cross.z * cross.z);
+
+            centroid.x += (a.x + b.x + p.x) * triangleArea;
+            centroid.y += (a.y + b.y + p.y) * triangleArea;
+            centroid.z += (a.z + b.z + p.z) * triangleArea;
+            normal.x += cross.x;
+            normal.y += cross.y;
+            normal.z += cross.z;
+            area += triangleArea;
+        }
+
+        meshCentroid.x += centroid.x;
+        meshCentroid.y += centroid.y;
+        meshCentroid.z += centroid.z;
+        meshArea += area;
+
+        float scale = area > 0.0f ? 1.0f / (3.0f * area) : 0.0f;
+        centroids[c] = { centroid.x * scale, centroid.y * scale, centroid.z * scale };
+        float length = SDL_sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        float normalScale = length > 0.0f ? 1.0f / length : 0.0f;
+        normals[c] = { normal.x * normalScale, normal.y * normalScale, normal.z * normalScale };
+    }
+
+    float meshScale = meshArea > 0.0f ? 1.0f / (3.0f * meshArea) : 0.0f;
+    meshCentroid = { meshCentroid.x * meshScale, meshCentroid.y * meshScale, meshCentroid.z * meshScale };
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        clusters[c].sortKey = (centroids[c].x - meshCentroid.x) * normals[c].x +
+                              (centroids[c].y - meshCentroid.y) * normals[c].y +
+                              (centroids[c].z - meshCentroid.z) * normals[c].z;
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster& a, const TriangleCluster& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    for (const TriangleCluster& cluster : clusters) {
+        output.insert(output.end(), indices + cluster.first * 3, indices + (cluster.first + cluster.count) * 3);
+    }
+    SDL_memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+size_t OptimizeVertexFetch(
+    void* vertices,
+    size_t vertexCount,
+    size_t vertexPitch,
+    uint32_t* indices,
+    size_t indexCount
+) {
+    std::vector<uint32_t> remap(vertexCount, INDEX_NONE);
+    uint32_t nextVertex = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t& mapped = remap[indices[i]];
+        if (mapped == INDEX_NONE) {
+            mapped = nextVertex++;
+        }
+        indices[i] = mapped;
+    }
+
+    uint8_t* vertexBytes = static_cast<uint8_t*>(vertices);
+    std::vector<uint8_t> original(vertexBytes, vertexBytes + vertexCount * vertexPitch);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        if (remap[vertex] != INDEX_NONE) {
+            SDL_memcpy(vertexBytes + remap[vertex] * vertexPitch, &original[vertex * vertexPitch], vertexPitch);
+        }
+    }
+    return nextVertex;
+}
+
+SDL_GPUIndexElementSize ChooseIndexElementSize(size_t vertexCount) {
+    return vertexCount <= 0x10000 ? SDL_GPU_INDEXELEMENTSIZE_16BIT : SDL_GPU_INDEXELEMENTSIZE_32BIT;
+}
+
+void PackIndices(const uint32_t* indices, size_t indexCount, SDL_GPUIndexElementSize indexElementSize, void* destination) {
+    if (indexElementSize == SDL_GPU_INDEXELEMENTSIZE_16BIT) {
+        uint16_t* packed = static_cast<uint16_t*>(destination);
+        for (size_t i = 0; i < indexCount; ++i) {
+            packed[i] = (uint16_t)indices[i];
+        }
+    } else {
+        SDL_memcpy(destination, indices, indexCount * sizeof(uint32_t));
+    }
+}
+
+bool OptimizeMesh(
+    const char* name,
+    std::vector<uint8_t>* vertices,
+    uint32_t* vertexCount,
+    uint32_t vertexPitch,
+    std::vector<uint32_t>* indices,
+    const MeshImportOptions* options,
+    VertexCacheStats* before,
+    VertexCacheStats* after
+) {
+    size_t indexCount = indices->size();
+    if (indexCount % 3 != 0) {
+        SDL_LogError(1, "Mesh %s has %zu indices, not a triangle list", name, indexCount);
+        return false;
+    }
+    for (size_t i = 0; i < indexCount; ++i) {
+        if ((*indices)[i] >= *vertexCount) {
+            SDL_LogError(1, "Mesh %s index %zu references vertex %u of %u", name, i, (*indices)[i], *vertexCount);
+            return false;
+        }
+    }
+
+    Uint64 start = SDL_GetTicksNS();
+    *before = AnalyzeVertexCache(indices->data(), indexCount, *vertexCount, ANALYZE_CACHE_SIZE);
+
+    OptimizeVertexCache(indices->data(), indexCount, *vertexCount);
+    if (options != NULL && options->optimizeOverdraw) {
+        OptimizeOverdraw(indices->data(), indexCount, vertices->data(), *vertexCount, vertexPitch, options->overdrawThreshold);
+    }
+    *vertexCount = (uint32_t)OptimizeVertexFetch(vertices->data(), *vertexCount, vertexPitch, indices->data(), indexCount);
+    vertices->resize((size_t)*vertexCount * vertexPitch);
+
+    *after = AnalyzeVertexCache(indices->data(), indexCount, *vertexCount, ANALYZE_CACHE_SIZE);
+
+    SDL_Log(
+        "Mesh %s: %zu triangles, %u vertices, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %d-bit indices (%.2f ms)",
+        name,
+        indexCount / 3,
+        *vertexCount,
+        before->ACMR,
+        after->ACMR,
+        before->ATVR,
+        after->ATVR,
+        ChooseIndexElementSize(*vertexCount) == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 16 : 32,
+        (double)(SDL_GetTicksNS() - start) / SDL_NS_PER_MS
+    );
+    return true;
+}
+
+bool ImportMesh(
+    const char* name,
+    const void* vertices,
+    uint32_t vertexCount,
+    uint32_t vertexPitch,
+    const uint32_t* indices,
+    uint32_t indexCount,
+    const MeshImportOptions* options,
+    ImportedMesh* mesh
+) {
+    const uint8_t* vertexBytes = static_cast<const uint8_t*>(vertices);
+    mesh->vertices.assign(vertexBytes, vertexBytes + (size_t)vertexCount * vertexPitch);
+    mesh->vertexCount = vertexCount;
+    mesh->vertexPitch = vertexPitch;
+
+    std::vector<uint32_t> optimized(indices, indices + indexCount);
+    if (!OptimizeMesh(name, &mesh->vertices, &mesh->vertexCount, vertexPitch, &optimized, options, &mesh->before, &mesh->after)) {
+        return false;
+    }
+
+    mesh->indexCount = indexCount;
+    mesh->indexElementSize = ChooseIndexElementSize(mesh->vertexCount);
+    mesh->indices.resize((size_t)indexCount * (mesh->indexElementSize == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4));
+    PackIndices(optimized.data(), indexCount, mesh->indexElementSize, mesh->indices.data());
+    return true;
+}
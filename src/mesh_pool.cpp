@@ -0,0 +1,199 @@
+#include "../include/mesh_pool.hpp"
+#include <SDL3/SDL.h>
+
+static uint32_t IndexSize(SDL_GPUIndexElementSize indexElementSize) {
+    return indexElementSize == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4;
+}
+
+void CreateMeshPool(MeshPool* pool, uint32_t vertexPitch, uint32_t vertexPageSize, uint32_t indexPageSize) {
+    pool->vertexPitch = vertexPitch;
+    CreateBufferAllocator(&pool->vertexBuffers, SDL_GPU_BUFFERUSAGE_VERTEX, vertexPageSize);
+    CreateBufferAllocator(&pool->indexBuffers, SDL_GPU_BUFFERUSAGE_INDEX, indexPageSize);
+    pool->meshes.clear();
+    pool->freeHandles.clear();
+    pool->boundVertexBuffer = NULL;
+    pool->boundIndexBuffer = NULL;
+    pool->stats = {};
+}
+
+void DestroyMeshPool(SDL_GPUDevice* GPUDevice, MeshPool* pool) {
+    for (MeshHandle mesh = 0; mesh < pool->meshes.size(); ++mesh) {
+        RemoveMesh(pool, mesh);
+    }
+    DestroyBufferAllocator(GPUDevice, &pool->vertexBuffers);
+    DestroyBufferAllocator(GPUDevice, &pool->indexBuffers);
+    pool->meshes.clear();
+    pool->freeHandles.clear();
+}
+
+MeshHandle AllocateMesh(
+    SDL_GPUDevice* GPUDevice,
+    MeshPool* pool,
+    UploadQueue* uploadQueue,
+    uint32_t vertexCount,
+    uint32_t indexCount,
+    SDL_GPUIndexElementSize indexElementSize,
+    void** vertices,
+    void** indices
+) {
+    uint32_t pitch = pool->vertexPitch;
+    uint32_t indexSize = IndexSize(indexElementSize);
+    PooledMesh mesh = {
+        .indexCount = indexCount,
+        .vertexCount = vertexCount,
+        .indexElementSize = indexElementSize,
+        .live = true,
+    };
+
+    // Base vertex offsets count whole vertices, so the range is padded until it can
+    // start on a multiple of the pitch
+    if (!BufferAlloc(GPUDevice, &pool->vertexBuffers, vertexCount * pitch + pitch - 1, 16, &mesh.vertices)) {
+        return MESH_HANDLE_INVALID;
+    }
+    if (!BufferAlloc(GPUDevice, &pool->indexBuffers, indexCount * indexSize, indexSize, &mesh.indices)) {
+        BufferFree(&pool->vertexBuffers, &mesh.vertices);
+        return MESH_HANDLE_INVALID;
+    }
+    uint32_t firstVertex = (mesh.vertices.offset + pitch - 1) / pitch;
+    mesh.vertexOffset = (int32_t)firstVertex;
+    mesh.firstIndex = mesh.indices.offset / indexSize;
+
+    *vertices = QueueBufferWrite(GPUDevice, uploadQueue, mesh.vertices.buffer, firstVertex * pitch, vertexCount * pitch);
+    *indices = *vertices != NULL
+        ? QueueBufferWrite(GPUDevice, uploadQueue, mesh.indices.buffer, mesh.indices.offset, indexCount * indexSize)
+        : NULL;
+    if (*indices == NULL) {
+        BufferFree(&pool->vertexBuffers, &mesh.vertices);
+        BufferFree(&pool->indexBuffers, &mesh.indices);
+        return MESH_HANDLE_INVALID;
+    }
+
+    MeshHandle handle;
+    if (!pool->freeHandles.empty()) {
+        handle = pool->freeHandles.back();
+        pool->freeHandles.pop_back();
+        pool->meshes[handle] = mesh;
+    } else {
+        handle = (MeshHandle)pool->meshes.size();
+        pool->meshes.push_back(mesh);
+    }
+    pool->stats.meshCount++;
+    return handle;
+}
+
+MeshHandle AddMesh(
+    SDL_GPUDevice* GPUDevice,
+    MeshPool* pool,
+    UploadQueue* uploadQueue,
+    const void* vertices,
+    uint32_t vertexCount,
+    const void* indices,
+    uint32_t indexCount,
+    SDL_GPUIndexElementSize indexElementSize
+) {
+    void* vertexStaging;
+    void* indexStaging;
+    MeshHandle mesh = AllocateMesh(
+        GPUDevice,
+        pool,
+        uploadQueue,
+        vertexCount,
+        indexCount,
+        indexElementSize,
+        &vertexStaging,
+        &indexStaging
+    );
+    if (mesh == MESH_HANDLE_INVALID) {
+        return MESH_HANDLE_INVALID;
+    }
+    SDL_memcpy(vertexStaging, vertices, (size_t)vertexCount * pool->vertexPitch);
+    SDL_memcpy(indexStaging, indices, (size_t)indexCount * IndexSize(indexElementSize));
+    return mesh;
+}
+
+void RemoveMesh(MeshPool* pool, MeshHandle mesh) {
+    if (mesh >= pool->meshes.size() || !pool->meshes[mesh].live) {
+        return;
+    }
+    // Reuse is safe without waiting: a later upload into the range is recorded in a
+    // later command buffer, behind the draws that still read the old contents
+    PooledMesh& pooled = pool->meshes[mesh];
+    BufferFree(&pool->vertexBuffers, &pooled.vertices);
+    BufferFree(&pool->indexBuffers, &pooled.indices);
+    pooled.live = false;
+    pool->freeHandles.push_back(mesh);
+    pool->stats.meshCount--;
+}
+
+const PooledMesh* GetMesh(const MeshPool* pool, MeshHandle mesh) {
+    if (mesh >= pool->meshes.size() || !pool->meshes[mesh].live) {
+        return NULL;
+    }
+    return &pool->meshes[mesh];
+}
+
+void BeginMeshPass(MeshPool* pool) {
+    pool->boundVertexBuffer = NULL;
+    pool->boundIndexBuffer = NULL;
+    pool->stats.passDraws = 0;
+    pool->stats.passBufferBinds = 0;
+}
+
+void DrawMeshRange(
+    MeshPool* pool,
+    SDL_GPURenderPass* renderPass,
+    MeshHandle mesh,
+    uint32_t firstIndex,
+    uint32_t indexCount,
+    uint32_t instanceCount,
+    uint32_t firstInstance
+) {
+    const PooledMesh* pooled = GetMesh(pool, mesh);
+    if (pooled == NULL) {
+        SDL_LogWarn(1, "DrawMeshRange called with a mesh that is not in the pool");
+        return;
+    }
+    if (indexCount > pooled->indexCount || firstIndex > pooled->indexCount - indexCount) {
+        SDL_LogWarn(1, "DrawMeshRange: indices %u..%u are outside the mesh's %u", firstIndex, firstIndex + indexCount, pooled->indexCount);
+        return;
+    }
+
+    if (pooled->vertices.buffer != pool->boundVertexBuffer) {
+        SDL_GPUBufferBinding vertexBufferBinding = {
+            .buffer = pooled->vertices.buffer,
+            .offset = 0,
+        };
+        SDL_BindGPUVertexBuffers(renderPass, 0, &vertexBufferBinding, 1);
+        pool->boundVertexBuffer = pooled->vertices.buffer;
+        pool->stats.passBufferBinds++;
+    }
+    if (pooled->indices.buffer != pool->boundIndexBuffer || pooled->indexElementSize != pool->boundIndexElementSize) {
+        SDL_GPUBufferBinding indexBufferBinding = {
+            .buffer = pooled->indices.buffer,
+            .offset = 0,
+        };
+        SDL_BindGPUIndexBuffer(renderPass, &indexBufferBinding, pooled->indexElementSize);
+        pool->boundIndexBuffer = pooled->indices.buffer;
+        pool->boundIndexElementSize = pooled->indexElementSize;
+        pool->stats.passBufferBinds++;
+    }
+
+    SDL_DrawGPUIndexedPrimitives(
+        renderPass,
+        indexCount,
+        instanceCount,
+        pooled->firstIndex + firstIndex,
+        pooled->vertexOffset,
+        firstInstance
+    );
+    pool->stats.passDraws++;
+}
+
+void DrawMesh(MeshPool* pool, SDL_GPURenderPass* renderPass, MeshHandle mesh, uint32_t instanceCount, uint32_t firstInstance) {
+    const PooledMesh* pooled = GetMesh(pool, mesh);
+    if (pooled == NULL) {
+        SDL_LogWarn(1, "DrawMesh called with a mesh that is not in the pool");
+        return;
+    }
+    DrawMeshRange(pool, renderPass, mesh, 0, pooled->indexCount, instanceCount, firstInstance);
+}
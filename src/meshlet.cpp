@@ -0,0 +1,256 @@
+#include "../include/meshlet.hpp"
+#include <SDL3/SDL.h>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MESHLET_USE_SSE2 1
+#endif
+
+// Cones wider than this (the minimum dot between the axis and a triangle normal) are
+// practically never back facing as a whole, so they are stored disabled.
+#define MESHLET_CONE_MIN_DOT 0.1f
+
+struct Float3 {
+    float x, y, z;
+};
+
+static Float3 Sub(Float3 a, Float3 b) {
+    return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+static float Dot(Float3 a, Float3 b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static Float3 Cross(Float3 a, Float3 b) {
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static Float3 Position(const uint8_t* vertices, uint32_t pitch, uint32_t index) {
+    Float3 position;
+    memcpy(&position, vertices + (size_t)index * pitch, sizeof(position));
+    return position;
+}
+
+static void ComputeBounds(
+    const uint32_t* indices,
+    const uint8_t* vertices,
+    uint32_t pitch,
+    Meshlet* meshlet
+) {
+    const uint32_t* triangles = indices + meshlet->firstIndex;
+    uint32_t triangleCount = meshlet->indexCount / 3;
+
+    Float3 low = Position(vertices, pitch, triangles[0]);
+    Float3 high = low;
+    for (uint32_t i = 1; i < meshlet->indexCount; ++i) {
+        Float3 p = Position(vertices, pitch, triangles[i]);
+        low = { SDL_min(low.x, p.x), SDL_min(low.y, p.y), SDL_min(low.z, p.z) };
+        high = { SDL_max(high.x, p.x), SDL_max(high.y, p.y), SDL_max(high.z, p.z) };
+    }
+    Float3 center = { (low.x + high.x) * 0.5f, (low.y + high.y) * 0.5f, (low.z + high.z) * 0.5f };
+    float radiusSquared = 0.0f;
+    for (uint32_t i = 0; i < meshlet->indexCount; ++i) {
+        Float3 d = Sub(Position(vertices, pitch, triangles[i]), center);
+        radiusSquared = SDL_max(radiusSquared, Dot(d, d));
+    }
+    memcpy(meshlet->center, &center, sizeof(center));
+    meshlet->radius = SDL_sqrtf(radiusSquared);
+
+    // Normal cone: the axis is the average triangle normal, its spread the widest normal
+    std::vector<Float3> normals(triangleCount);
+    Float3 axis = { 0.0f, 0.0f, 0.0f };
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        Float3 p0 = Position(vertices, pitch, triangles[t * 3 + 0]);
+        Float3 p1 = Position(vertices, pitch, triangles[t * 3 + 1]);
+        Float3 p2 = Position(vertices, pitch, triangles[t * 3 + 2]);
+        Float3 n = Cross(Sub(p1, p0), Sub(p2, p0));
+        float length = SDL_sqrtf(Dot(n, n));
+        if (length > 0.0f) {
+            n = { n.x / length, n.y / length, n.z / length };
+        }
+        normals[t] = n;
+        axis = { axis.x + n.x, axis.y + n.y, axis.z + n.z };
+    }
+
+    memcpy(meshlet->coneApex, &center, sizeof(center));
+    memset(meshlet->coneAxis, 0, sizeof(meshlet->coneAxis));
+    meshlet->coneCutoff = 1.0f;
+
+    float axisLength = SDL_sqrtf(Dot(axis, axis));
+    if (axisLength == 0.0f) {
+        return;
+    }
+    axis = { axis.x / axisLength, axis.y / axisLength, axis.z / axisLength };
+    float minDot = 1.0f;
+    for (const Float3& n : normals) {
+        // Degenerate triangles have no facing
+        if (Dot(n, n) > 0.0f) {
+            minDot = SDL_min(minDot, Dot(axis, n));
+        }
+    }
+    if (minDot <= MESHLET_CONE_MIN_DOT) {
+        return;
+    }
+
+    // Pull the apex back along the axis until it lies behind every triangle's plane
+    float maxT = 0.0f;
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        const Float3& n = normals[t];
+        float facing = Dot(axis, n);
+        if (facing <= 0.0f) {
+            continue;
+        }
+        Float3 p0 = Position(vertices, pitch, triangles[t * 3]);
+        maxT = SDL_max(maxT, Dot(Sub(center, p0), n) / facing);
+    }
+    Float3 apex = { center.x - axis.x * maxT, center.y - axis.y * maxT, center.z - axis.z * maxT };
+    memcpy(meshlet->coneApex, &apex, sizeof(apex));
+    memcpy(meshlet->coneAxis, &axis, sizeof(axis));
+    meshlet->coneCutoff = SDL_sqrtf(1.0f - minDot * minDot);
+}
+
+void BuildMeshlets(
+    const uint32_t* indices,
+    size_t indexCount,
+    const void* vertices,
+    uint32_t vertexCount,
+    uint32_t vertexPitch,
+    std::vector<Meshlet>* meshlets
+) {
+    meshlets->clear();
+    const uint8_t* vertexBytes = static_cast<const uint8_t*>(vertices);
+    // Which meshlet last used each vertex, so unique vertices are counted without clearing
+    std::vector<uint32_t> lastMeshlet(vertexCount, UINT32_MAX);
+
+    Meshlet current = {};
+    uint32_t uniqueVertices = 0;
+    for (size_t i = 0; i + 3 <= indexCount; i += 3) {
+        uint32_t meshletIndex = (uint32_t)meshlets->size();
+        uint32_t newVertices = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t v = indices[i + corner];
+            bool repeated = (corner > 0 && indices[i] == v) || (corner > 1 && indices[i + 1] == v);
+            newVertices += lastMeshlet[v] != meshletIndex && !repeated;
+        }
+        if (uniqueVertices + newVertices > MESHLET_MAX_VERTICES || current.indexCount / 3 == MESHLET_MAX_TRIANGLES) {
+            ComputeBounds(indices, vertexBytes, vertexPitch, &current);
+            meshlets->push_back(current);
+            current = { .firstIndex = (uint32_t)i };
+            uniqueVertices = 0;
+            meshletIndex++;
+        }
+        for (int corner = 0; corner < 3; ++corner) {
+            uint32_t v = indices[i + corner];
+            if (lastMeshlet[v] != meshletIndex) {
+                lastMeshlet[v] = meshletIndex;
+                uniqueVertices++;
+            }
+        }
+        current.indexCount += 3;
+    }
+    if (current.indexCount > 0) {
+        ComputeBounds(indices, vertexBytes, vertexPitch, &current);
+        meshlets->push_back(current);
+    }
+}
+
+// Gribb-Hartmann: with row vectors, clip = position * M, so the planes come from M's columns
+void ExtractFrustumPlanes(const Matrix4x4* m, float planes[8][4]) {
+    const float column1[4] = { m->m11, m->m21, m->m31, m->m41 };
+    const float column2[4] = { m->m12, m->m22, m->m32, m->m42 };
+    const float column3[4] = { m->m13, m->m23, m->m33, m->m43 };
+    const float column4[4] = { m->m14, m->m24, m->m34, m->m44 };
+    for (int i = 0; i < 4; ++i) {
+        planes[0][i] = column4[i] + column1[i]; // left
+        planes[1][i] = column4[i] - column1[i]; // right
+        planes[2][i] = column4[i] + column2[i]; // bottom
+        planes[3][i] = column4[i] - column2[i]; // top
+        planes[4][i] = column3[i];              // near, depth >= 0 (far with reversed-Z)
+        planes[5][i] = column4[i] - column3[i]; // far (near with reversed-Z)
+        planes[6][i] = i == 3 ? 1.0f : 0.0f;
+        planes[7][i] = i == 3 ? 1.0f : 0.0f;
+    }
+    for (int p = 0; p < 6; ++p) {
+        float length = SDL_sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        if (length > 0.0f) {
+            for (int i = 0; i < 4; ++i) {
+                planes[p][i] /= length;
+            }
+        }
+    }
+}
+
+uint32_t CullMeshlets(
+    const Meshlet* meshlets,
+    uint32_t meshletCount,
+    const MeshletCullParams* params,
+    MeshletRange* ranges,
+    MeshletCullStats* stats
+) {
+    float planes[8][4];
+    ExtractFrustumPlanes(&params->modelViewProjection, planes);
+    Float3 camera = { params->cameraPosition.x, params->cameraPosition.y, params->cameraPosition.z };
+
+#ifdef MESHLET_USE_SSE2
+    // Structure of arrays: one register per plane component, four planes per group
+    __m128 planeX[2], planeY[2], planeZ[2], planeW[2];
+    for (int group = 0; group < 2; ++group) {
+        const float (*p)[4] = &planes[group * 4];
+        planeX[group] = _mm_setr_ps(p[0][0], p[1][0], p[2][0], p[3][0]);
+        planeY[group] = _mm_setr_ps(p[0][1], p[1][1], p[2][1], p[3][1]);
+        planeZ[group] = _mm_setr_ps(p[0][2], p[1][2], p[2][2], p[3][2]);
+        planeW[group] = _mm_setr_ps(p[0][3], p[1][3], p[2][3], p[3][3]);
+    }
+#endif
+
+    uint32_t rangeCount = 0;
+    for (uint32_t i = 0; i < meshletCount; ++i) {
+        const Meshlet* meshlet = &meshlets[i];
+
+        bool outside = false;
+#ifdef MESHLET_USE_SSE2
+        __m128 x = _mm_set1_ps(meshlet->center[0]);
+        __m128 y = _mm_set1_ps(meshlet->center[1]);
+        __m128 z = _mm_set1_ps(meshlet->center[2]);
+        __m128 negativeRadius = _mm_set1_ps(-meshlet->radius);
+        for (int group = 0; group < 2; ++group) {
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(planeX[group], x), _mm_mul_ps(planeY[group], y)),
+                _mm_add_ps(_mm_mul_ps(planeZ[group], z), planeW[group])
+            );
+            outside |= _mm_movemask_ps(_mm_cmplt_ps(distance, negativeRadius)) != 0;
+        }
+#else
+        for (int p = 0; p < 6; ++p) {
+            float distance = planes[p][0] * meshlet->center[0] + planes[p][1] * meshlet->center[1] +
+                             planes[p][2] * meshlet->center[2] + planes[p][3];
+            outside |= distance < -meshlet->radius;
+        }
+#endif
+        if (outside) {
+            stats->frustumCulled++;
+            continue;
+        }
+
+        Float3 apex = { meshlet->coneApex[0], meshlet->coneApex[1], meshlet->coneApex[2] };
+        Float3 axis = { meshlet->coneAxis[0], meshlet->coneAxis[1], meshlet->coneAxis[2] };
+        Float3 view = Sub(apex, camera);
+        float viewLength = SDL_sqrtf(Dot(view, view));
+        if (Dot(view, axis) > meshlet->coneCutoff * viewLength) {
+            stats->coneCulled++;
+            continue;
+        }
+
+        if (rangeCount > 0 && ranges[rangeCount - 1].firstIndex + ranges[rangeCount - 1].indexCount == meshlet->firstIndex) {
+            ranges[rangeCount - 1].indexCount += meshlet->indexCount;
+        } else {
+            ranges[rangeCount++] = { meshlet->firstIndex, meshlet->indexCount };
+        }
+    }
+
+    stats->tested += meshletCount;
+    stats->ranges += rangeCount;
+    return rangeCount;
+}
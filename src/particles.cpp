@@ -0,0 +1,679 @@
+#include "../include/particles.hpp"
+#include "../include/pipeline_cache.hpp"
+#include "../include/shader_cache.hpp"
+#include "../include/uniform_block.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLES_USE_SSE2 1
+#endif
+
+// Written by particleArgs.comp, read by the simulate dispatch and the draw
+struct ParticleArgs {
+    SDL_GPUIndirectDispatchCommand simulate;
+    uint32_t padding;
+    SDL_GPUIndirectDrawCommand draw;
+};
+
+struct EmitUniforms {
+    float position[3];
+    float radius;
+    float velocity[3];
+    float velocitySpread;
+    float minLifetime;
+    float maxLifetime;
+    uint32_t firstSpawn;
+    uint32_t emitCount;
+    uint32_t countOffset;
+    uint32_t capacity;
+    uint32_t padding[2];
+};
+
+struct SimulateUniforms {
+    float gravity[3];
+    float drag;
+    float deltaTime;
+    uint32_t sourceCountOffset;
+    uint32_t targetCountOffset;
+    uint32_t capacity;
+};
+
+struct ArgsUniforms {
+    uint32_t sourceCountOffset;
+    uint32_t targetCountOffset;
+    uint32_t capacity;
+    uint32_t padding;
+};
+
+struct ParticleUniforms {
+    Matrix4x4 viewProjection;
+    float cameraRight[3];
+    float size;
+    float cameraUp[3];
+    float padding;
+    float startColor[4];
+    float endColor[4];
+};
+
+static_assert(sizeof(Particle) == 32);
+static_assert(offsetof(ParticleArgs, simulate) == 0 && offsetof(ParticleArgs, draw) == 16);
+
+CHECK_UNIFORM_BLOCK_IF_BUILT(
+    EmitUniforms,
+    "particleEmit.comp",
+    0,
+    UNIFORM_MEMBER(EmitUniforms, position),
+    UNIFORM_MEMBER(EmitUniforms, radius),
+    UNIFORM_MEMBER(EmitUniforms, velocity),
+    UNIFORM_MEMBER(EmitUniforms, velocitySpread),
+    UNIFORM_MEMBER(EmitUniforms, minLifetime),
+    UNIFORM_MEMBER(EmitUniforms, maxLifetime),
+    UNIFORM_MEMBER(EmitUniforms, firstSpawn),
+    UNIFORM_MEMBER(EmitUniforms, emitCount),
+    UNIFORM_MEMBER(EmitUniforms, countOffset),
+    UNIFORM_MEMBER(EmitUniforms, capacity)
+);
+CHECK_UNIFORM_BLOCK_IF_BUILT(
+    SimulateUniforms,
+    "particleSimulate.comp",
+    0,
+    UNIFORM_MEMBER(SimulateUniforms, gravity),
+    UNIFORM_MEMBER(SimulateUniforms, drag),
+    UNIFORM_MEMBER(SimulateUniforms, deltaTime),
+    UNIFORM_MEMBER(SimulateUniforms, sourceCountOffset),
+    UNIFORM_MEMBER(SimulateUniforms, targetCountOffset),
+    UNIFORM_MEMBER(SimulateUniforms, capacity)
+);
+CHECK_UNIFORM_BLOCK_IF_BUILT(
+    ArgsUniforms,
+    "particleArgs.comp",
+    0,
+    UNIFORM_MEMBER(ArgsUniforms, sourceCountOffset),
+    UNIFORM_MEMBER(ArgsUniforms, targetCountOffset),
+    UNIFORM_MEMBER(ArgsUniforms, capacity)
+);
+CHECK_UNIFORM_BLOCK_IF_BUILT(
+    ParticleUniforms,
+    "particle.vert",
+    0,
+    UNIFORM_MEMBER(ParticleUniforms, viewProjection),
+    UNIFORM_MEMBER(ParticleUniforms, cameraRight),
+    UNIFORM_MEMBER(ParticleUniforms, size),
+    UNIFORM_MEMBER(ParticleUniforms, cameraUp),
+    UNIFORM_MEMBER(ParticleUniforms, startColor),
+    UNIFORM_MEMBER(ParticleUniforms, endColor)
+);
+
+// HashSpawn and NextRandom in particle.hlsli
+static uint32_t HashSpawn(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static float NextRandom(uint32_t* state) {
+    *state = HashSpawn(*state);
+    return (float)(*state >> 8) * (1.0f / 16777216.0f);
+}
+
+bool CreateParticleSimulationCPU(ParticleSimulationCPU* simulation, uint32_t capacity) {
+    *simulation = {};
+    size_t stride = ((size_t)capacity + 3) & ~(size_t)3;
+    float* arrays = static_cast<float*>(SDL_aligned_alloc(16, stride * 8 * sizeof(float)));
+    if (arrays == NULL) {
+        SDL_LogError(1, "Failed to allocate CPU particles for %u particles", capacity);
+        return false;
+    }
+
+    simulation->capacity = capacity;
+    simulation->positionX = arrays;
+    simulation->positionY = arrays + stride;
+    simulation->positionZ = arrays + stride * 2;
+    simulation->velocityX = arrays + stride * 3;
+    simulation->velocityY = arrays + stride * 4;
+    simulation->velocityZ = arrays + stride * 5;
+    simulation->age = arrays + stride * 6;
+    simulation->lifetime = arrays + stride * 7;
+    return true;
+}
+
+void DestroyParticleSimulationCPU(ParticleSimulationCPU* simulation) {
+    if (simulation->positionX != NULL) {
+        SDL_aligned_free(simulation->positionX);
+    }
+    *simulation = {};
+}
+
+void SimulateParticlesCPU(ParticleSimulationCPU* simulation, const ParticleSimulationParams* params, float deltaTime) {
+    // Same operations in the same order as particleSimulate.comp
+    float gravityX = params->gravity[0] * deltaTime;
+    float gravityY = params->gravity[1] * deltaTime;
+    float gravityZ = params->gravity[2] * deltaTime;
+    float damping = SDL_max(0.0f, 1.0f - params->drag * deltaTime);
+
+    float* px = simulation->positionX;
+    float* py = simulation->positionY;
+    float* pz = simulation->positionZ;
+    float* vx = simulation->velocityX;
+    float* vy = simulation->velocityY;
+    float* vz = simulation->velocityZ;
+    float* age = simulation->age;
+    float* lifetime = simulation->lifetime;
+
+    uint32_t count = simulation->count;
+    uint32_t write = 0;
+    uint32_t i = 0;
+#ifdef PARTICLES_USE_SSE2
+    __m128 gx = _mm_set1_ps(gravityX);
+    __m128 gy = _mm_set1_ps(gravityY);
+    __m128 gz = _mm_set1_ps(gravityZ);
+    __m128 damp = _mm_set1_ps(damping);
+    __m128 dt = _mm_set1_ps(deltaTime);
+    for (; i + 4 <= count; i += 4) {
+        __m128 velocityX = _mm_mul_ps(_mm_add_ps(_mm_load_ps(vx + i), gx), damp);
+        __m128 velocityY = _mm_mul_ps(_mm_add_ps(_mm_load_ps(vy + i), gy), damp);
+        __m128 velocityZ = _mm_mul_ps(_mm_add_ps(_mm_load_ps(vz + i), gz), damp);
+        __m128 positionX = _mm_add_ps(_mm_load_ps(px + i), _mm_mul_ps(velocityX, dt));
+        __m128 positionY = _mm_add_ps(_mm_load_ps(py + i), _mm_mul_ps(velocityY, dt));
+        __m128 positionZ = _mm_add_ps(_mm_load_ps(pz + i), _mm_mul_ps(velocityZ, dt));
+        __m128 ages = _mm_add_ps(_mm_load_ps(age + i), dt);
+        __m128 lifetimes = _mm_load_ps(lifetime + i);
+        int alive = _mm_movemask_ps(_mm_cmplt_ps(ages, lifetimes));
+
+        if (alive == 0xF && write == i) {
+            // Nothing died so far, the group stays where it is
+            _mm_store_ps(vx + i, velocityX);
+            _mm_store_ps(vy + i, velocityY);
+            _mm_store_ps(vz + i, velocityZ);
+            _mm_store_ps(px + i, positionX);
+            _mm_store_ps(py + i, positionY);
+            _mm_store_ps(pz + i, positionZ);
+            _mm_store_ps(age + i, ages);
+            write += 4;
+            continue;
+        }
+
+        // Every lane is stored and the write position only advances past living ones, which
+        // stays branch free when deaths are scattered. Writes never pass the group being read.
+        alignas(16) float lanes[8][4];
+        _mm_store_ps(lanes[0], positionX);
+        _mm_store_ps(lanes[1], positionY);
+        _mm_store_ps(lanes[2], positionZ);
+        _mm_store_ps(lanes[3], velocityX);
+        _mm_store_ps(lanes[4], velocityY);
+        _mm_store_ps(lanes[5], velocityZ);
+        _mm_store_ps(lanes[6], ages);
+        _mm_store_ps(lanes[7], lifetimes);
+        for (int lane = 0; lane < 4; ++lane) {
+            px[write] = lanes[0][lane];
+            py[write] = lanes[1][lane];
+            pz[write] = lanes[2][lane];
+            vx[write] = lanes[3][lane];
+            vy[write] = lanes[4][lane];
+            vz[write] = lanes[5][lane];
+            age[write] = lanes[6][lane];
+            lifetime[write] = lanes[7][lane];
+            write += (alive >> lane) & 1;
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        float velocityX = (vx[i] + gravityX) * damping;
+        float velocityY = (vy[i] + gravityY) * damping;
+        float velocityZ = (vz[i] + gravityZ) * damping;
+        float ages = age[i] + deltaTime;
+        if (!(ages < lifetime[i])) {
+            continue;
+        }
+        px[write] = px[i] + velocityX * deltaTime;
+        py[write] = py[i] + velocityY * deltaTime;
+        pz[write] = pz[i] + velocityZ * deltaTime;
+        vx[write] = velocityX;
+        vy[write] = velocityY;
+        vz[write] = velocityZ;
+        age[write] = ages;
+        lifetime[write] = lifetime[i];
+        write++;
+    }
+    simulation->count = write;
+}
+
+uint32_t EmitParticlesCPU(ParticleSimulationCPU* simulation, const ParticleEmitter* emitter, uint32_t firstSpawn, uint32_t count) {
+    // Same draws in the same order as particleEmit.comp
+    count = SDL_min(count, simulation->capacity - simulation->count);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t state = firstSpawn + i;
+        uint32_t index = simulation->count++;
+        simulation->positionX[index] = emitter->position[0] + (NextRandom(&state) * 2.0f - 1.0f) * emitter->radius;
+        simulation->positionY[index] = emitter->position[1] + (NextRandom(&state) * 2.0f - 1.0f) * emitter->radius;
+        simulation->positionZ[index] = emitter->position[2] + (NextRandom(&state) * 2.0f - 1.0f) * emitter->radius;
+        simulation->velocityX[index] = emitter->velocity[0] + (NextRandom(&state) * 2.0f - 1.0f) * emitter->velocitySpread;
+        simulation->velocityY[index] = emitter->velocity[1] + (NextRandom(&state) * 2.0f - 1.0f) * emitter->velocitySpread;
+        simulation->velocityZ[index] = emitter->velocity[2] + (NextRandom(&state) * 2.0f - 1.0f) * emitter->velocitySpread;
+        simulation->lifetime[index] = emitter->minLifetime + NextRandom(&state) * (emitter->maxLifetime - emitter->minLifetime);
+        simulation->age[index] = 0.0f;
+    }
+    return count;
+}
+
+void ReadParticlesCPU(const ParticleSimulationCPU* simulation, Particle* particles) {
+    for (uint32_t i = 0; i < simulation->count; ++i) {
+        particles[i] = {
+            .position = { simulation->positionX[i], simulation->positionY[i], simulation->positionZ[i] },
+            .age = simulation->age[i],
+            .velocity = { simulation->velocityX[i], simulation->velocityY[i], simulation->velocityZ[i] },
+            .lifetime = simulation->lifetime[i],
+        };
+    }
+}
+
+static bool CreateParticleRenderPipeline(SDL_GPUDevice* GPUDevice, ParticleSystem* system, SDL_GPUTextureFormat colorTargetFormat) {
+    SDL_GPUShader* vertexShader = LoadShader(GPUDevice, "particle.vert");
+    SDL_GPUShader* fragmentShader = LoadShader(GPUDevice, "particle.frag");
+    if (vertexShader != NULL && fragmentShader != NULL) {
+        // Additive, the fragment shader premultiplies
+        SDL_GPUColorTargetDescription colorTargetDescription[] = {{
+            .format = colorTargetFormat,
+            .blend_state = {
+                .src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                .color_blend_op = SDL_GPU_BLENDOP_ADD,
+                .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+                .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+                .enable_blend = true,
+            },
+        }};
+
+        // No vertex input, the quads come from SV_VertexID and SV_InstanceID
+        SDL_GPUGraphicsPipelineCreateInfo createInfo = {
+            .vertex_shader = vertexShader,
+            .fragment_shader = fragmentShader,
+            .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+            .target_info = {
+                .color_target_descriptions = colorTargetDescription,
+                .num_color_targets = 1,
+            },
+        };
+        system->renderPipeline = AcquireGraphicsPipeline(GPUDevice, &createInfo);
+    }
+    if (vertexShader != NULL) {
+        ReleaseShader(GPUDevice, vertexShader);
+    }
+    if (fragmentShader != NULL) {
+        ReleaseShader(GPUDevice, fragmentShader);
+    }
+    return system->renderPipeline != NULL;
+}
+
+bool CreateParticleSystem(
+    SDL_GPUDevice* GPUDevice,
+    ParticleSystem* system,
+    UploadQueue* uploadQueue,
+    uint32_t capacity,
+    ParticleMode mode,
+    SDL_GPUTextureFormat colorTargetFormat
+) {
+    *system = {
+        .mode = mode,
+        .capacity = capacity,
+        .startColor = { 1.0f, 1.0f, 1.0f, 1.0f },
+        .endColor = { 1.0f, 1.0f, 1.0f, 0.0f },
+    };
+
+    if (!CreateParticleRenderPipeline(GPUDevice, system, colorTargetFormat)) {
+        SDL_LogError(1, "Failed to create particle pipeline");
+        DestroyParticleSystem(GPUDevice, system);
+        return false;
+    }
+
+    if (mode != PARTICLE_MODE_CPU) {
+        system->emitPipeline = CreateComputePipelineFromShader(GPUDevice, "particleEmit.comp");
+        system->simulatePipeline = CreateComputePipelineFromShader(GPUDevice, "particleSimulate.comp");
+        system->argsPipeline = CreateComputePipelineFromShader(GPUDevice, "particleArgs.comp");
+        if (system->emitPipeline == NULL || system->simulatePipeline == NULL || system->argsPipeline == NULL) {
+            SDL_LogWarn(1, "Particle compute pipelines are unavailable, simulating particles on the CPU");
+            system->mode = PARTICLE_MODE_CPU;
+        }
+    }
+    if (system->mode != PARTICLE_MODE_GPU && !CreateParticleSimulationCPU(&system->reference, capacity)) {
+        DestroyParticleSystem(GPUDevice, system);
+        return false;
+    }
+
+    SDL_GPUBufferCreateInfo particleInfo = {
+        .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+        .size = capacity * (uint32_t)sizeof(Particle),
+    };
+    SDL_GPUBufferCreateInfo countInfo = {
+        .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+        .size = 2 * sizeof(uint32_t),
+    };
+    SDL_GPUBufferCreateInfo argsInfo = {
+        .usage = SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+        .size = sizeof(ParticleArgs),
+    };
+    system->particleBuffers[0] = SDL_CreateGPUBuffer(GPUDevice, &particleInfo);
+    system->particleBuffers[1] = SDL_CreateGPUBuffer(GPUDevice, &particleInfo);
+    system->countBuffer = SDL_CreateGPUBuffer(GPUDevice, &countInfo);
+    system->argsBuffer = SDL_CreateGPUBuffer(GPUDevice, &argsInfo);
+    if (system->particleBuffers[0] == NULL || system->particleBuffers[1] == NULL || system->countBuffer == NULL || system->argsBuffer == NULL) {
+        SDL_LogError(1, "Failed to create particle buffers! error: %s", SDL_GetError());
+        DestroyParticleSystem(GPUDevice, system);
+        return false;
+    }
+
+    const uint32_t counts[2] = { 0, 0 };
+    const ParticleArgs args = {
+        .simulate = { .groupcount_x = 0, .groupcount_y = 1, .groupcount_z = 1 },
+        .padding = 0,
+        .draw = { .num_vertices = 6, .num_instances = 0, .first_vertex = 0, .first_instance = 0 },
+    };
+    if (!QueueBufferUpload(GPUDevice, uploadQueue, system->countBuffer, 0, counts, sizeof(counts)) ||
+        !QueueBufferUpload(GPUDevice, uploadQueue, system->argsBuffer, 0, &args, sizeof(args))) {
+        DestroyParticleSystem(GPUDevice, system);
+        return false;
+    }
+    return true;
+}
+
+void DestroyParticleSystem(SDL_GPUDevice* GPUDevice, ParticleSystem* system) {
+    SDL_GPUComputePipeline* computePipelines[] = { system->emitPipeline, system->simulatePipeline, system->argsPipeline };
+    for (SDL_GPUComputePipeline* pipeline : computePipelines) {
+        if (pipeline != NULL) {
+            SDL_ReleaseGPUComputePipeline(GPUDevice, pipeline);
+        }
+    }
+    if (system->renderPipeline != NULL) {
+        ReleaseGraphicsPipeline(GPUDevice, system->renderPipeline);
+    }
+    SDL_GPUBuffer* buffers[] = { system->particleBuffers[0], system->particleBuffers[1], system->countBuffer, system->argsBuffer };
+    for (SDL_GPUBuffer* buffer : buffers) {
+        if (buffer != NULL) {
+            SDL_ReleaseGPUBuffer(GPUDevice, buffer);
+        }
+    }
+    DestroyParticleSimulationCPU(&system->reference);
+    *system = {};
+}
+
+bool UpdateParticles(SDL_GPUDevice* GPUDevice, ParticleSystem* system, UploadQueue* uploadQueue, float deltaTime) {
+    system->emitAccumulator += system->emitter.rate * deltaTime;
+    uint32_t emit = (uint32_t)SDL_min(system->emitAccumulator, (float)system->capacity);
+    system->emitAccumulator = SDL_max(system->emitAccumulator - (float)emit, 0.0f);
+
+    system->frameFirstSpawn = system->nextSpawn;
+    system->frameEmit = emit;
+    system->frameDeltaTime = deltaTime;
+    system->nextSpawn += emit;
+    system->stats.frameEmitted = emit;
+    system->stats.totalEmitted += emit;
+
+    if (system->mode == PARTICLE_MODE_GPU) {
+        return true;
+    }
+
+    Uint64 start = SDL_GetTicksNS();
+    SimulateParticlesCPU(&system->reference, &system->params, deltaTime);
+    EmitParticlesCPU(&system->reference, &system->emitter, system->frameFirstSpawn, emit);
+    system->stats.cpuSimulateNS += SDL_GetTicksNS() - start;
+    system->stats.cpuParticles = system->reference.count;
+    system->stats.cpuFrames++;
+
+    if (system->mode != PARTICLE_MODE_CPU) {
+        return true;
+    }
+
+    // The fallback draws from the first buffer with the count written straight into the draw
+    uint32_t count = system->reference.count;
+    if (count > 0) {
+        Particle* particles = static_cast<Particle*>(QueueBufferWrite(
+            GPUDevice,
+            uploadQueue,
+            system->particleBuffers[0],
+            0,
+            count * (uint32_t)sizeof(Particle)
+        ));
+        if (particles == NULL) {
+            SDL_LogError(1, "Not enough staging space for %u CPU particles", count);
+            count = 0;
+        } else {
+            ReadParticlesCPU(&system->reference, particles);
+        }
+    }
+    SDL_GPUIndirectDrawCommand draw = { .num_vertices = 6, .num_instances = count, .first_vertex = 0, .first_instance = 0 };
+    return QueueBufferUpload(GPUDevice, uploadQueue, system->argsBuffer, offsetof(ParticleArgs, draw), &draw, sizeof(draw));
+}
+
+void SimulateParticles(ParticleSystem* system, SDL_GPUCommandBuffer* commandBuffer) {
+    if (system->mode == PARTICLE_MODE_CPU) {
+        return;
+    }
+
+    uint32_t source = system->current;
+    uint32_t target = 1 - source;
+    uint32_t sourceCountOffset = source * sizeof(uint32_t);
+    uint32_t targetCountOffset = target * sizeof(uint32_t);
+
+    // Separate passes so each one sees the previous one's writes. The target is fully rewritten,
+    // so the simulate pass may discard what a previous frame left in it.
+    SDL_GPUStorageBufferReadWriteBinding simulateBindings[] = {
+        { .buffer = system->particleBuffers[target], .cycle = true },
+        { .buffer = system->countBuffer, .cycle = false },
+    };
+    SimulateUniforms simulateUniforms = {
+        .gravity = { system->params.gravity[0], system->params.gravity[1], system->params.gravity[2] },
+        .drag = system->params.drag,
+        .deltaTime = system->frameDeltaTime,
+        .sourceCountOffset = sourceCountOffset,
+        .targetCountOffset = targetCountOffset,
+        .capacity = system->capacity,
+    };
+    SDL_GPUComputePass* computePass = SDL_BeginGPUComputePass(commandBuffer, NULL, 0, simulateBindings, SDL_arraysize(simulateBindings));
+    SDL_BindGPUComputePipeline(computePass, system->simulatePipeline);
+    SDL_BindGPUComputeStorageBuffers(computePass, 0, &system->particleBuffers[source], 1);
+    SDL_PushGPUComputeUniformData(commandBuffer, 0, &simulateUniforms, sizeof(simulateUniforms));
+    SDL_DispatchGPUComputeIndirect(computePass, system->argsBuffer, offsetof(ParticleArgs, simulate));
+    SDL_EndGPUComputePass(computePass);
+
+    if (system->frameEmit > 0) {
+        SDL_GPUStorageBufferReadWriteBinding emitBindings[] = {
+            { .buffer = system->particleBuffers[target], .cycle = false },
+            { .buffer = system->countBuffer, .cycle = false },
+        };
+        const ParticleEmitter* emitter = &system->emitter;
+        EmitUniforms emitUniforms = {
+            .position = { emitter->position[0], emitter->position[1], emitter->position[2] },
+            .radius = emitter->radius,
+            .velocity = { emitter->velocity[0], emitter->velocity[1], emitter->velocity[2] },
+            .velocitySpread = emitter->velocitySpread,
+            .minLifetime = emitter->minLifetime,
+            .maxLifetime = emitter->maxLifetime,
+            .firstSpawn = system->frameFirstSpawn,
+            .emitCount = system->frameEmit,
+            .countOffset = targetCountOffset,
+            .capacity = system->capacity,
+        };
+        computePass = SDL_BeginGPUComputePass(commandBuffer, NULL, 0, emitBindings, SDL_arraysize(emitBindings));
+        SDL_BindGPUComputePipeline(computePass, system->emitPipeline);
+        SDL_PushGPUComputeUniformData(commandBuffer, 0, &emitUniforms, sizeof(emitUniforms));
+        SDL_DispatchGPUCompute(computePass, (system->frameEmit + PARTICLE_GROUP_SIZE - 1) / PARTICLE_GROUP_SIZE, 1, 1);
+        SDL_EndGPUComputePass(computePass);
+    }
+
+    SDL_GPUStorageBufferReadWriteBinding argsBindings[] = {
+        { .buffer = system->countBuffer, .cycle = false },
+        { .buffer = system->argsBuffer, .cycle = false },
+    };
+    ArgsUniforms argsUniforms = {
+        .sourceCountOffset = sourceCountOffset,
+        .targetCountOffset = targetCountOffset,
+        .capacity = system->capacity,
+    };
+    computePass = SDL_BeginGPUComputePass(commandBuffer, NULL, 0, argsBindings, SDL_arraysize(argsBindings));
+    SDL_BindGPUComputePipeline(computePass, system->argsPipeline);
+    SDL_PushGPUComputeUniformData(commandBuffer, 0, &argsUniforms, sizeof(argsUniforms));
+    SDL_DispatchGPUCompute(computePass, 1, 1, 1);
+    SDL_EndGPUComputePass(computePass);
+
+    system->current = target;
+    system->stats.gpuFrames++;
+}
+
+void RenderParticles(
+    ParticleSystem* system,
+    SDL_GPUCommandBuffer* commandBuffer,
+    SDL_GPURenderPass* renderPass,
+    const Matrix4x4* view,
+    const Matrix4x4* viewProjection,
+    float size
+) {
+    // The view matrix's columns are the camera axes in world space
+    ParticleUniforms uniforms = {
+        .viewProjection = *viewProjection,
+        .cameraRight = { view->m11, view->m21, view->m31 },
+        .size = size,
+        .cameraUp = { view->m12, view->m22, view->m32 },
+        .padding = 0.0f,
+    };
+    SDL_memcpy(uniforms.startColor, system->startColor, sizeof(uniforms.startColor));
+    SDL_memcpy(uniforms.endColor, system->endColor, sizeof(uniforms.endColor));
+
+    SDL_BindGPUGraphicsPipeline(renderPass, system->renderPipeline);
+    SDL_BindGPUVertexStorageBuffers(renderPass, 0, &system->particleBuffers[system->current], 1);
+    SDL_PushGPUVertexUniformData(commandBuffer, 0, &uniforms, sizeof(uniforms));
+    SDL_DrawGPUPrimitivesIndirect(renderPass, system->argsBuffer, offsetof(ParticleArgs, draw), 1);
+}
+
+bool ReadbackParticles(SDL_GPUDevice* GPUDevice, ParticleSystem* system, std::vector<Particle>* particles) {
+    if (system->mode == PARTICLE_MODE_CPU) {
+        particles->resize(system->reference.count);
+        ReadParticlesCPU(&system->reference, particles->data());
+        return true;
+    }
+
+    // The count first, the particles after it at a 16 byte offset
+    uint32_t particleBytes = system->capacity * (uint32_t)sizeof(Particle);
+    SDL_GPUTransferBufferCreateInfo transferInfo = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+        .size = 16 + particleBytes,
+    };
+    SDL_GPUTransferBuffer* transferBuffer = SDL_CreateGPUTransferBuffer(GPUDevice, &transferInfo);
+    if (transferBuffer == NULL) {
+        SDL_LogError(1, "Failed to create particle readback buffer! error: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(GPUDevice);
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    SDL_GPUBufferRegion countRegion = {
+        .buffer = system->countBuffer,
+        .offset = system->current * (uint32_t)sizeof(uint32_t),
+        .size = sizeof(uint32_t),
+    };
+    SDL_GPUTransferBufferLocation countLocation = { .transfer_buffer = transferBuffer, .offset = 0 };
+    SDL_DownloadFromGPUBuffer(copyPass, &countRegion, &countLocation);
+    SDL_GPUBufferRegion particleRegion = {
+        .buffer = system->particleBuffers[system->current],
+        .offset = 0,
+        .size = particleBytes,
+    };
+    SDL_GPUTransferBufferLocation particleLocation = { .transfer_buffer = transferBuffer, .offset = 16 };
+    SDL_DownloadFromGPUBuffer(copyPass, &particleRegion, &particleLocation);
+    SDL_EndGPUCopyPass(copyPass);
+
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+    bool done = fence != NULL && SDL_WaitForGPUFences(GPUDevice, true, &fence, 1);
+    if (fence != NULL) {
+        SDL_ReleaseGPUFence(GPUDevice, fence);
+    }
+    if (!done) {
+        SDL_LogError(1, "Failed to read back particles! error: %s", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(GPUDevice, transferBuffer);
+        return false;
+    }
+
+    const uint8_t* mapped = static_cast<const uint8_t*>(SDL_MapGPUTransferBuffer(GPUDevice, transferBuffer, false));
+    uint32_t count;
+    SDL_memcpy(&count, mapped, sizeof(count));
+    count = SDL_min(count, system->capacity);
+    particles->resize(count);
+    SDL_memcpy(particles->data(), mapped + 16, count * sizeof(Particle));
+    SDL_UnmapGPUTransferBuffer(GPUDevice, transferBuffer);
+    SDL_ReleaseGPUTransferBuffer(GPUDevice, transferBuffer);
+    return true;
+}
+
+static bool ParticleLess(const Particle& a, const Particle& b) {
+    // Spawned lifetimes are practically unique, ages separate the rest
+    if (a.lifetime != b.lifetime) {
+        return a.lifetime < b.lifetime;
+    }
+    return a.age < b.age;
+}
+
+bool ValidateParticles(SDL_GPUDevice* GPUDevice, ParticleSystem* system, float tolerance) {
+    if (system->mode != PARTICLE_MODE_VALIDATE) {
+        SDL_LogError(1, "ValidateParticles needs PARTICLE_MODE_VALIDATE");
+        return false;
+    }
+
+    std::vector<Particle> gpu;
+    if (!ReadbackParticles(GPUDevice, system, &gpu)) {
+        return false;
+    }
+    std::vector<Particle> cpu(system->reference.count);
+    ReadParticlesCPU(&system->reference, cpu.data());
+
+    // Once the buffer is full, which emitted particles the GPU kept depends on thread order
+    if (gpu.size() != cpu.size()) {
+        SDL_LogError(1, "Particle validation: GPU has %zu particles, CPU has %zu", gpu.size(), cpu.size());
+        return false;
+    }
+
+    std::sort(gpu.begin(), gpu.end(), ParticleLess);
+    std::sort(cpu.begin(), cpu.end(), ParticleLess);
+    float maxError = 0.0f;
+    uint32_t mismatches = 0;
+    for (size_t i = 0; i < gpu.size(); ++i) {
+        const float* a = &gpu[i].position[0];
+        const float* b = &cpu[i].position[0];
+        float error = 0.0f;
+        for (size_t component = 0; component < sizeof(Particle) / sizeof(float); ++component) {
+            error = SDL_max(error, SDL_fabsf(a[component] - b[component]) / SDL_max(1.0f, SDL_fabsf(b[component])));
+        }
+        maxError = SDL_max(maxError, error);
+        mismatches += error > tolerance;
+    }
+
+    if (mismatches > 0) {
+        SDL_LogError(1, "Particle validation: %u of %zu particles differ, largest relative error %g", mismatches, gpu.size(), maxError);
+        return false;
+    }
+    SDL_Log("Particle validation: %zu particles match, largest relative error %g", gpu.size(), maxError);
+    return true;
+}
+
+const ParticleStats* GetParticleStats(const ParticleSystem* system) {
+    return &system->stats;
+}
+
+void LogParticleStats(const ParticleSystem* system) {
+    const ParticleStats* stats = &system->stats;
+    double cpuFrameMS = stats->cpuFrames == 0 ? 0.0 : (double)stats->cpuSimulateNS / SDL_NS_PER_MS / (double)stats->cpuFrames;
+    SDL_Log(
+        "Particles: %u emitted this frame, %llu total, %llu GPU frames, %llu CPU frames (%u particles, %.3f ms per frame)",
+        stats->frameEmitted,
+        (unsigned long long)stats->totalEmitted,
+        (unsigned long long)stats->gpuFrames,
+        (unsigned long long)stats->cpuFrames,
+        stats->cpuParticles,
+        cpuFrameMS
+    );
+}
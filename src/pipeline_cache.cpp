@@ -0,0 +1,242 @@
+#include "../include/pipeline_cache.hpp"
+#include "../include/shader_cache.hpp"
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_timer.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct PipelineKey {
+    uint64_t hash;
+    std::vector<uint32_t> words;
+
+    bool operator==(const PipelineKey& other) const {
+        return hash == other.hash && words == other.words;
+    }
+};
+
+struct PipelineKeyHash {
+    size_t operator()(const PipelineKey& key) const {
+        return (size_t)key.hash;
+    }
+};
+
+struct PipelineEntry {
+    PipelineKey key;
+    SDL_GPUShader* vertexShader;
+    SDL_GPUShader* fragmentShader;
+    uint32_t refCount;
+};
+
+static std::unordered_map<PipelineKey, SDL_GPUGraphicsPipeline*, PipelineKeyHash> pipelinesByKey;
+static std::unordered_map<SDL_GPUGraphicsPipeline*, PipelineEntry> pipelineEntries;
+static PipelineCacheStats stats;
+static std::mutex cacheMutex;
+
+static void PushPointer(std::vector<uint32_t>* words, const void* pointer) {
+    uint64_t value = (uint64_t)(uintptr_t)pointer;
+    words->push_back((uint32_t)value);
+    words->push_back((uint32_t)(value >> 32));
+}
+
+static void PushFloat(std::vector<uint32_t>* words, float value) {
+    uint32_t bits;
+    SDL_memcpy(&bits, &value, sizeof(bits));
+    words->push_back(bits);
+}
+
+static void PushStencilState(std::vector<uint32_t>* words, const SDL_GPUStencilOpState* state) {
+    words->push_back(state->fail_op);
+    words->push_back(state->pass_op);
+    words->push_back(state->depth_fail_op);
+    words->push_back(state->compare_op);
+}
+
+// Flattens the create-info field by field, so padding bytes and the addresses of the
+// description arrays never leak into the key, only their contents do.
+static PipelineKey BuildPipelineKey(const SDL_GPUGraphicsPipelineCreateInfo* info) {
+    PipelineKey key;
+    std::vector<uint32_t>* words = &key.words;
+    words->reserve(64);
+
+    PushPointer(words, info->vertex_shader);
+    PushPointer(words, info->fragment_shader);
+
+    const SDL_GPUVertexInputState* vertexInput = &info->vertex_input_state;
+    words->push_back(vertexInput->num_vertex_buffers);
+    for (Uint32 i = 0; i < vertexInput->num_vertex_buffers; ++i) {
+        const SDL_GPUVertexBufferDescription* desc = &vertexInput->vertex_buffer_descriptions[i];
+        words->push_back(desc->slot);
+        words->push_back(desc->pitch);
+        words->push_back(desc->input_rate);
+        words->push_back(desc->instance_step_rate);
+    }
+    words->push_back(vertexInput->num_vertex_attributes);
+    for (Uint32 i = 0; i < vertexInput->num_vertex_attributes; ++i) {
+        const SDL_GPUVertexAttribute* attribute = &vertexInput->vertex_attributes[i];
+        words->push_back(attribute->location);
+        words->push_back(attribute->buffer_slot);
+        words->push_back(attribute->format);
+        words->push_back(attribute->offset);
+    }
+
+    words->push_back(info->primitive_type);
+
+    const SDL_GPURasterizerState* rasterizer = &info->rasterizer_state;
+    words->push_back(rasterizer->fill_mode);
+    words->push_back(rasterizer->cull_mode);
+    words->push_back(rasterizer->front_face);
+    PushFloat(words, rasterizer->depth_bias_constant_factor);
+    PushFloat(words, rasterizer->depth_bias_clamp);
+    PushFloat(words, rasterizer->depth_bias_slope_factor);
+    words->push_back(rasterizer->enable_depth_bias | (rasterizer->enable_depth_clip << 1));
+
+    const SDL_GPUMultisampleState* multisample = &info->multisample_state;
+    words->push_back(multisample->sample_count);
+    words->push_back(multisample->sample_mask);
+    words->push_back(multisample->enable_mask);
+
+    const SDL_GPUDepthStencilState* depthStencil = &info->depth_stencil_state;
+    words->push_back(depthStencil->compare_op);
+    PushStencilState(words, &depthStencil->back_stencil_state);
+    PushStencilState(words, &depthStencil->front_stencil_state);
+    words->push_back(depthStencil->compare_mask | (depthStencil->write_mask << 8));
+    words->push_back(
+        depthStencil->enable_depth_test |
+        (depthStencil->enable_depth_write << 1) |
+        (depthStencil->enable_stencil_test << 2)
+    );
+
+    const SDL_GPUGraphicsPipelineTargetInfo* targets = &info->target_info;
+    words->push_back(targets->num_color_targets);
+    for (Uint32 i = 0; i < targets->num_color_targets; ++i) {
+        const SDL_GPUColorTargetDescription* target = &targets->color_target_descriptions[i];
+        const SDL_GPUColorTargetBlendState* blend = &target->blend_state;
+        words->push_back(target->format);
+        words->push_back(blend->src_color_blendfactor);
+        words->push_back(blend->dst_color_blendfactor);
+        words->push_back(blend->color_blend_op);
+        words->push_back(blend->src_alpha_blendfactor);
+        words->push_back(blend->dst_alpha_blendfactor);
+        words->push_back(blend->alpha_blend_op);
+        words->push_back(blend->color_write_mask | (blend->enable_blend << 8) | (blend->enable_color_write_mask << 9));
+    }
+    words->push_back(targets->depth_stencil_format);
+    words->push_back(targets->has_depth_stencil_target);
+
+    words->push_back(info->props);
+
+    // FNV-1a over the words
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (uint32_t word : key.words) {
+        hash ^= word;
+        hash *= 0x100000001B3ull;
+    }
+    key.hash = hash;
+    return key;
+}
+
+SDL_GPUGraphicsPipeline* AcquireGraphicsPipeline(
+    SDL_GPUDevice* GPUDevice,
+    const SDL_GPUGraphicsPipelineCreateInfo* createInfo
+) {
+    PipelineKey key = BuildPipelineKey(createInfo);
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = pipelinesByKey.find(key);
+        if (found != pipelinesByKey.end()) {
+            stats.hits++;
+            pipelineEntries[found->second].refCount++;
+            return found->second;
+        }
+        stats.misses++;
+    }
+
+    // Pipeline compilation is the slow part of startup, so it runs unlocked and
+    // startup workers can compile different pipelines at the same time
+    Uint64 start = SDL_GetTicksNS();
+    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(GPUDevice, createInfo);
+    Uint64 duration = SDL_GetTicksNS() - start;
+    if (pipeline == NULL) {
+        SDL_LogError(1, "Failed creating graphics pipeline error: %s", SDL_GetError());
+        return NULL;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    stats.creationNS += duration;
+
+    // Another thread may have finished the same pipeline in the meantime
+    auto found = pipelinesByKey.find(key);
+    if (found != pipelinesByKey.end()) {
+        SDL_ReleaseGPUGraphicsPipeline(GPUDevice, pipeline);
+        pipelineEntries[found->second].refCount++;
+        return found->second;
+    }
+
+    RetainShader(createInfo->vertex_shader);
+    RetainShader(createInfo->fragment_shader);
+
+    pipelinesByKey[key] = pipeline;
+    pipelineEntries[pipeline] = {
+        .key = std::move(key),
+        .vertexShader = createInfo->vertex_shader,
+        .fragmentShader = createInfo->fragment_shader,
+        .refCount = 1,
+    };
+    stats.livePipelines++;
+    return pipeline;
+}
+
+void ReleaseGraphicsPipeline(SDL_GPUDevice* GPUDevice, SDL_GPUGraphicsPipeline* pipeline) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto found = pipelineEntries.find(pipeline);
+    if (found == pipelineEntries.end()) {
+        SDL_LogWarn(1, "ReleaseGraphicsPipeline called with a pipeline that is not in the cache");
+        return;
+    }
+    if (--found->second.refCount > 0) {
+        return;
+    }
+
+    PipelineEntry entry = std::move(found->second);
+    pipelineEntries.erase(found);
+    pipelinesByKey.erase(entry.key);
+    stats.livePipelines--;
+
+    SDL_ReleaseGPUGraphicsPipeline(GPUDevice, pipeline);
+    ReleaseShader(GPUDevice, entry.vertexShader);
+    ReleaseShader(GPUDevice, entry.fragmentShader);
+}
+
+void DestroyPipelineCache(SDL_GPUDevice* GPUDevice) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (!pipelineEntries.empty()) {
+        SDL_LogWarn(1, "Destroying pipeline cache with %zu pipelines still referenced", pipelineEntries.size());
+    }
+    for (auto& [pipeline, entry] : pipelineEntries) {
+        SDL_ReleaseGPUGraphicsPipeline(GPUDevice, pipeline);
+        ReleaseShader(GPUDevice, entry.vertexShader);
+        ReleaseShader(GPUDevice, entry.fragmentShader);
+    }
+    pipelineEntries.clear();
+    pipelinesByKey.clear();
+    stats.livePipelines = 0;
+}
+
+const PipelineCacheStats* GetPipelineCacheStats() {
+    return &stats;
+}
+
+void LogPipelineCacheStats() {
+    uint32_t lookups = stats.hits + stats.misses;
+    SDL_Log(
+        "Pipeline cache: %u lookups, %u hits (%.1f%%), %u created in %.2f ms, %u live",
+        lookups,
+        stats.hits,
+        lookups ? 100.0 * stats.hits / lookups : 0.0,
+        stats.misses,
+        (double)stats.creationNS / SDL_NS_PER_MS,
+        stats.livePipelines
+    );
+}
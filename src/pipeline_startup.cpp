@@ -0,0 +1,127 @@
+#include "../include/pipeline_startup.hpp"
+#include "../include/common.hpp"
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_timer.h>
+#include <vector>
+
+#define MAX_PIPELINE_WORKERS 16
+
+struct PipelineWorkQueue {
+    SDL_GPUDevice* GPUDevice;
+    PipelineJob* jobs;
+    uint32_t jobCount;
+    SDL_AtomicInt nextJob;
+};
+
+struct PipelineWorker {
+    PipelineWorkQueue* queue;
+    int index;
+};
+
+PipelineJob GraphicsPipelineJob(
+    const char* name,
+    GraphicsPipelineVariants* variants,
+    uint16_t vertexMask,
+    uint16_t fragmentMask
+) {
+    PipelineJob job = {};
+    job.name = name;
+    job.kind = PIPELINE_JOB_GRAPHICS;
+    job.variants = variants;
+    job.vertexMask = vertexMask;
+    job.fragmentMask = fragmentMask;
+    return job;
+}
+
+PipelineJob ComputePipelineJob(const char* name, const char* computeShader, SDL_GPUComputePipeline** computePipeline) {
+    PipelineJob job = {};
+    job.name = name;
+    job.kind = PIPELINE_JOB_COMPUTE;
+    job.computeShader = computeShader;
+    job.computePipeline = computePipeline;
+    return job;
+}
+
+static void RunJob(SDL_GPUDevice* GPUDevice, PipelineJob* job, int workerIndex) {
+    Uint64 start = SDL_GetTicksNS();
+    if (job->kind == PIPELINE_JOB_GRAPHICS) {
+        // The result is only stored into the variant map after the join, on the calling thread
+        job->graphicsPipeline = CreateGraphicsPipelineVariant(GPUDevice, job->variants, job->vertexMask, job->fragmentMask);
+        job->succeeded = job->graphicsPipeline != NULL;
+    } else {
+        *job->computePipeline = CreateComputePipelineFromShader(GPUDevice, job->computeShader);
+        job->succeeded = *job->computePipeline != NULL;
+    }
+    job->workerIndex = workerIndex;
+    job->durationNS = SDL_GetTicksNS() - start;
+}
+
+static void DrainQueue(PipelineWorkQueue* queue, int workerIndex) {
+    for (;;) {
+        int jobIndex = SDL_AddAtomicInt(&queue->nextJob, 1);
+        if (jobIndex >= (int)queue->jobCount) {
+            return;
+        }
+        RunJob(queue->GPUDevice, &queue->jobs[jobIndex], workerIndex);
+    }
+}
+
+static int SDLCALL PipelineWorkerMain(void* data) {
+    PipelineWorker* worker = static_cast<PipelineWorker*>(data);
+    DrainQueue(worker->queue, worker->index);
+    return 0;
+}
+
+bool BuildPipelines(SDL_GPUDevice* GPUDevice, PipelineJob* jobs, uint32_t jobCount) {
+    Uint64 start = SDL_GetTicksNS();
+
+    PipelineWorkQueue queue = {
+        .GPUDevice = GPUDevice,
+        .jobs = jobs,
+        .jobCount = jobCount,
+    };
+    SDL_SetAtomicInt(&queue.nextJob, 0);
+
+    // Worker 0 is the calling thread
+    int workerCount = SDL_min(SDL_min(SDL_GetNumLogicalCPUCores(), MAX_PIPELINE_WORKERS), (int)jobCount);
+    PipelineWorker workers[MAX_PIPELINE_WORKERS];
+    SDL_Thread* threads[MAX_PIPELINE_WORKERS] = {};
+    for (int i = 1; i < workerCount; ++i) {
+        workers[i] = { .queue = &queue, .index = i };
+        threads[i] = SDL_CreateThread(PipelineWorkerMain, "PipelineWorker", &workers[i]);
+        if (threads[i] == NULL) {
+            SDL_LogWarn(1, "Failed to start pipeline worker %d: %s", i, SDL_GetError());
+        }
+    }
+
+    DrainQueue(&queue, 0);
+    for (int i = 1; i < workerCount; ++i) {
+        if (threads[i] != NULL) {
+            SDL_WaitThread(threads[i], NULL);
+        }
+    }
+
+    bool succeeded = true;
+    Uint64 serialNS = 0;
+    for (uint32_t i = 0; i < jobCount; ++i) {
+        PipelineJob* job = &jobs[i];
+        if (job->kind == PIPELINE_JOB_GRAPHICS) {
+            SetGraphicsPipelineVariant(GPUDevice, job->variants, job->vertexMask, job->fragmentMask, job->graphicsPipeline);
+        }
+        if (!job->succeeded) {
+            SDL_LogError(1, "Pipeline %s failed to build", job->name);
+            succeeded = false;
+        }
+        serialNS += job->durationNS;
+        SDL_Log("Pipeline %s: %.2f ms (worker %d)", job->name, (double)job->durationNS / SDL_NS_PER_MS, job->workerIndex);
+    }
+
+    SDL_Log(
+        "Built %u pipelines on %d workers in %.2f ms (%.2f ms of work)",
+        jobCount,
+        SDL_max(workerCount, 1),
+        (double)(SDL_GetTicksNS() - start) / SDL_NS_PER_MS,
+        (double)serialNS / SDL_NS_PER_MS
+    );
+    return succeeded;
+}
@@ -0,0 +1,535 @@
+#include "../include/render_graph.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+void BeginRenderGraph(RenderGraph* graph) {
+    graph->resources.clear();
+    graph->passes.clear();
+    graph->order.clear();
+    graph->compiled = false;
+    graph->frame++;
+}
+
+void DestroyRenderGraph(SDL_GPUDevice* GPUDevice, RenderGraph* graph) {
+    for (const RenderGraphTexture& texture : graph->textures) {
+        SDL_ReleaseGPUTexture(GPUDevice, texture.texture);
+    }
+    *graph = {};
+}
+
+static RenderResource AddResource(RenderGraph* graph, const RenderGraphResource& resource) {
+    graph->resources.push_back(resource);
+    RenderGraphResource* added = &graph->resources.back();
+    added->firstUse = -1;
+    added->lastUse = -1;
+    added->physicalTexture = UINT32_MAX;
+    return (RenderResource)graph->resources.size() - 1;
+}
+
+RenderResource ImportRenderTexture(
+    RenderGraph* graph,
+    const char* name,
+    SDL_GPUTexture* texture,
+    SDL_GPUTextureFormat format,
+    uint32_t width,
+    uint32_t height
+) {
+    return AddResource(graph, {
+        .name = name,
+        .isTexture = true,
+        .imported = true,
+        .texture = texture,
+        .format = format,
+        .width = width,
+        .height = height,
+    });
+}
+
+RenderResource ImportRenderBuffer(RenderGraph* graph, const char* name, SDL_GPUBuffer* buffer) {
+    return AddResource(graph, {
+        .name = name,
+        .isTexture = false,
+        .imported = true,
+        .buffer = buffer,
+    });
+}
+
+RenderResource CreateRenderTexture(RenderGraph* graph, const char* name, SDL_GPUTextureFormat format, uint32_t width, uint32_t height) {
+    return AddResource(graph, {
+        .name = name,
+        .isTexture = true,
+        .imported = false,
+        .format = format,
+        .width = width,
+        .height = height,
+    });
+}
+
+void MarkRenderGraphOutput(RenderGraph* graph, RenderResource resource) {
+    graph->resources[resource].output = true;
+}
+
+uint32_t AddRenderGraphPass(RenderGraph* graph, const char* name, RenderGraphPassKind kind, RenderGraphExecute execute, void* userData) {
+    graph->passes.push_back({
+        .name = name,
+        .kind = kind,
+        .execute = execute,
+        .userData = userData,
+    });
+    return (uint32_t)graph->passes.size() - 1;
+}
+
+void SetRenderGraphSideEffect(RenderGraph* graph, uint32_t pass) {
+    graph->passes[pass].sideEffect = true;
+}
+
+static void AddAccess(RenderGraph* graph, uint32_t pass, RenderResource resource, RenderGraphAccessKind kind) {
+    SDL_assert(resource < graph->resources.size());
+    graph->passes[pass].accesses.push_back({ .resource = resource, .kind = kind });
+}
+
+void PassRead(RenderGraph* graph, uint32_t pass, RenderResource resource) {
+    AddAccess(graph, pass, resource, RENDER_GRAPH_ACCESS_READ);
+}
+
+void PassWrite(RenderGraph* graph, uint32_t pass, RenderResource resource) {
+    AddAccess(graph, pass, resource, RENDER_GRAPH_ACCESS_WRITE);
+}
+
+void PassColorTarget(RenderGraph* graph, uint32_t pass, RenderResource resource, const SDL_FColor* clearColor) {
+    AddAccess(graph, pass, resource, RENDER_GRAPH_ACCESS_COLOR_TARGET);
+    if (clearColor != NULL) {
+        graph->passes[pass].accesses.back().clear = true;
+        graph->passes[pass].accesses.back().clearColor = *clearColor;
+    }
+}
+
+void PassDepthTarget(RenderGraph* graph, uint32_t pass, RenderResource resource, const float* clearDepth) {
+    AddAccess(graph, pass, resource, RENDER_GRAPH_ACCESS_DEPTH_TARGET);
+    if (clearDepth != NULL) {
+        graph->passes[pass].accesses.back().clear = true;
+        graph->passes[pass].accesses.back().clearDepth = *clearDepth;
+    }
+}
+
+static bool IsWrite(const RenderGraphAccess& access) {
+    return access.kind != RENDER_GRAPH_ACCESS_READ;
+}
+
+// Uses the previous contents: reads, partial writes and targets that are not cleared
+static bool UsesContents(const RenderGraphAccess& access) {
+    return !access.clear;
+}
+
+static bool SortPasses(RenderGraph* graph) {
+    uint32_t passCount = (uint32_t)graph->passes.size();
+    std::vector<std::vector<uint32_t>> writers(graph->resources.size());
+    std::vector<std::vector<uint32_t>> readers(graph->resources.size());
+    for (uint32_t pass = 0; pass < passCount; ++pass) {
+        for (const RenderGraphAccess& access : graph->passes[pass].accesses) {
+            std::vector<uint32_t>& list = IsWrite(access) ? writers[access.resource] : readers[access.resource];
+            if (list.empty() || list.back() != pass) {
+                list.push_back(pass);
+            }
+        }
+    }
+
+    // Writers of a resource in declaration order, then every pure reader after the last one
+    std::vector<std::vector<uint32_t>> successors(passCount);
+    std::vector<uint32_t> inDegree(passCount, 0);
+    auto addEdge = [&](uint32_t from, uint32_t to) {
+        if (from != to) {
+            successors[from].push_back(to);
+            inDegree[to]++;
+        }
+    };
+    for (size_t resource = 0; resource < graph->resources.size(); ++resource) {
+        const std::vector<uint32_t>& resourceWriters = writers[resource];
+        for (size_t i = 1; i < resourceWriters.size(); ++i) {
+            addEdge(resourceWriters[i - 1], resourceWriters[i]);
+        }
+        if (!resourceWriters.empty()) {
+            for (uint32_t reader : readers[resource]) {
+                if (std::find(resourceWriters.begin(), resourceWriters.end(), reader) == resourceWriters.end()) {
+                    addEdge(resourceWriters.back(), reader);
+                }
+            }
+        }
+    }
+
+    // Kahn's algorithm, lowest declaration index first among the ready passes
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> ready;
+    for (uint32_t pass = 0; pass < passCount; ++pass) {
+        if (inDegree[pass] == 0) {
+            ready.push(pass);
+        }
+    }
+    graph->order.clear();
+    while (!ready.empty()) {
+        uint32_t pass = ready.top();
+        ready.pop();
+        graph->order.push_back(pass);
+        for (uint32_t next : successors[pass]) {
+            if (--inDegree[next] == 0) {
+                ready.push(next);
+            }
+        }
+    }
+
+    if (graph->order.size() != passCount) {
+        SDL_LogError(1, "Render graph has a dependency cycle, %u of %u passes could be ordered", (uint32_t)graph->order.size(), passCount);
+        return false;
+    }
+    return true;
+}
+
+static void CullPasses(RenderGraph* graph) {
+    // Walking backwards: a pass lives when it has a side effect or writes contents a living
+    // pass (or the world outside the graph) still needs. A cleared target ends the need for
+    // whatever was written before it.
+    std::vector<bool> needed(graph->resources.size());
+    for (size_t resource = 0; resource < graph->resources.size(); ++resource) {
+        needed[resource] = graph->resources[resource].output;
+    }
+
+    for (size_t i = graph->order.size(); i-- > 0;) {
+        RenderGraphPass* pass = &graph->passes[graph->order[i]];
+        pass->alive = pass->sideEffect;
+        for (const RenderGraphAccess& access : pass->accesses) {
+            pass->alive |= IsWrite(access) && needed[access.resource];
+        }
+        if (!pass->alive) {
+            continue;
+        }
+        for (const RenderGraphAccess& access : pass->accesses) {
+            if (!UsesContents(access)) {
+                needed[access.resource] = false;
+            }
+        }
+        for (const RenderGraphAccess& access : pass->accesses) {
+            if (UsesContents(access)) {
+                needed[access.resource] = true;
+            }
+        }
+    }
+}
+
+static void DeriveLoadStoreOps(RenderGraph* graph) {
+    std::vector<bool> hasContents(graph->resources.size());
+    for (size_t resource = 0; resource < graph->resources.size(); ++resource) {
+        hasContents[resource] = graph->resources[resource].imported;
+    }
+
+    int32_t position = 0;
+    for (uint32_t passIndex : graph->order) {
+        RenderGraphPass* pass = &graph->passes[passIndex];
+        if (!pass->alive) {
+            continue;
+        }
+        for (RenderGraphAccess& access : pass->accesses) {
+            RenderGraphResource* resource = &graph->resources[access.resource];
+            resource->firstUse = resource->firstUse < 0 ? position : resource->firstUse;
+            resource->lastUse = position;
+
+            switch (access.kind) {
+            case RENDER_GRAPH_ACCESS_READ:
+                resource->usage |= SDL_GPU_TEXTUREUSAGE_SAMPLER;
+                break;
+            case RENDER_GRAPH_ACCESS_WRITE:
+                resource->usage |= SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE;
+                break;
+            case RENDER_GRAPH_ACCESS_COLOR_TARGET:
+                resource->usage |= SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
+                break;
+            case RENDER_GRAPH_ACCESS_DEPTH_TARGET:
+                resource->usage |= SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET;
+                break;
+            }
+
+            if (access.clear) {
+                access.loadOp = SDL_GPU_LOADOP_CLEAR;
+            } else if (hasContents[access.resource]) {
+                access.loadOp = SDL_GPU_LOADOP_LOAD;
+            } else {
+                access.loadOp = SDL_GPU_LOADOP_DONT_CARE;
+                graph->stats.skippedLoads += access.kind == RENDER_GRAPH_ACCESS_COLOR_TARGET || access.kind == RENDER_GRAPH_ACCESS_DEPTH_TARGET;
+            }
+            hasContents[access.resource] = true;
+        }
+        position++;
+    }
+
+    // Backwards: a target is stored when a later pass uses its contents or it leaves the graph
+    std::vector<bool> usedLater(graph->resources.size());
+    for (size_t resource = 0; resource < graph->resources.size(); ++resource) {
+        usedLater[resource] = graph->resources[resource].imported || graph->resources[resource].output;
+    }
+    for (size_t i = graph->order.size(); i-- > 0;) {
+        RenderGraphPass* pass = &graph->passes[graph->order[i]];
+        if (!pass->alive) {
+            continue;
+        }
+        for (RenderGraphAccess& access : pass->accesses) {
+            bool target = access.kind == RENDER_GRAPH_ACCESS_COLOR_TARGET || access.kind == RENDER_GRAPH_ACCESS_DEPTH_TARGET;
+            if (target) {
+                access.storeOp = usedLater[access.resource] ? SDL_GPU_STOREOP_STORE : SDL_GPU_STOREOP_DONT_CARE;
+                graph->stats.skippedStores += access.storeOp == SDL_GPU_STOREOP_DONT_CARE;
+            }
+        }
+        for (const RenderGraphAccess& access : pass->accesses) {
+            if (access.loadOp == SDL_GPU_LOADOP_CLEAR || access.loadOp == SDL_GPU_LOADOP_DONT_CARE) {
+                usedLater[access.resource] = graph->resources[access.resource].imported;
+            }
+        }
+        for (const RenderGraphAccess& access : pass->accesses) {
+            if (access.kind == RENDER_GRAPH_ACCESS_READ || access.loadOp == SDL_GPU_LOADOP_LOAD) {
+                usedLater[access.resource] = true;
+            }
+        }
+    }
+}
+
+static uint64_t TextureBytes(SDL_GPUTextureFormat format, uint32_t width, uint32_t height) {
+    return (uint64_t)SDL_GPUTextureFormatTexelBlockSize(format) * width * height;
+}
+
+static bool AssignTextures(SDL_GPUDevice* GPUDevice, RenderGraph* graph) {
+    std::vector<uint32_t> transients;
+    for (uint32_t resource = 0; resource < graph->resources.size(); ++resource) {
+        const RenderGraphResource* r = &graph->resources[resource];
+        if (r->isTexture && !r->imported && r->firstUse >= 0) {
+            transients.push_back(resource);
+        }
+    }
+    std::sort(transients.begin(), transients.end(), [graph](uint32_t a, uint32_t b) {
+        return graph->resources[a].firstUse < graph->resources[b].firstUse;
+    });
+
+    // First fit: the first pooled texture of the same description that is free by the time
+    // the resource is first used. SDL has no placed resources, so aliasing shares the texture.
+    for (uint32_t resourceIndex : transients) {
+        RenderGraphResource* resource = &graph->resources[resourceIndex];
+        graph->stats.transientTextures++;
+        graph->stats.transientBytes += TextureBytes(resource->format, resource->width, resource->height);
+
+        uint32_t found = UINT32_MAX;
+        for (uint32_t i = 0; i < graph->textures.size() && found == UINT32_MAX; ++i) {
+            const RenderGraphTexture* texture = &graph->textures[i];
+            bool free = texture->lastUsedFrame != graph->frame || texture->busyUntil < resource->firstUse;
+            if (free && texture->format == resource->format && texture->width == resource->width &&
+                texture->height == resource->height && texture->usage == resource->usage) {
+                found = i;
+            }
+        }
+
+        if (found == UINT32_MAX) {
+            SDL_GPUTextureCreateInfo createInfo = {
+                .type = SDL_GPU_TEXTURETYPE_2D,
+                .format = resource->format,
+                .usage = resource->usage,
+                .width = resource->width,
+                .height = resource->height,
+                .layer_count_or_depth = 1,
+                .num_levels = 1,
+                .sample_count = SDL_GPU_SAMPLECOUNT_1,
+            };
+            SDL_GPUTexture* texture = SDL_CreateGPUTexture(GPUDevice, &createInfo);
+            if (texture == NULL) {
+                SDL_LogError(1, "Failed to create render graph texture %s! error: %s", resource->name, SDL_GetError());
+                return false;
+            }
+            graph->textures.push_back({
+                .texture = texture,
+                .format = resource->format,
+                .width = resource->width,
+                .height = resource->height,
+                .usage = resource->usage,
+            });
+            graph->stats.texturesCreated++;
+            found = (uint32_t)graph->textures.size() - 1;
+        }
+
+        RenderGraphTexture* texture = &graph->textures[found];
+        resource->cycleOnFirstUse = texture->lastUsedFrame != graph->frame;
+        if (resource->cycleOnFirstUse) {
+            graph->stats.physicalTextures++;
+            graph->stats.physicalBytes += TextureBytes(texture->format, texture->width, texture->height);
+        }
+        texture->lastUsedFrame = graph->frame;
+        texture->busyUntil = resource->output ? INT32_MAX : resource->lastUse;
+        resource->physicalTexture = found;
+        resource->texture = texture->texture;
+    }
+
+    // Drop textures nothing has asked for in a while; SDL keeps them alive for frames in flight
+    for (size_t i = graph->textures.size(); i-- > 0;) {
+        if (graph->frame - graph->textures[i].lastUsedFrame > RENDER_GRAPH_IDLE_FRAMES) {
+            SDL_ReleaseGPUTexture(GPUDevice, graph->textures[i].texture);
+            graph->textures.erase(graph->textures.begin() + i);
+        }
+    }
+    // Indices may have moved
+    for (RenderGraphResource& resource : graph->resources) {
+        if (resource.physicalTexture != UINT32_MAX) {
+            for (uint32_t i = 0; i < graph->textures.size(); ++i) {
+                if (graph->textures[i].texture == resource.texture) {
+                    resource.physicalTexture = i;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool CompileRenderGraph(SDL_GPUDevice* GPUDevice, RenderGraph* graph) {
+    uint64_t texturesCreated = graph->stats.texturesCreated;
+    graph->stats = { .texturesCreated = texturesCreated };
+    graph->stats.passes = (uint32_t)graph->passes.size();
+
+    if (!SortPasses(graph)) {
+        return false;
+    }
+    CullPasses(graph);
+    for (const RenderGraphPass& pass : graph->passes) {
+        graph->stats.culledPasses += !pass.alive;
+    }
+    DeriveLoadStoreOps(graph);
+    if (!AssignTextures(GPUDevice, graph)) {
+        return false;
+    }
+    graph->compiled = true;
+    return true;
+}
+
+static void ExecuteGraphicsPass(RenderGraph* graph, RenderGraphPass* pass, RenderGraphContext* context) {
+    SDL_GPUColorTargetInfo colorTargets[RENDER_GRAPH_MAX_COLOR_TARGETS];
+    SDL_GPUDepthStencilTargetInfo depthTarget;
+    uint32_t colorTargetCount = 0;
+    bool hasDepthTarget = false;
+    for (const RenderGraphAccess& access : pass->accesses) {
+        RenderGraphResource* resource = &graph->resources[access.resource];
+        bool target = access.kind == RENDER_GRAPH_ACCESS_COLOR_TARGET || access.kind == RENDER_GRAPH_ACCESS_DEPTH_TARGET;
+        // Nothing is kept from before, so a texture still in use by an earlier frame can be
+        // swapped out; aliases later in the frame hand the same texture on without cycling
+        bool cycle = target && resource->cycleOnFirstUse && access.loadOp != SDL_GPU_LOADOP_LOAD;
+        if (target) {
+            resource->cycleOnFirstUse = false;
+        }
+        if (access.kind == RENDER_GRAPH_ACCESS_COLOR_TARGET) {
+            SDL_assert(colorTargetCount < RENDER_GRAPH_MAX_COLOR_TARGETS);
+            colorTargets[colorTargetCount++] = {
+                .texture = resource->texture,
+                .mip_level = 0,
+                .layer_or_depth_plane = 0,
+                .clear_color = access.clearColor,
+                .load_op = access.loadOp,
+                .store_op = access.storeOp,
+                .cycle = cycle,
+            };
+        } else if (access.kind == RENDER_GRAPH_ACCESS_DEPTH_TARGET) {
+            depthTarget = {
+                .texture = resource->texture,
+                .clear_depth = access.clearDepth,
+                .load_op = access.loadOp,
+                .store_op = access.storeOp,
+                .stencil_load_op = SDL_GPU_LOADOP_DONT_CARE,
+                .stencil_store_op = SDL_GPU_STOREOP_DONT_CARE,
+                .cycle = cycle,
+                .clear_stencil = 0,
+            };
+            hasDepthTarget = true;
+        }
+    }
+
+    context->renderPass = SDL_BeginGPURenderPass(context->commandBuffer, colorTargets, colorTargetCount, hasDepthTarget ? &depthTarget : NULL);
+    pass->execute(context, pass->userData);
+    SDL_EndGPURenderPass(context->renderPass);
+}
+
+static void ExecuteComputePass(RenderGraph* graph, RenderGraphPass* pass, RenderGraphContext* context) {
+    std::vector<SDL_GPUStorageTextureReadWriteBinding> textureBindings;
+    std::vector<SDL_GPUStorageBufferReadWriteBinding> bufferBindings;
+    for (const RenderGraphAccess& access : pass->accesses) {
+        if (access.kind != RENDER_GRAPH_ACCESS_WRITE) {
+            continue;
+        }
+        const RenderGraphResource* resource = &graph->resources[access.resource];
+        if (resource->isTexture) {
+            textureBindings.push_back({ .texture = resource->texture, .mip_level = 0, .layer = 0, .cycle = false });
+        } else {
+            bufferBindings.push_back({ .buffer = resource->buffer, .cycle = false });
+        }
+    }
+
+    context->computePass = SDL_BeginGPUComputePass(
+        context->commandBuffer,
+        textureBindings.data(),
+        (Uint32)textureBindings.size(),
+        bufferBindings.data(),
+        (Uint32)bufferBindings.size()
+    );
+    pass->execute(context, pass->userData);
+    SDL_EndGPUComputePass(context->computePass);
+}
+
+void ExecuteRenderGraph(RenderGraph* graph, SDL_GPUCommandBuffer* commandBuffer) {
+    if (!graph->compiled) {
+        SDL_LogError(1, "ExecuteRenderGraph called without a successful CompileRenderGraph");
+        return;
+    }
+
+    for (uint32_t passIndex : graph->order) {
+        RenderGraphPass* pass = &graph->passes[passIndex];
+        if (!pass->alive) {
+            continue;
+        }
+
+        RenderGraphContext context = { .graph = graph, .commandBuffer = commandBuffer };
+        switch (pass->kind) {
+        case RENDER_GRAPH_PASS_GRAPHICS:
+            ExecuteGraphicsPass(graph, pass, &context);
+            break;
+        case RENDER_GRAPH_PASS_COMPUTE:
+            ExecuteComputePass(graph, pass, &context);
+            break;
+        case RENDER_GRAPH_PASS_COPY:
+            context.copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+            pass->execute(&context, pass->userData);
+            SDL_EndGPUCopyPass(context.copyPass);
+            break;
+        case RENDER_GRAPH_PASS_COMMANDS:
+            pass->execute(&context, pass->userData);
+            break;
+        }
+    }
+}
+
+SDL_GPUTexture* GetRenderGraphTexture(const RenderGraph* graph, RenderResource resource) {
+    return graph->resources[resource].texture;
+}
+
+SDL_GPUBuffer* GetRenderGraphBuffer(const RenderGraph* graph, RenderResource resource) {
+    return graph->resources[resource].buffer;
+}
+
+const RenderGraphStats* GetRenderGraphStats(const RenderGraph* graph) {
+    return &graph->stats;
+}
+
+void LogRenderGraphStats(const RenderGraph* graph) {
+    const RenderGraphStats* stats = &graph->stats;
+    SDL_Log(
+        "Render graph: %u passes (%u culled), %u transient textures in %u (%.1f of %.1f MB), %u loads and %u stores skipped, %llu textures created",
+        stats->passes,
+        stats->culledPasses,
+        stats->transientTextures,
+        stats->physicalTextures,
+        (double)stats->physicalBytes / (1024.0 * 1024.0),
+        (double)stats->transientBytes / (1024.0 * 1024.0),
+        stats->skippedLoads,
+        stats->skippedStores,
+        (unsigned long long)stats->texturesCreated
+    );
+}
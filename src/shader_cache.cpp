@@ -0,0 +1,264 @@
+#include "../include/shader_cache.hpp"
+#include "../include/embedded_shaders.hpp"
+#include <SDL3/SDL.h>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct ShaderFile {
+    uint64_t hash;
+    const uint8_t* code;
+    size_t codeSize;
+    // Empty for embedded shaders, their code points straight into the executable
+    std::vector<uint8_t> storage;
+};
+
+struct ShaderKey {
+    uint64_t codeHash;
+    SDL_GPUShaderStage stage;
+    uint32_t samplerCount;
+    uint32_t uniformBufferCount;
+    uint32_t storageBufferCount;
+    uint32_t storageTextureCount;
+
+    bool operator==(const ShaderKey& other) const = default;
+};
+
+struct ShaderKeyHash {
+    size_t operator()(const ShaderKey& key) const {
+        uint64_t h = key.codeHash;
+        h ^= (uint64_t)key.stage + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+        h ^= ((uint64_t)key.samplerCount << 48) | ((uint64_t)key.uniformBufferCount << 32) |
+             ((uint64_t)key.storageBufferCount << 16) | (uint64_t)key.storageTextureCount;
+        return (size_t)(h * 0xFF51AFD7ED558CCDull);
+    }
+};
+
+struct ShaderEntry {
+    ShaderKey key;
+    uint32_t refCount;
+};
+
+static std::unordered_map<std::string, ShaderFile> shaderFiles;
+static std::unordered_map<ShaderKey, SDL_GPUShader*, ShaderKeyHash> shadersByKey;
+static std::unordered_map<SDL_GPUShader*, ShaderEntry> shaderEntries;
+static ShaderCacheStats stats;
+// Shaders are loaded from the startup worker threads too. The lock only guards the maps: files
+// are read and shaders created without it, and whichever thread inserts second drops its copy.
+static std::mutex cacheMutex;
+
+static uint64_t HashBytes(const uint8_t* data, size_t size) {
+    // FNV-1a
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+#ifdef EMBED_SHADERS
+const EmbeddedShader* FindEmbeddedShader(const char* name) {
+    size_t low = 0;
+    size_t high = embeddedShaderCount;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        int order = SDL_strcmp(embeddedShaders[middle].name, name);
+        if (order == 0) {
+            return &embeddedShaders[middle];
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return NULL;
+}
+
+// ".../shaders/compiled/solidColor.frag.spv" -> "solidColor.frag"
+static const EmbeddedShader* FindEmbeddedShaderForPath(const char* filePath) {
+    const char* name = filePath;
+    for (const char* c = filePath; *c; ++c) {
+        if (*c == '/' || *c == '\\') {
+            name = c + 1;
+        }
+    }
+    char shaderName[256];
+    SDL_strlcpy(shaderName, name, sizeof(shaderName));
+    size_t length = SDL_strlen(shaderName);
+    if (length > 4 && SDL_strcmp(shaderName + length - 4, ".spv") == 0) {
+        shaderName[length - 4] = '\0';
+    }
+    return FindEmbeddedShader(shaderName);
+}
+#endif
+
+static const ShaderFile* LoadShaderFile(const char* filePath) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = shaderFiles.find(filePath);
+        if (found != shaderFiles.end()) {
+            return &found->second;
+        }
+    }
+
+    ShaderFile file = {};
+#ifdef EMBED_SHADERS
+    const EmbeddedShader* embedded = FindEmbeddedShaderForPath(filePath);
+    if (embedded == NULL) {
+        SDL_LogError(1, "Shader is not embedded in the executable! path: %s", filePath);
+        return NULL;
+    }
+    file.hash = HashBytes(embedded->code, embedded->codeSize);
+    file.code = embedded->code;
+    file.codeSize = embedded->codeSize;
+#else
+    size_t codeSize;
+    void* code = SDL_LoadFile(filePath, &codeSize);
+    if (code == NULL) {
+        SDL_LogError(1, "Failed to load shader from disk! path: %s    error: %s", filePath, SDL_GetError());
+        return NULL;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(code);
+    file.hash = HashBytes(bytes, codeSize);
+    file.storage.assign(bytes, bytes + codeSize);
+    file.codeSize = codeSize;
+    SDL_free(code);
+#endif
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    // Another thread may have read the same file meanwhile, its copy is kept
+    auto [inserted, isNew] = shaderFiles.try_emplace(filePath, std::move(file));
+#ifndef EMBED_SHADERS
+    stats.fileReads++;
+    if (isNew) {
+        inserted->second.code = inserted->second.storage.data();
+    }
+#endif
+    return &inserted->second;
+}
+
+static SDL_GPUShader* AcquireShaderWithHash(
+    SDL_GPUDevice* GPUDevice,
+    uint64_t codeHash,
+    const SDL_GPUShaderCreateInfo* createInfo
+) {
+    ShaderKey key = {
+        .codeHash = codeHash,
+        .stage = createInfo->stage,
+        .samplerCount = createInfo->num_samplers,
+        .uniformBufferCount = createInfo->num_uniform_buffers,
+        .storageBufferCount = createInfo->num_storage_buffers,
+        .storageTextureCount = createInfo->num_storage_textures,
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = shadersByKey.find(key);
+        if (found != shadersByKey.end()) {
+            stats.hits++;
+            shaderEntries[found->second].refCount++;
+            return found->second;
+        }
+    }
+
+    SDL_GPUShader* shader = SDL_CreateGPUShader(GPUDevice, createInfo);
+    if (shader == NULL) {
+        SDL_Log("Failed to create shader! error: %s", SDL_GetError());
+        return NULL;
+    }
+
+    SDL_GPUShader* existing = NULL;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto [found, isNew] = shadersByKey.try_emplace(key, shader);
+        if (isNew) {
+            stats.misses++;
+            shaderEntries[shader] = { .key = key, .refCount = 1 };
+            stats.liveShaders++;
+            return shader;
+        }
+        // Another thread created the same shader first, share its one
+        stats.hits++;
+        existing = found->second;
+        shaderEntries[existing].refCount++;
+    }
+    SDL_ReleaseGPUShader(GPUDevice, shader);
+    return existing;
+}
+
+SDL_GPUShader* AcquireShader(
+    SDL_GPUDevice* GPUDevice,
+    const char* filePath,
+    const SDL_GPUShaderCreateInfo* createInfo
+) {
+    const ShaderFile* file = LoadShaderFile(filePath);
+    if (file == NULL) {
+        return NULL;
+    }
+
+    SDL_GPUShaderCreateInfo shaderInfo = *createInfo;
+    shaderInfo.code = file->code;
+    shaderInfo.code_size = file->codeSize;
+    return AcquireShaderWithHash(GPUDevice, file->hash, &shaderInfo);
+}
+
+SDL_GPUShader* AcquireShaderFromCode(SDL_GPUDevice* GPUDevice, const SDL_GPUShaderCreateInfo* createInfo) {
+    return AcquireShaderWithHash(GPUDevice, HashBytes(createInfo->code, createInfo->code_size), createInfo);
+}
+
+const uint8_t* LoadShaderCode(const char* filePath, size_t* codeSize) {
+    const ShaderFile* file = LoadShaderFile(filePath);
+    if (file == NULL) {
+        return NULL;
+    }
+    *codeSize = file->codeSize;
+    return file->code;
+}
+
+void RetainShader(SDL_GPUShader* shader) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto found = shaderEntries.find(shader);
+    if (found == shaderEntries.end()) {
+        SDL_LogWarn(1, "RetainShader called with a shader that is not in the cache");
+        return;
+    }
+    found->second.refCount++;
+}
+
+void ReleaseShader(SDL_GPUDevice* GPUDevice, SDL_GPUShader* shader) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto found = shaderEntries.find(shader);
+    if (found == shaderEntries.end()) {
+        SDL_LogWarn(1, "ReleaseShader called with a shader that is not in the cache");
+        return;
+    }
+    if (--found->second.refCount > 0) {
+        return;
+    }
+
+    shadersByKey.erase(found->second.key);
+    shaderEntries.erase(found);
+    stats.liveShaders--;
+    SDL_ReleaseGPUShader(GPUDevice, shader);
+}
+
+void DestroyShaderCache(SDL_GPUDevice* GPUDevice) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (!shaderEntries.empty()) {
+        SDL_LogWarn(1, "Destroying shader cache with %zu shaders still referenced", shaderEntries.size());
+    }
+    for (auto& [shader, entry] : shaderEntries) {
+        SDL_ReleaseGPUShader(GPUDevice, shader);
+    }
+    shaderEntries.clear();
+    shadersByKey.clear();
+    shaderFiles.clear();
+    stats.liveShaders = 0;
+}
+
+const ShaderCacheStats* GetShaderCacheStats() {
+    return &stats;
+}
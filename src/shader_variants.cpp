@@ -0,0 +1,204 @@
+#include "../include/shader_variants.hpp"
+#include "../include/common.hpp"
+#include "../include/pipeline_cache.hpp"
+#include "../include/shader_cache.hpp"
+#include <SDL3/SDL.h>
+
+#define SPV_OP_DECORATE 71
+#define SPV_OP_SPEC_CONSTANT_TRUE 48
+#define SPV_OP_SPEC_CONSTANT_FALSE 49
+#define SPV_OP_SPEC_CONSTANT 50
+#define SPV_DECORATION_SPEC_ID 1
+#define SPV_HEADER_WORDS 5
+
+uint32_t SpecializeSPIRV(uint32_t* words, size_t wordCount, uint32_t specBits, uint32_t specConstantCount) {
+    std::unordered_map<uint32_t, uint32_t> specIds;
+    for (size_t i = SPV_HEADER_WORDS; i < wordCount;) {
+        uint32_t op = words[i] & 0xFFFF;
+        uint32_t count = words[i] >> 16;
+        if (count == 0 || i + count > wordCount) {
+            break;
+        }
+        if (op == SPV_OP_DECORATE && count >= 4 && words[i + 2] == SPV_DECORATION_SPEC_ID) {
+            specIds[words[i + 1]] = words[i + 3];
+        }
+        i += count;
+    }
+
+    uint32_t patched = 0;
+    for (size_t i = SPV_HEADER_WORDS; i < wordCount;) {
+        uint32_t op = words[i] & 0xFFFF;
+        uint32_t count = words[i] >> 16;
+        if (count == 0 || i + count > wordCount) {
+            break;
+        }
+
+        bool isBool = op == SPV_OP_SPEC_CONSTANT_TRUE || op == SPV_OP_SPEC_CONSTANT_FALSE;
+        if ((isBool || op == SPV_OP_SPEC_CONSTANT) && count >= 3) {
+            auto found = specIds.find(words[i + 2]);
+            if (found != specIds.end() && found->second < specConstantCount) {
+                bool enabled = (specBits >> found->second) & 1;
+                if (isBool) {
+                    words[i] = (count << 16) | (enabled ? SPV_OP_SPEC_CONSTANT_TRUE : SPV_OP_SPEC_CONSTANT_FALSE);
+                } else if (count >= 4) {
+                    words[i + 3] = enabled;
+                }
+                patched++;
+            }
+        }
+        i += count;
+    }
+    return patched;
+}
+
+SDL_GPUShader* LoadShaderVariant(SDL_GPUDevice* GPUDevice, const std::string& fileName, uint32_t variantMask) {
+    const ShaderVariantInfo* info = FindShaderVariantInfo(fileName);
+    if (info == NULL) {
+        if (variantMask != 0) {
+            SDL_LogError(1, "Shader %s has no permutations, asked for variant %u", fileName.c_str(), variantMask);
+            return NULL;
+        }
+        return LoadShader(GPUDevice, fileName);
+    }
+
+    uint32_t defineMask = (1u << info->defineCount) - 1;
+    uint32_t defineBits = variantMask & defineMask;
+    uint32_t specBits = variantMask >> info->defineCount;
+
+    std::string variantName = fileName;
+    if (defineBits != 0) {
+        variantName += "." + std::to_string(defineBits);
+    }
+
+    char fullPath[256];
+    SDL_GPUShaderCreateInfo shaderInfo;
+    if (!GetShaderCreateInfo(GPUDevice, variantName, &shaderInfo, fullPath, sizeof(fullPath))) {
+        return NULL;
+    }
+    if (info->specConstantCount == 0) {
+        return AcquireShader(GPUDevice, fullPath, &shaderInfo);
+    }
+
+    size_t codeSize;
+    const uint8_t* code = LoadShaderCode(fullPath, &codeSize);
+    if (code == NULL) {
+        return NULL;
+    }
+
+    std::vector<uint32_t> words(codeSize / sizeof(uint32_t));
+    SDL_memcpy(words.data(), code, words.size() * sizeof(uint32_t));
+    uint32_t patched = SpecializeSPIRV(words.data(), words.size(), specBits, info->specConstantCount);
+    if (patched < info->specConstantCount) {
+        SDL_LogWarn(
+            1,
+            "%s declares %u specialization constants but only %u were found, is the .spv out of date?",
+            variantName.c_str(),
+            info->specConstantCount,
+            patched
+        );
+    }
+
+    shaderInfo.code = reinterpret_cast<const uint8_t*>(words.data());
+    shaderInfo.code_size = words.size() * sizeof(uint32_t);
+    return AcquireShaderFromCode(GPUDevice, &shaderInfo);
+}
+
+void InitGraphicsPipelineVariants(
+    GraphicsPipelineVariants* variants,
+    const std::string& vertexShader,
+    const std::string& fragmentShader,
+    const SDL_GPUGraphicsPipelineCreateInfo* createInfo
+) {
+    const SDL_GPUVertexInputState* vertexInput = &createInfo->vertex_input_state;
+    const SDL_GPUGraphicsPipelineTargetInfo* targets = &createInfo->target_info;
+
+    variants->vertexShader = vertexShader;
+    variants->fragmentShader = fragmentShader;
+    variants->vertexBuffers.assign(
+        vertexInput->vertex_buffer_descriptions,
+        vertexInput->vertex_buffer_descriptions + vertexInput->num_vertex_buffers
+    );
+    variants->vertexAttributes.assign(
+        vertexInput->vertex_attributes,
+        vertexInput->vertex_attributes + vertexInput->num_vertex_attributes
+    );
+    variants->colorTargets.assign(
+        targets->color_target_descriptions,
+        targets->color_target_descriptions + targets->num_color_targets
+    );
+
+    variants->createInfo = *createInfo;
+    variants->createInfo.vertex_shader = NULL;
+    variants->createInfo.fragment_shader = NULL;
+    variants->createInfo.vertex_input_state.vertex_buffer_descriptions = variants->vertexBuffers.data();
+    variants->createInfo.vertex_input_state.vertex_attributes = variants->vertexAttributes.data();
+    variants->createInfo.target_info.color_target_descriptions = variants->colorTargets.data();
+    variants->pipelines.clear();
+}
+
+static uint32_t VariantKey(uint16_t vertexMask, uint16_t fragmentMask) {
+    return ((uint32_t)vertexMask << 16) | fragmentMask;
+}
+
+SDL_GPUGraphicsPipeline* CreateGraphicsPipelineVariant(
+    SDL_GPUDevice* GPUDevice,
+    const GraphicsPipelineVariants* variants,
+    uint16_t vertexMask,
+    uint16_t fragmentMask
+) {
+    SDL_GPUGraphicsPipeline* pipeline = NULL;
+    SDL_GPUShader* vertexShader = LoadShaderVariant(GPUDevice, variants->vertexShader, vertexMask);
+    SDL_GPUShader* fragmentShader = LoadShaderVariant(GPUDevice, variants->fragmentShader, fragmentMask);
+    if (vertexShader != NULL && fragmentShader != NULL) {
+        SDL_GPUGraphicsPipelineCreateInfo createInfo = variants->createInfo;
+        createInfo.vertex_shader = vertexShader;
+        createInfo.fragment_shader = fragmentShader;
+        pipeline = AcquireGraphicsPipeline(GPUDevice, &createInfo);
+    }
+    if (vertexShader != NULL) {
+        ReleaseShader(GPUDevice, vertexShader);
+    }
+    if (fragmentShader != NULL) {
+        ReleaseShader(GPUDevice, fragmentShader);
+    }
+    return pipeline;
+}
+
+void SetGraphicsPipelineVariant(
+    SDL_GPUDevice* GPUDevice,
+    GraphicsPipelineVariants* variants,
+    uint16_t vertexMask,
+    uint16_t fragmentMask,
+    SDL_GPUGraphicsPipeline* pipeline
+) {
+    auto [entry, inserted] = variants->pipelines.try_emplace(VariantKey(vertexMask, fragmentMask), pipeline);
+    if (!inserted && pipeline != NULL) {
+        ReleaseGraphicsPipeline(GPUDevice, pipeline);
+    }
+}
+
+SDL_GPUGraphicsPipeline* GetGraphicsPipelineVariant(
+    SDL_GPUDevice* GPUDevice,
+    GraphicsPipelineVariants* variants,
+    uint16_t vertexMask,
+    uint16_t fragmentMask
+) {
+    auto found = variants->pipelines.find(VariantKey(vertexMask, fragmentMask));
+    if (found != variants->pipelines.end()) {
+        return found->second;
+    }
+
+    // Failures are remembered as NULL too, so a missing variant is reported once, not every frame
+    SDL_GPUGraphicsPipeline* pipeline = CreateGraphicsPipelineVariant(GPUDevice, variants, vertexMask, fragmentMask);
+    variants->pipelines[VariantKey(vertexMask, fragmentMask)] = pipeline;
+    return pipeline;
+}
+
+void ReleaseGraphicsPipelineVariants(SDL_GPUDevice* GPUDevice, GraphicsPipelineVariants* variants) {
+    for (auto& [key, pipeline] : variants->pipelines) {
+        if (pipeline != NULL) {
+            ReleaseGraphicsPipeline(GPUDevice, pipeline);
+        }
+    }
+    variants->pipelines.clear();
+}
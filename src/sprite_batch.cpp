@@ -0,0 +1,222 @@
+#include "../include/sprite_batch.hpp"
+#include "../include/pipeline_cache.hpp"
+#include "../include/shader_cache.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstddef>
+#include <unordered_map>
+
+struct SpriteUniforms {
+    Matrix4x4 viewProjection;
+    uint32_t firstSprite;
+    uint32_t padding[3];
+};
+
+static_assert(sizeof(SpriteInstance) == 64 && offsetof(SpriteInstance, u) == 32 && offsetof(SpriteInstance, r) == 48);
+static_assert(UniformBlock<SpriteInstance>);
+
+CHECK_UNIFORM_BLOCK_IF_BUILT(
+    SpriteUniforms,
+    "sprite.vert",
+    0,
+    UNIFORM_MEMBER(SpriteUniforms, viewProjection),
+    UNIFORM_MEMBER(SpriteUniforms, firstSprite)
+);
+
+bool CreateSpriteBatch(
+    SDL_GPUDevice* GPUDevice,
+    SpriteBatch* batch,
+    UniformArena* arena,
+    SDL_GPUTextureFormat colorTargetFormat
+) {
+    *batch = {};
+    batch->arena = arena;
+
+    SDL_GPUShader* vertexShader = LoadShader(GPUDevice, "sprite.vert");
+    SDL_GPUShader* fragmentShader = LoadShader(GPUDevice, "sprite.frag");
+    if (vertexShader != NULL && fragmentShader != NULL) {
+        SDL_GPUColorTargetDescription colorTargetDescription[] = {{
+            .format = colorTargetFormat,
+            .blend_state = {
+                .src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+                .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                .color_blend_op = SDL_GPU_BLENDOP_ADD,
+                .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+                .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+                .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
+                .enable_blend = true,
+            },
+        }};
+
+        // No vertex input, the corners come from SV_VertexID
+        SDL_GPUGraphicsPipelineCreateInfo createInfo = {
+            .vertex_shader = vertexShader,
+            .fragment_shader = fragmentShader,
+            .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+            .target_info = {
+                .color_target_descriptions = colorTargetDescription,
+                .num_color_targets = 1,
+            },
+        };
+        batch->pipeline = AcquireGraphicsPipeline(GPUDevice, &createInfo);
+    }
+    if (vertexShader != NULL) {
+        ReleaseShader(GPUDevice, vertexShader);
+    }
+    if (fragmentShader != NULL) {
+        ReleaseShader(GPUDevice, fragmentShader);
+    }
+    if (batch->pipeline == NULL) {
+        SDL_LogError(1, "Failed to create sprite pipeline");
+        return false;
+    }
+
+    SDL_GPUSamplerCreateInfo samplerInfo = {
+        .min_filter = SDL_GPU_FILTER_LINEAR,
+        .mag_filter = SDL_GPU_FILTER_LINEAR,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+    };
+    batch->sampler = SDL_CreateGPUSampler(GPUDevice, &samplerInfo);
+    if (batch->sampler == NULL) {
+        SDL_LogError(1, "Failed to create sprite sampler! error: %s", SDL_GetError());
+        DestroySpriteBatch(GPUDevice, batch);
+        return false;
+    }
+    return true;
+}
+
+void DestroySpriteBatch(SDL_GPUDevice* GPUDevice, SpriteBatch* batch) {
+    if (batch->pipeline != NULL) {
+        ReleaseGraphicsPipeline(GPUDevice, batch->pipeline);
+    }
+    if (batch->sampler != NULL) {
+        SDL_ReleaseGPUSampler(GPUDevice, batch->sampler);
+    }
+    *batch = {};
+}
+
+void BeginSprites(SpriteBatch* batch) {
+    batch->sprites.clear();
+    batch->spriteTextures.clear();
+    batch->draws.clear();
+    batch->stats.frameSprites = 0;
+    batch->stats.frameDraws = 0;
+}
+
+void DrawSprite(SpriteBatch* batch, SDL_GPUTexture* texture, const SpriteInstance* sprite) {
+    batch->sprites.push_back(*sprite);
+    batch->spriteTextures.push_back(texture);
+}
+
+bool UploadSprites(SDL_GPUDevice* GPUDevice, SpriteBatch* batch, UploadQueue* uploadQueue) {
+    uint32_t spriteCount = (uint32_t)batch->sprites.size();
+    if (spriteCount == 0) {
+        return true;
+    }
+
+    // Sprites are drawn in ascending z, and only sprites on the same z are grouped by texture.
+    // Textures within a layer keep their order of first use, and so do the sprites of one texture.
+    std::unordered_map<SDL_GPUTexture*, uint32_t> textureOrder;
+    std::vector<uint32_t> spriteTextureOrder(spriteCount);
+    std::vector<uint32_t> order(spriteCount);
+    for (uint32_t i = 0; i < spriteCount; ++i) {
+        auto found = textureOrder.try_emplace(batch->spriteTextures[i], (uint32_t)textureOrder.size()).first;
+        spriteTextureOrder[i] = found->second;
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        float zA = batch->sprites[a].z;
+        float zB = batch->sprites[b].z;
+        if (zA != zB) {
+            return zA < zB;
+        }
+        return spriteTextureOrder[a] < spriteTextureOrder[b];
+    });
+
+    uint32_t firstSprite;
+    SpriteInstance* instances = static_cast<SpriteInstance*>(UniformArenaAllocArray(
+        GPUDevice,
+        batch->arena,
+        uploadQueue,
+        sizeof(SpriteInstance),
+        spriteCount,
+        &firstSprite
+    ));
+    if (instances == NULL) {
+        SDL_LogError(1, "Uniform arena is out of space for %u sprites", spriteCount);
+        return false;
+    }
+
+    // A new draw starts wherever the texture changes in the sorted order
+    for (uint32_t i = 0; i < spriteCount; ++i) {
+        SDL_GPUTexture* texture = batch->spriteTextures[order[i]];
+        if (batch->draws.empty() || batch->draws.back().texture != texture) {
+            batch->draws.push_back({ .texture = texture, .firstSprite = firstSprite + i, .spriteCount = 0 });
+        }
+        batch->draws.back().spriteCount++;
+        instances[i] = batch->sprites[order[i]];
+    }
+    return true;
+}
+
+void RenderSprites(
+    SpriteBatch* batch,
+    SDL_GPUCommandBuffer* commandBuffer,
+    SDL_GPURenderPass* renderPass,
+    const Matrix4x4* viewProjection
+) {
+    if (batch->draws.empty()) {
+        return;
+    }
+
+    SDL_BindGPUGraphicsPipeline(renderPass, batch->pipeline);
+    SDL_GPUBuffer* instanceBuffer = GetUniformArenaBuffer(batch->arena);
+    SDL_BindGPUVertexStorageBuffers(renderPass, 0, &instanceBuffer, 1);
+
+    SpriteUniforms uniforms = { .viewProjection = *viewProjection };
+    for (const SpriteDraw& draw : batch->draws) {
+        SDL_GPUTextureSamplerBinding textureBinding = {
+            .texture = draw.texture,
+            .sampler = batch->sampler,
+        };
+        SDL_BindGPUFragmentSamplers(renderPass, 0, &textureBinding, 1);
+
+        uniforms.firstSprite = draw.firstSprite;
+        SDL_PushGPUVertexUniformData(commandBuffer, 0, &uniforms, sizeof(uniforms));
+        SDL_DrawGPUPrimitives(renderPass, 6, draw.spriteCount, 0, 0);
+
+        batch->stats.frameDraws++;
+        batch->stats.frameSprites += draw.spriteCount;
+    }
+
+    batch->stats.peakFrameSprites = SDL_max(batch->stats.peakFrameSprites, batch->stats.frameSprites);
+    batch->stats.totalSprites += batch->sprites.size();
+    batch->stats.totalDraws += batch->draws.size();
+}
+
+const SpriteBatchStats* GetSpriteBatchStats(const SpriteBatch* batch) {
+    return &batch->stats;
+}
+
+float SpritesPerDraw(const SpriteBatchStats* stats) {
+    if (stats->frameDraws == 0) {
+        return 0.0f;
+    }
+    return (float)stats->frameSprites / (float)stats->frameDraws;
+}
+
+void LogSpriteBatchStats(const SpriteBatch* batch) {
+    const SpriteBatchStats* stats = &batch->stats;
+    SDL_Log(
+        "Sprites: %u sprites in %u draws (%.1f per draw), peak %u per frame, %llu sprites in %llu draws total",
+        stats->frameSprites,
+        stats->frameDraws,
+        SpritesPerDraw(stats),
+        stats->peakFrameSprites,
+        (unsigned long long)stats->totalSprites,
+        (unsigned long long)stats->totalDraws
+    );
+}
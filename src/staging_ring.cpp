@@ -0,0 +1,167 @@
+#include "../include/staging_ring.hpp"
+#include <SDL3/SDL.h>
+
+#define STAGING_REGION_ALIGNMENT 256
+
+bool CreateStagingRing(SDL_GPUDevice* GPUDevice, StagingRing* ring, uint32_t regionSize, uint32_t framesInFlight) {
+    *ring = {};
+    if (framesInFlight == 0 || framesInFlight > STAGING_RING_MAX_FRAMES) {
+        SDL_LogError(1, "Staging ring supports 1 to %d frames in flight, got %u", STAGING_RING_MAX_FRAMES, framesInFlight);
+        return false;
+    }
+
+    ring->regionSize = (regionSize + STAGING_REGION_ALIGNMENT - 1) & ~(uint32_t)(STAGING_REGION_ALIGNMENT - 1);
+    ring->framesInFlight = framesInFlight;
+
+    SDL_GPUTransferBufferCreateInfo createInfo = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = ring->regionSize * framesInFlight,
+    };
+    ring->transferBuffer = SDL_CreateGPUTransferBuffer(GPUDevice, &createInfo);
+    if (ring->transferBuffer == NULL) {
+        SDL_LogError(1, "Failed to create staging transfer buffer! error: %s", SDL_GetError());
+        return false;
+    }
+
+    // BeginStagingFrame advances first, so the first frame lands in region 0
+    ring->frameIndex = framesInFlight - 1;
+    return true;
+}
+
+void DestroyStagingRing(SDL_GPUDevice* GPUDevice, StagingRing* ring) {
+    if (ring->mapped != NULL) {
+        SDL_UnmapGPUTransferBuffer(GPUDevice, ring->transferBuffer);
+    }
+    for (uint32_t i = 0; i < ring->framesInFlight; ++i) {
+        if (ring->fences[i] != NULL) {
+            SDL_WaitForGPUFences(GPUDevice, true, &ring->fences[i], 1);
+            SDL_ReleaseGPUFence(GPUDevice, ring->fences[i]);
+        }
+    }
+    SDL_ReleaseGPUTransferBuffer(GPUDevice, ring->transferBuffer);
+    *ring = {};
+}
+
+static void CountGPUBusy(StagingRing* ring, uint32_t region, Uint64 completeNS) {
+    Uint64 startNS = SDL_max(ring->submitNS[region], ring->lastCompleteNS);
+    if (completeNS > startNS) {
+        ring->stats.gpuBusyNS += completeNS - startNS;
+    }
+    ring->lastCompleteNS = completeNS;
+    ring->submitNS[region] = 0;
+}
+
+bool BeginStagingFrame(SDL_GPUDevice* GPUDevice, StagingRing* ring) {
+    ring->frameIndex = (ring->frameIndex + 1) % ring->framesInFlight;
+    ring->head = 0;
+    ring->stats.frameBytes = 0;
+
+    SDL_GPUFence*& fence = ring->fences[ring->frameIndex];
+    if (fence == NULL) {
+        return true;
+    }
+
+    if (!SDL_QueryGPUFence(GPUDevice, fence)) {
+        Uint64 start = SDL_GetTicksNS();
+        if (!SDL_WaitForGPUFences(GPUDevice, true, &fence, 1)) {
+            SDL_LogError(1, "Failed to wait for staging fence! error: %s", SDL_GetError());
+            return false;
+        }
+        ring->stats.fenceWaits++;
+        ring->stats.fenceWaitNS += SDL_GetTicksNS() - start;
+    }
+    Uint64 now = SDL_GetTicksNS();
+    if (ring->submitNS[ring->frameIndex] != 0) {
+        CountGPUBusy(ring, ring->frameIndex, now);
+    }
+
+    // The newer submissions complete in order, stop at the first one still running
+    for (uint32_t i = 1; i < ring->framesInFlight; ++i) {
+        uint32_t region = (ring->frameIndex + i) % ring->framesInFlight;
+        if (ring->fences[region] == NULL || ring->submitNS[region] == 0) {
+            continue;
+        }
+        if (!SDL_QueryGPUFence(GPUDevice, ring->fences[region])) {
+            break;
+        }
+        CountGPUBusy(ring, region, now);
+    }
+
+    SDL_ReleaseGPUFence(GPUDevice, fence);
+    fence = NULL;
+    return true;
+}
+
+bool StagingAlloc(
+    SDL_GPUDevice* GPUDevice,
+    StagingRing* ring,
+    uint32_t size,
+    uint32_t alignment,
+    StagingAllocation* allocation
+) {
+    uint32_t offset = (ring->head + alignment - 1) & ~(alignment - 1);
+    if (offset > ring->regionSize || size > ring->regionSize - offset) {
+        ring->stats.failedAllocations++;
+        SDL_LogError(1, "Staging region full: %u of %u bytes used, %u requested", ring->head, ring->regionSize, size);
+        return false;
+    }
+
+    if (ring->mapped == NULL) {
+        // No cycling: the fences already guarantee this region is not read by the GPU anymore,
+        // and cycling would swap in a fresh buffer behind the other regions still in flight.
+        ring->mapped = static_cast<uint8_t*>(SDL_MapGPUTransferBuffer(GPUDevice, ring->transferBuffer, false));
+        if (ring->mapped == NULL) {
+            SDL_LogError(1, "Failed to map staging transfer buffer! error: %s", SDL_GetError());
+            return false;
+        }
+    }
+
+    uint32_t bufferOffset = ring->frameIndex * ring->regionSize + offset;
+    *allocation = {
+        .data = ring->mapped + bufferOffset,
+        .transferBuffer = ring->transferBuffer,
+        .offset = bufferOffset,
+        .size = size,
+    };
+
+    ring->head = offset + size;
+    ring->stats.frameBytes = ring->head;
+    if (ring->head > ring->stats.peakFrameBytes) {
+        ring->stats.peakFrameBytes = ring->head;
+    }
+    return true;
+}
+
+void EndStagingWrites(SDL_GPUDevice* GPUDevice, StagingRing* ring) {
+    if (ring->mapped != NULL) {
+        SDL_UnmapGPUTransferBuffer(GPUDevice, ring->transferBuffer);
+        ring->mapped = NULL;
+    }
+}
+
+bool SubmitStagingFrame(SDL_GPUDevice* GPUDevice, StagingRing* ring, SDL_GPUCommandBuffer* commandBuffer) {
+    EndStagingWrites(GPUDevice, ring);
+
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+    if (fence == NULL) {
+        SDL_LogError(1, "Failed to submit staging command buffer! error: %s", SDL_GetError());
+        return false;
+    }
+    // A second submit in the same frame replaces the fence; command buffers complete in
+    // submission order, so the newer one covers both
+    SDL_GPUFence*& frameFence = ring->fences[ring->frameIndex];
+    if (frameFence != NULL) {
+        SDL_ReleaseGPUFence(GPUDevice, frameFence);
+    } else {
+        ring->submitNS[ring->frameIndex] = SDL_GetTicksNS();
+    }
+    frameFence = fence;
+    return true;
+}
+
+SDL_GPUTransferBufferLocation StagingLocation(const StagingAllocation* allocation) {
+    return {
+        .transfer_buffer = allocation->transferBuffer,
+        .offset = allocation->offset,
+    };
+}
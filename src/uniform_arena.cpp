@@ -0,0 +1,99 @@
+#include "../include/uniform_arena.hpp"
+#include <SDL3/SDL.h>
+
+bool CreateUniformArena(
+    SDL_GPUDevice* GPUDevice,
+    UniformArena* arena,
+    uint32_t capacity,
+    uint32_t framesInFlight,
+    SDL_GPUBufferUsageFlags usage
+) {
+    *arena = {};
+    if (framesInFlight == 0 || framesInFlight > STAGING_RING_MAX_FRAMES) {
+        SDL_LogError(1, "Uniform arena supports 1 to %d frames in flight, got %u", STAGING_RING_MAX_FRAMES, framesInFlight);
+        return false;
+    }
+
+    arena->capacity = (capacity + 15) & ~15u;
+    arena->framesInFlight = framesInFlight;
+    for (uint32_t i = 0; i < framesInFlight; ++i) {
+        SDL_GPUBufferCreateInfo createInfo = {
+            .usage = usage,
+            .size = arena->capacity,
+        };
+        arena->buffers[i] = SDL_CreateGPUBuffer(GPUDevice, &createInfo);
+        if (arena->buffers[i] == NULL) {
+            SDL_LogError(1, "Failed to create uniform arena buffer! error: %s", SDL_GetError());
+            DestroyUniformArena(GPUDevice, arena);
+            return false;
+        }
+    }
+
+    // BeginUniformFrame advances first, so the first frame uses buffer 0
+    arena->frameIndex = framesInFlight - 1;
+    return true;
+}
+
+void DestroyUniformArena(SDL_GPUDevice* GPUDevice, UniformArena* arena) {
+    for (uint32_t i = 0; i < arena->framesInFlight; ++i) {
+        if (arena->buffers[i] != NULL) {
+            SDL_ReleaseGPUBuffer(GPUDevice, arena->buffers[i]);
+        }
+    }
+    *arena = {};
+}
+
+void BeginUniformFrame(UniformArena* arena) {
+    arena->frameIndex = (arena->frameIndex + 1) % arena->framesInFlight;
+    arena->head = 0;
+    arena->chunk = NULL;
+    arena->chunkStart = 0;
+    arena->chunkEnd = 0;
+    arena->stats.frameBlocks = 0;
+    arena->stats.frameBytes = 0;
+}
+
+void* UniformArenaAllocArray(
+    SDL_GPUDevice* GPUDevice,
+    UniformArena* arena,
+    UploadQueue* uploadQueue,
+    uint32_t elementSize,
+    uint32_t count,
+    uint32_t* firstIndex
+) {
+    // Elements of different sizes share the buffer, each array starts on a multiple of its
+    // element size so the shader can address it as element offset / element size
+    uint32_t offset = elementSize == 0 ? 0 : (arena->head + elementSize - 1) / elementSize * elementSize;
+    uint64_t size = (uint64_t)elementSize * count;
+    if (size == 0 || offset + size > arena->capacity) {
+        arena->stats.failedAllocations++;
+        return NULL;
+    }
+
+    if (arena->chunk == NULL || offset + size > arena->chunkEnd) {
+        uint32_t chunkSize = (uint32_t)SDL_min(SDL_max(size, (uint64_t)UNIFORM_ARENA_CHUNK_SIZE), (uint64_t)(arena->capacity - offset));
+        void* chunk = QueueBufferWrite(GPUDevice, uploadQueue, arena->buffers[arena->frameIndex], offset, chunkSize);
+        if (chunk == NULL) {
+            arena->stats.failedAllocations++;
+            return NULL;
+        }
+        arena->chunk = static_cast<uint8_t*>(chunk);
+        arena->chunkStart = offset;
+        arena->chunkEnd = offset + chunkSize;
+    }
+
+    arena->head = offset + (uint32_t)size;
+    arena->stats.frameBlocks += count;
+    arena->stats.frameBytes = arena->head;
+    arena->stats.peakFrameBytes = SDL_max(arena->stats.peakFrameBytes, arena->head);
+    *firstIndex = offset / elementSize;
+    return arena->chunk + (offset - arena->chunkStart);
+}
+
+void* UniformArenaAlloc(SDL_GPUDevice* GPUDevice, UniformArena* arena, UploadQueue* uploadQueue, uint32_t size, uint32_t* index) {
+    return UniformArenaAllocArray(GPUDevice, arena, uploadQueue, size, 1, index);
+}
+
+SDL_GPUBuffer* GetUniformArenaBuffer(const UniformArena* arena) {
+    return arena->buffers[arena->frameIndex];
+}
@@ -0,0 +1,233 @@
+#include "../include/upload_queue.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+
+#define BUFFER_UPLOAD_ALIGNMENT 4
+#define TEXTURE_UPLOAD_ALIGNMENT 16
+
+void InitUploadQueue(UploadQueue* queue, StagingRing* ring) {
+    queue->ring = ring;
+    queue->bufferUploads.clear();
+    queue->textureUploads.clear();
+    queue->flushed = false;
+    queue->stats = {};
+}
+
+bool BeginUploadFrame(SDL_GPUDevice* GPUDevice, UploadQueue* queue) {
+    if (!queue->bufferUploads.empty() || !queue->textureUploads.empty()) {
+        SDL_LogError(1, "Dropping %zu uploads that were never flushed", queue->bufferUploads.size() + queue->textureUploads.size());
+        queue->bufferUploads.clear();
+        queue->textureUploads.clear();
+    }
+    queue->flushed = false;
+    queue->stats.frameUploads = 0;
+    queue->stats.frameCopyCommands = 0;
+    queue->stats.frameCopyPasses = 0;
+    queue->stats.frameBytes = 0;
+    return BeginStagingFrame(GPUDevice, queue->ring);
+}
+
+void* QueueBufferWrite(SDL_GPUDevice* GPUDevice, UploadQueue* queue, SDL_GPUBuffer* buffer, uint32_t offset, uint32_t size) {
+    if (queue->flushed) {
+        // The staging memory would be read by a later frame than the one fencing it
+        SDL_LogError(1, "Buffer upload queued after FlushUploads, wait for the next frame");
+        return NULL;
+    }
+
+    StagingAllocation allocation;
+    if (!StagingAlloc(GPUDevice, queue->ring, size, BUFFER_UPLOAD_ALIGNMENT, &allocation)) {
+        return NULL;
+    }
+
+    queue->bufferUploads.push_back({
+        .transferBuffer = allocation.transferBuffer,
+        .transferOffset = allocation.offset,
+        .buffer = buffer,
+        .offset = offset,
+        .size = size,
+        .sequence = (uint32_t)queue->bufferUploads.size(),
+    });
+    queue->stats.frameUploads++;
+    queue->stats.frameBytes += size;
+    queue->stats.totalUploads++;
+    return allocation.data;
+}
+
+bool QueueBufferUpload(
+    SDL_GPUDevice* GPUDevice,
+    UploadQueue* queue,
+    SDL_GPUBuffer* buffer,
+    uint32_t offset,
+    const void* data,
+    uint32_t size
+) {
+    void* staging = QueueBufferWrite(GPUDevice, queue, buffer, offset, size);
+    if (staging == NULL) {
+        return false;
+    }
+    SDL_memcpy(staging, data, size);
+    return true;
+}
+
+bool QueueTextureUpload(
+    SDL_GPUDevice* GPUDevice,
+    UploadQueue* queue,
+    const SDL_GPUTextureRegion* region,
+    const void* pixels,
+    uint32_t bytesPerPixel,
+    uint32_t pitch
+) {
+    if (queue->flushed) {
+        SDL_LogError(1, "Texture upload queued after FlushUploads, wait for the next frame");
+        return false;
+    }
+
+    uint32_t rowSize = region->w * bytesPerPixel;
+    uint32_t rowCount = region->h * region->d;
+    StagingAllocation allocation;
+    if (!StagingAlloc(GPUDevice, queue->ring, rowSize * rowCount, TEXTURE_UPLOAD_ALIGNMENT, &allocation)) {
+        return false;
+    }
+
+    // Rows are packed tightly so pixels_per_row is simply the region width
+    const uint8_t* source = static_cast<const uint8_t*>(pixels);
+    uint8_t* destination = static_cast<uint8_t*>(allocation.data);
+    if (pitch == rowSize) {
+        SDL_memcpy(destination, source, allocation.size);
+    } else {
+        for (uint32_t row = 0; row < rowCount; ++row) {
+            SDL_memcpy(destination + row * rowSize, source + (size_t)row * pitch, rowSize);
+        }
+    }
+
+    queue->textureUploads.push_back({
+        .transferBuffer = allocation.transferBuffer,
+        .transferOffset = allocation.offset,
+        .size = allocation.size,
+        .region = *region,
+    });
+    queue->stats.frameUploads++;
+    queue->stats.frameBytes += allocation.size;
+    queue->stats.totalUploads++;
+    return true;
+}
+
+// Sorts by destination so neighbouring writes can merge. A buffer whose uploads overlap
+// keeps submission order instead, since the later write has to win.
+static void SortBufferUploads(std::vector<BufferUpload>& uploads) {
+    std::stable_sort(uploads.begin(), uploads.end(), [](const BufferUpload& a, const BufferUpload& b) {
+        if (a.buffer != b.buffer) {
+            return a.buffer < b.buffer;
+        }
+        return a.offset < b.offset;
+    });
+
+    size_t groupStart = 0;
+    while (groupStart < uploads.size()) {
+        size_t groupEnd = groupStart + 1;
+        bool overlaps = false;
+        uint32_t end = uploads[groupStart].offset + uploads[groupStart].size;
+        while (groupEnd < uploads.size() && uploads[groupEnd].buffer == uploads[groupStart].buffer) {
+            overlaps |= uploads[groupEnd].offset < end;
+            end = SDL_max(end, uploads[groupEnd].offset + uploads[groupEnd].size);
+            groupEnd++;
+        }
+        if (overlaps) {
+            std::sort(uploads.begin() + groupStart, uploads.begin() + groupEnd, [](const BufferUpload& a, const BufferUpload& b) {
+                return a.sequence < b.sequence;
+            });
+        }
+        groupStart = groupEnd;
+    }
+}
+
+static bool CanMerge(const BufferUpload& current, const BufferUpload& next) {
+    return next.buffer == current.buffer &&
+           next.transferBuffer == current.transferBuffer &&
+           next.offset == current.offset + current.size &&
+           next.transferOffset == current.transferOffset + current.size;
+}
+
+// Vertically adjacent strips of the same texture subresource, staged back to back
+static bool CanMerge(const TextureUpload& current, const TextureUpload& next) {
+    const SDL_GPUTextureRegion& a = current.region;
+    const SDL_GPUTextureRegion& b = next.region;
+    return b.texture == a.texture && b.mip_level == a.mip_level && b.layer == a.layer &&
+           a.d == 1 && b.d == 1 && b.z == a.z &&
+           b.x == a.x && b.w == a.w && b.y == a.y + a.h &&
+           next.transferBuffer == current.transferBuffer &&
+           next.transferOffset == current.transferOffset + current.size;
+}
+
+static void RecordBufferUpload(UploadQueue* queue, SDL_GPUCopyPass* copyPass, const BufferUpload& upload) {
+    SDL_GPUTransferBufferLocation source = {
+        .transfer_buffer = upload.transferBuffer,
+        .offset = upload.transferOffset,
+    };
+    SDL_GPUBufferRegion destination = {
+        .buffer = upload.buffer,
+        .offset = upload.offset,
+        .size = upload.size,
+    };
+    SDL_UploadToGPUBuffer(copyPass, &source, &destination, false);
+    queue->stats.frameCopyCommands++;
+}
+
+static void RecordTextureUpload(UploadQueue* queue, SDL_GPUCopyPass* copyPass, const TextureUpload& upload) {
+    SDL_GPUTextureTransferInfo source = {
+        .transfer_buffer = upload.transferBuffer,
+        .offset = upload.transferOffset,
+        .pixels_per_row = upload.region.w,
+        .rows_per_layer = upload.region.h,
+    };
+    SDL_UploadToGPUTexture(copyPass, &source, &upload.region, false);
+    queue->stats.frameCopyCommands++;
+}
+
+void FlushUploads(SDL_GPUDevice* GPUDevice, UploadQueue* queue, SDL_GPUCommandBuffer* commandBuffer) {
+    queue->flushed = true;
+    EndStagingWrites(GPUDevice, queue->ring);
+    if (queue->bufferUploads.empty() && queue->textureUploads.empty()) {
+        return;
+    }
+
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+
+    std::vector<BufferUpload>& bufferUploads = queue->bufferUploads;
+    if (!bufferUploads.empty()) {
+        SortBufferUploads(bufferUploads);
+        BufferUpload current = bufferUploads[0];
+        for (size_t i = 1; i < bufferUploads.size(); ++i) {
+            if (CanMerge(current, bufferUploads[i])) {
+                current.size += bufferUploads[i].size;
+            } else {
+                RecordBufferUpload(queue, copyPass, current);
+                current = bufferUploads[i];
+            }
+        }
+        RecordBufferUpload(queue, copyPass, current);
+    }
+
+    std::vector<TextureUpload>& textureUploads = queue->textureUploads;
+    if (!textureUploads.empty()) {
+        TextureUpload current = textureUploads[0];
+        for (size_t i = 1; i < textureUploads.size(); ++i) {
+            if (CanMerge(current, textureUploads[i])) {
+                current.region.h += textureUploads[i].region.h;
+                current.size += textureUploads[i].size;
+            } else {
+                RecordTextureUpload(queue, copyPass, current);
+                current = textureUploads[i];
+            }
+        }
+        RecordTextureUpload(queue, copyPass, current);
+    }
+
+    SDL_EndGPUCopyPass(copyPass);
+
+    queue->stats.frameCopyPasses++;
+    queue->stats.totalCopyPasses++;
+    queue->stats.totalCopyCommands += queue->stats.frameCopyCommands;
+    bufferUploads.clear();
+    textureUploads.clear();
+}
@@ -0,0 +1,100 @@
+// Turns compiled shaders into a C++ source file with one aligned word array per shader
+// and a name-sorted lookup table (see include/embedded_shaders.hpp).
+//
+// usage: shader_embed <output source> <shader.spv>...
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct ShaderBlob {
+    std::string name;
+    std::vector<uint32_t> words;
+    size_t size;
+};
+
+static std::string ShaderName(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".spv") == 0) {
+        name.resize(name.size() - 4);
+    }
+    return name;
+}
+
+static bool ReadBlob(const char* path, ShaderBlob* blob) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    std::streamsize size = file.tellg();
+    blob->name = ShaderName(path);
+    blob->size = (size_t)size;
+    // At least one word, a zero-length array would not compile
+    blob->words.assign(std::max<size_t>(((size_t)size + 3) / 4, 1), 0);
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(blob->words.data()), size);
+    return (bool)file;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: shader_embed <output source> <shader.spv>...\n");
+        return 1;
+    }
+
+    std::vector<ShaderBlob> blobs;
+    for (int i = 2; i < argc; ++i) {
+        ShaderBlob blob;
+        if (!ReadBlob(argv[i], &blob)) {
+            fprintf(stderr, "shader_embed: cannot read %s\n", argv[i]);
+            return 1;
+        }
+        blobs.push_back(std::move(blob));
+    }
+    std::sort(blobs.begin(), blobs.end(), [](const ShaderBlob& a, const ShaderBlob& b) { return a.name < b.name; });
+    for (size_t i = 1; i < blobs.size(); ++i) {
+        if (blobs[i].name == blobs[i - 1].name) {
+            fprintf(stderr, "shader_embed: %s is given twice\n", blobs[i].name.c_str());
+            return 1;
+        }
+    }
+
+    FILE* output = fopen(argv[1], "wb");
+    if (output == NULL) {
+        fprintf(stderr, "shader_embed: cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(output, "// Generated by shader_embed from the compiled .spv files, do not edit.\n");
+    fprintf(output, "#include \"embedded_shaders.hpp\"\n\n");
+
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        fprintf(output, "alignas(16) static const uint32_t shaderCode%zu[] = {", i);
+        for (size_t w = 0; w < blobs[i].words.size(); ++w) {
+            fprintf(output, "%s0x%08Xu,", w % 8 == 0 ? "\n    " : " ", blobs[i].words[w]);
+        }
+        fprintf(output, "\n};\n\n");
+    }
+
+    fprintf(output, "const EmbeddedShader embeddedShaders[] = {\n");
+    for (size_t i = 0; i < blobs.size(); ++i) {
+        fprintf(
+            output,
+            "    { \"%s\", reinterpret_cast<const uint8_t*>(shaderCode%zu), %zu },\n",
+            blobs[i].name.c_str(),
+            i,
+            blobs[i].size
+        );
+    }
+    // Keeps the array non-empty when there are no shaders; it is past embeddedShaderCount
+    fprintf(output, "    { NULL, NULL, 0 },\n");
+    fprintf(output, "};\n\nconst size_t embeddedShaderCount = %zu;\n", blobs.size());
+
+    bool ok = ferror(output) == 0;
+    ok = fclose(output) == 0 && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,455 @@
+// Build-time SPIR-V reflection: reads compiled shaders and writes a constexpr table of
+// the resource counts, stage and workgroup size SDL_gpu needs at shader creation, plus the
+// member layout of every uniform block so C++ structs can be checked against it.
+//
+// usage: shader_reflect <output header> <shader.spv>...
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#define SPIRV_MAGIC 0x07230203u
+
+enum SpvOp {
+    OP_ENTRY_POINT = 15,
+    OP_EXECUTION_MODE = 16,
+    OP_TYPE_BOOL = 20,
+    OP_TYPE_INT = 21,
+    OP_TYPE_FLOAT = 22,
+    OP_TYPE_VECTOR = 23,
+    OP_TYPE_MATRIX = 24,
+    OP_TYPE_IMAGE = 25,
+    OP_TYPE_SAMPLER = 26,
+    OP_TYPE_SAMPLED_IMAGE = 27,
+    OP_TYPE_ARRAY = 28,
+    OP_TYPE_RUNTIME_ARRAY = 29,
+    OP_TYPE_STRUCT = 30,
+    OP_TYPE_POINTER = 32,
+    OP_CONSTANT = 43,
+    OP_VARIABLE = 59,
+    OP_DECORATE = 71,
+    OP_MEMBER_DECORATE = 72,
+    OP_EXECUTION_MODE_ID = 331,
+};
+
+enum SpvExecutionModel {
+    MODEL_VERTEX = 0,
+    MODEL_FRAGMENT = 4,
+    MODEL_GLCOMPUTE = 5,
+};
+
+enum SpvStorageClass {
+    STORAGE_UNIFORM_CONSTANT = 0,
+    STORAGE_UNIFORM = 2,
+    STORAGE_STORAGE_BUFFER = 12,
+};
+
+#define DECORATION_ROW_MAJOR 4
+#define DECORATION_ARRAY_STRIDE 6
+#define DECORATION_MATRIX_STRIDE 7
+#define DECORATION_BLOCK 2
+#define DECORATION_BUFFER_BLOCK 3
+#define DECORATION_BINDING 33
+#define DECORATION_DESCRIPTOR_SET 34
+#define DECORATION_OFFSET 35
+#define EXECUTION_MODE_LOCAL_SIZE 17
+#define EXECUTION_MODE_LOCAL_SIZE_ID 38
+
+struct Type {
+    uint32_t op;
+    std::vector<uint32_t> operands;
+};
+
+struct Decorations {
+    bool block;
+    bool bufferBlock;
+    int binding = -1;
+    int set = -1;
+    uint32_t arrayStride;
+};
+
+struct MemberDecorations {
+    uint32_t offset;
+    uint32_t matrixStride;
+    bool rowMajor;
+};
+
+struct UniformMember {
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct UniformBlock {
+    uint32_t slot;
+    uint32_t size;
+    std::vector<UniformMember> members;
+};
+
+struct Reflection {
+    std::string name;
+    int model = -1;
+    uint32_t samplers;
+    uint32_t storageTextures;
+    uint32_t storageBuffers;
+    uint32_t uniformBuffers;
+    uint32_t readWriteStorageTextures;
+    uint32_t readWriteStorageBuffers;
+    uint32_t threadCount[3];
+    std::vector<UniformBlock> uniformBlocks;
+};
+
+enum ResourceKind {
+    RESOURCE_NONE,
+    RESOURCE_SAMPLER,
+    RESOURCE_STORAGE_TEXTURE,
+    RESOURCE_STORAGE_BUFFER,
+    RESOURCE_UNIFORM_BUFFER,
+};
+
+static bool ReadWords(const char* path, std::vector<uint32_t>* words) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    std::streamsize size = file.tellg();
+    if (size < 20 || size % 4 != 0) {
+        return false;
+    }
+    words->resize((size_t)size / 4);
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(words->data()), size);
+    return (bool)file && (*words)[0] == SPIRV_MAGIC;
+}
+
+static std::string ShaderName(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".spv") == 0) {
+        name.resize(name.size() - 4);
+    }
+    return name;
+}
+
+struct Module {
+    std::map<uint32_t, Type> types;
+    std::map<uint32_t, uint32_t> constants;
+    std::map<uint32_t, Decorations> decorations;
+    std::map<uint32_t, std::map<uint32_t, MemberDecorations>> memberDecorations;
+};
+
+// Bytes a value of typeId occupies in a block, up to the end of its last component (the
+// trailing padding of arrays and matrices is not part of it, which is how HLSL packs too).
+static uint32_t TypeSize(Module& module, uint32_t typeId, const MemberDecorations* member) {
+    if (!module.types.count(typeId)) {
+        return 0;
+    }
+    const Type& type = module.types[typeId];
+    switch (type.op) {
+    case OP_TYPE_BOOL:
+        return 4;
+    case OP_TYPE_INT:
+    case OP_TYPE_FLOAT:
+        return type.operands[0] / 8;
+    case OP_TYPE_VECTOR:
+        return type.operands[1] * TypeSize(module, type.operands[0], NULL);
+    case OP_TYPE_MATRIX: {
+        uint32_t columns = type.operands[1];
+        const Type& column = module.types[type.operands[0]];
+        uint32_t rows = column.operands[1];
+        uint32_t scalar = TypeSize(module, column.operands[0], NULL);
+        uint32_t stride = member != NULL ? member->matrixStride : 0;
+        if (member != NULL && member->rowMajor) {
+            return (rows - 1) * stride + columns * scalar;
+        }
+        return (columns - 1) * stride + rows * scalar;
+    }
+    case OP_TYPE_ARRAY: {
+        uint32_t length = module.constants.count(type.operands[1]) ? module.constants[type.operands[1]] : 1;
+        uint32_t stride = module.decorations[typeId].arrayStride;
+        return (length - 1) * stride + TypeSize(module, type.operands[0], member);
+    }
+    case OP_TYPE_STRUCT: {
+        uint32_t size = 0;
+        for (uint32_t i = 0; i < type.operands.size(); ++i) {
+            const MemberDecorations& decorations = module.memberDecorations[typeId][i];
+            size = std::max(size, decorations.offset + TypeSize(module, type.operands[i], &decorations));
+        }
+        return size;
+    }
+    }
+    return 0;
+}
+
+static UniformBlock ReflectUniformBlock(Module& module, uint32_t structId, int binding) {
+    UniformBlock block = {};
+    block.slot = binding < 0 ? 0 : (uint32_t)binding;
+    const Type& type = module.types[structId];
+    for (uint32_t i = 0; i < type.operands.size(); ++i) {
+        const MemberDecorations& decorations = module.memberDecorations[structId][i];
+        UniformMember member = { decorations.offset, TypeSize(module, type.operands[i], &decorations) };
+        block.members.push_back(member);
+        block.size = std::max(block.size, member.offset + member.size);
+    }
+    return block;
+}
+
+static bool Reflect(const char* path, Reflection* out) {
+    std::vector<uint32_t> words;
+    if (!ReadWords(path, &words)) {
+        fprintf(stderr, "shader_reflect: %s is not a SPIR-V module\n", path);
+        return false;
+    }
+
+    Module module;
+    std::map<uint32_t, Type>& types = module.types;
+    std::map<uint32_t, uint32_t>& constants = module.constants;
+    std::map<uint32_t, Decorations>& decorations = module.decorations;
+    std::vector<std::pair<uint32_t, uint32_t>> variables; // (pointer type, id)
+    uint32_t localSizeIds[3] = {};
+    bool localSizeFromIds = false;
+
+    *out = {};
+    out->name = ShaderName(path);
+    out->threadCount[0] = out->threadCount[1] = out->threadCount[2] = 1;
+
+    for (size_t i = 5; i < words.size();) {
+        uint32_t op = words[i] & 0xFFFF;
+        uint32_t count = words[i] >> 16;
+        if (count == 0 || i + count > words.size()) {
+            fprintf(stderr, "shader_reflect: %s is truncated\n", path);
+            return false;
+        }
+        const uint32_t* args = &words[i + 1];
+
+        switch (op) {
+        case OP_ENTRY_POINT:
+            if (out->model < 0) {
+                out->model = (int)args[0];
+            }
+            break;
+        case OP_EXECUTION_MODE:
+        case OP_EXECUTION_MODE_ID:
+            if (args[1] == EXECUTION_MODE_LOCAL_SIZE && count >= 6) {
+                out->threadCount[0] = args[2];
+                out->threadCount[1] = args[3];
+                out->threadCount[2] = args[4];
+            } else if (args[1] == EXECUTION_MODE_LOCAL_SIZE_ID && count >= 6) {
+                localSizeIds[0] = args[2];
+                localSizeIds[1] = args[3];
+                localSizeIds[2] = args[4];
+                localSizeFromIds = true;
+            }
+            break;
+        case OP_TYPE_BOOL:
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+        case OP_TYPE_VECTOR:
+        case OP_TYPE_MATRIX:
+        case OP_TYPE_IMAGE:
+        case OP_TYPE_SAMPLER:
+        case OP_TYPE_SAMPLED_IMAGE:
+        case OP_TYPE_ARRAY:
+        case OP_TYPE_RUNTIME_ARRAY:
+        case OP_TYPE_STRUCT:
+        case OP_TYPE_POINTER:
+            types[args[0]] = { op, std::vector<uint32_t>(args + 1, args + count - 1) };
+            break;
+        case OP_CONSTANT:
+            constants[args[1]] = args[2];
+            break;
+        case OP_VARIABLE:
+            variables.push_back({ args[0], args[1] });
+            break;
+        case OP_DECORATE: {
+            Decorations& d = decorations[args[0]];
+            if (args[1] == DECORATION_BLOCK) d.block = true;
+            if (args[1] == DECORATION_BUFFER_BLOCK) d.bufferBlock = true;
+            if (args[1] == DECORATION_BINDING) d.binding = (int)args[2];
+            if (args[1] == DECORATION_DESCRIPTOR_SET) d.set = (int)args[2];
+            if (args[1] == DECORATION_ARRAY_STRIDE) d.arrayStride = args[2];
+            break;
+        }
+        case OP_MEMBER_DECORATE: {
+            MemberDecorations& d = module.memberDecorations[args[0]][args[1]];
+            if (args[2] == DECORATION_OFFSET) d.offset = args[3];
+            if (args[2] == DECORATION_MATRIX_STRIDE) d.matrixStride = args[3];
+            if (args[2] == DECORATION_ROW_MAJOR) d.rowMajor = true;
+            break;
+        }
+        }
+        i += count;
+    }
+
+    if (localSizeFromIds) {
+        for (int axis = 0; axis < 3; ++axis) {
+            out->threadCount[axis] = constants.count(localSizeIds[axis]) ? constants[localSizeIds[axis]] : 1;
+        }
+    }
+
+    if (out->model != MODEL_VERTEX && out->model != MODEL_FRAGMENT && out->model != MODEL_GLCOMPUTE) {
+        fprintf(stderr, "shader_reflect: %s has no vertex, fragment or compute entry point\n", path);
+        return false;
+    }
+
+    // HLSL emits a texture and its SamplerState as two variables on the same binding,
+    // SDL counts the pair once, so samplers are counted per (set, binding).
+    std::set<std::pair<int, int>> samplerBindings;
+
+    for (auto [pointerType, id] : variables) {
+        auto pointer = types.find(pointerType);
+        if (pointer == types.end() || pointer->second.op != OP_TYPE_POINTER) {
+            continue;
+        }
+        uint32_t storageClass = pointer->second.operands[0];
+        uint32_t typeId = pointer->second.operands[1];
+
+        uint32_t arraySize = 1;
+        while (types.count(typeId) && (types[typeId].op == OP_TYPE_ARRAY || types[typeId].op == OP_TYPE_RUNTIME_ARRAY)) {
+            const Type& array = types[typeId];
+            if (array.op == OP_TYPE_ARRAY && constants.count(array.operands[1])) {
+                arraySize *= constants[array.operands[1]];
+            }
+            typeId = array.operands[0];
+        }
+        if (!types.count(typeId)) {
+            continue;
+        }
+        const Type& type = types[typeId];
+        const Decorations& typeDecorations = decorations[typeId];
+        const Decorations& variableDecorations = decorations[id];
+
+        ResourceKind kind = RESOURCE_NONE;
+        if (storageClass == STORAGE_UNIFORM_CONSTANT) {
+            if (type.op == OP_TYPE_SAMPLED_IMAGE || type.op == OP_TYPE_SAMPLER) {
+                kind = RESOURCE_SAMPLER;
+            } else if (type.op == OP_TYPE_IMAGE) {
+                // operand 5 is "Sampled": 1 = used with a sampler, 2 = storage image
+                kind = type.operands[5] == 2 ? RESOURCE_STORAGE_TEXTURE : RESOURCE_SAMPLER;
+            }
+        } else if (storageClass == STORAGE_UNIFORM && type.op == OP_TYPE_STRUCT) {
+            kind = typeDecorations.bufferBlock ? RESOURCE_STORAGE_BUFFER : RESOURCE_UNIFORM_BUFFER;
+        } else if (storageClass == STORAGE_STORAGE_BUFFER) {
+            kind = RESOURCE_STORAGE_BUFFER;
+        }
+
+        // SDL's compute layout: set 0 is read-only resources, set 1 is read-write
+        bool readWrite = out->model == MODEL_GLCOMPUTE && variableDecorations.set == 1;
+
+        switch (kind) {
+        case RESOURCE_SAMPLER:
+            if (samplerBindings.insert({ variableDecorations.set, variableDecorations.binding }).second) {
+                out->samplers += arraySize;
+            }
+            break;
+        case RESOURCE_STORAGE_TEXTURE:
+            (readWrite ? out->readWriteStorageTextures : out->storageTextures) += arraySize;
+            break;
+        case RESOURCE_STORAGE_BUFFER:
+            (readWrite ? out->readWriteStorageBuffers : out->storageBuffers) += arraySize;
+            break;
+        case RESOURCE_UNIFORM_BUFFER:
+            out->uniformBuffers += arraySize;
+            out->uniformBlocks.push_back(ReflectUniformBlock(module, typeId, variableDecorations.binding));
+            break;
+        case RESOURCE_NONE:
+            break;
+        }
+    }
+
+    return true;
+}
+
+static const char* StageName(int model) {
+    switch (model) {
+    case MODEL_VERTEX: return "SHADER_KIND_VERTEX";
+    case MODEL_FRAGMENT: return "SHADER_KIND_FRAGMENT";
+    default: return "SHADER_KIND_COMPUTE";
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: shader_reflect <output header> <shader.spv>...\n");
+        return 1;
+    }
+
+    std::vector<Reflection> shaders;
+    for (int i = 2; i < argc; ++i) {
+        Reflection reflection;
+        if (!Reflect(argv[i], &reflection)) {
+            return 1;
+        }
+        shaders.push_back(reflection);
+    }
+
+    std::string text =
+        "// Generated by shader_reflect from the compiled .spv files, do not edit.\n"
+        "#pragma once\n\n"
+        "inline constexpr ShaderMetadata shaderMetadataTable[] = {\n";
+    for (const Reflection& shader : shaders) {
+        char line[512];
+        snprintf(
+            line,
+            sizeof(line),
+            "    { \"%s\", %s, %u, %u, %u, %u, %u, %u, { %u, %u, %u } },\n",
+            shader.name.c_str(),
+            StageName(shader.model),
+            shader.samplers,
+            shader.storageTextures,
+            shader.storageBuffers,
+            shader.uniformBuffers,
+            shader.readWriteStorageTextures,
+            shader.readWriteStorageBuffers,
+            shader.threadCount[0],
+            shader.threadCount[1],
+            shader.threadCount[2]
+        );
+        text += line;
+    }
+    if (shaders.empty()) {
+        text += "    { \"\", SHADER_KIND_VERTEX, 0, 0, 0, 0, 0, 0, { 1, 1, 1 } },\n";
+    }
+    text += "};\n\n";
+
+    // Members of all blocks in one array, each block refers to its run of it
+    std::string members = "inline constexpr UniformMemberMetadata uniformMemberTable[] = {\n";
+    std::string blocks = "inline constexpr UniformBlockMetadata uniformBlockTable[] = {\n";
+    uint32_t memberCount = 0;
+    for (const Reflection& shader : shaders) {
+        for (const UniformBlock& block : shader.uniformBlocks) {
+            char line[512];
+            snprintf(
+                line,
+                sizeof(line),
+                "    { \"%s\", %u, %u, %u, %u },\n",
+                shader.name.c_str(),
+                block.slot,
+                block.size,
+                memberCount,
+                (uint32_t)block.members.size()
+            );
+            blocks += line;
+            for (const UniformMember& member : block.members) {
+                snprintf(line, sizeof(line), "    { %u, %u },\n", member.offset, member.size);
+                members += line;
+                memberCount++;
+            }
+        }
+    }
+    members += "    { 0, 0 },\n};\n\n";
+    blocks += "    { \"\", 0, 0, 0, 0 },\n};\n";
+    text += members + blocks;
+
+    std::ofstream output(argv[1], std::ios::binary | std::ios::trunc);
+    if (!output) {
+        fprintf(stderr, "shader_reflect: cannot write %s\n", argv[1]);
+        return 1;
+    }
+    output << text;
+    return output ? 0 : 1;
+}